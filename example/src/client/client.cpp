@@ -5,20 +5,25 @@
 using namespace gctk;
 
 static Client* client = nullptr;
+static Input::ActionHandle test_action;
 
 GCTK_GAME_API void ClientStartup(const int argc, char** argv) {
 	client = new Client(argc, argv, GCTK_GAME_NAME, { "assets.gpkg" });
 	client->set_background_color(Color::CornflowerBlue());
 
 	Input::CreateAction("test", { "enter", "kp_enter", "space" });
+	test_action = Input::FindAction("test");
 
 	client->init();
 }
+GCTK_GAME_API void ClientBeginFrame() {
+	client->begin_frame();
+}
 GCTK_GAME_API bool ClientUpdate() {
 	client->update();
-	if (Input::ActionPressed("test")) {
+	if (Input::ActionPressed(test_action)) {
 		LogInfo("Test button pressed!");
-	} else if (Input::ActionReleased("test")) {
+	} else if (Input::ActionReleased(test_action)) {
 		LogInfo("Test button released!");
 	}
 	return !client->should_exit();
@@ -26,6 +31,27 @@ GCTK_GAME_API bool ClientUpdate() {
 GCTK_GAME_API void ClientRender() {
 	client->render();
 }
+GCTK_GAME_API double ClientInputRate() {
+	return Input::SampleRate();
+}
+GCTK_GAME_API void ClientInputSample() {
+	Input::Sample();
+}
+GCTK_GAME_API void ClientFrameTiming(FrameTiming* timing) {
+	*timing = Time::GetFrameTiming();
+}
+GCTK_GAME_API void ClientInterpolate(const double alpha) {
+	Time::SetInterpolationAlpha(alpha);
+}
+GCTK_GAME_API void ClientAttachLocal(LocalChannel* channel) {
+	LocalConnection::Attach(channel);
+}
+GCTK_GAME_API void ClientAttachProfiler(ProfilerState* state) {
+	Profiler::Attach(state);
+}
+GCTK_GAME_API void ClientAttachJobs(JobScheduler* scheduler) {
+	Jobs::Attach(scheduler);
+}
 GCTK_GAME_API void ClientShutdown() {
 	delete client;
 }
\ No newline at end of file
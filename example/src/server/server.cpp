@@ -1,11 +1,23 @@
-#include "gctk_server.hpp"
+#include "gctk.hpp"
 #include "gctk_api.hpp"
 
 GCTK_GAME_API void ServerStartup(int argc, char** argv) {
 
 }
 GCTK_GAME_API void ServerHeartbeat() {
-
+	gctk::Server::BeginTick();
+}
+GCTK_GAME_API void ServerFrameTiming(gctk::FrameTiming* timing) {
+	*timing = gctk::Time::GetFrameTiming();
+}
+GCTK_GAME_API void ServerAttachLocal(gctk::LocalChannel* channel) {
+	gctk::LocalConnection::Attach(channel);
+}
+GCTK_GAME_API void ServerAttachProfiler(gctk::ProfilerState* state) {
+	gctk::Profiler::Attach(state);
+}
+GCTK_GAME_API void ServerAttachJobs(gctk::JobScheduler* scheduler) {
+	gctk::Jobs::Attach(scheduler);
 }
 GCTK_GAME_API void ServerShutdown() {
 
@@ -0,0 +1,356 @@
+#include "gctk_animation.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "gctk_asset.hpp"
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_jobs.hpp"
+#include "gctk_math_batch.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_simd.hpp"
+
+namespace gctk {
+	// Below this many instances the update is not worth splitting into jobs
+	static constexpr size_t MinInstancesPerJob = 32;
+
+	static std::unordered_map<std::string, std::weak_ptr<AnimationClip>> s_clips;
+
+	void Pose::resize(const size_t bone_count) {
+		m_uBoneCount = bone_count;
+		m_uStride = (bone_count + 3) & ~static_cast<size_t>(3);
+		m_data.assign(m_uStride * ComponentCount, 0.0f);
+		set_identity();
+	}
+	void Pose::set_identity() {
+		std::fill(m_data.begin(), m_data.end(), 0.0f);
+		std::fill_n(component(RotationW), m_uStride, 1.0f);
+		std::fill_n(component(ScaleX), m_uStride * 3, 1.0f);
+	}
+
+	static QuaternionStream RotationStream(Pose& pose) {
+		return QuaternionStream {
+			{ pose.component(Pose::RotationX), pose.stride() }, { pose.component(Pose::RotationY), pose.stride() },
+			{ pose.component(Pose::RotationZ), pose.stride() }, { pose.component(Pose::RotationW), pose.stride() }
+		};
+	}
+	static ConstQuaternionStream RotationStream(const Pose& pose) {
+		return ConstQuaternionStream {
+			{ pose.component(Pose::RotationX), pose.stride() }, { pose.component(Pose::RotationY), pose.stride() },
+			{ pose.component(Pose::RotationZ), pose.stride() }, { pose.component(Pose::RotationW), pose.stride() }
+		};
+	}
+	// The x, y and z components starting at first
+	static Vector3Stream VectorStream(Pose& pose, const Pose::Component first) {
+		return Vector3Stream {
+			{ pose.component(first), pose.stride() },
+			{ pose.component(static_cast<Pose::Component>(first + 1)), pose.stride() },
+			{ pose.component(static_cast<Pose::Component>(first + 2)), pose.stride() }
+		};
+	}
+	static ConstVector3Stream VectorStream(const Pose& pose, const Pose::Component first) {
+		return ConstVector3Stream {
+			{ pose.component(first), pose.stride() },
+			{ pose.component(static_cast<Pose::Component>(first + 1)), pose.stride() },
+			{ pose.component(static_cast<Pose::Component>(first + 2)), pose.stride() }
+		};
+	}
+
+	void Pose::Blend(const Pose& a, const Pose& b, const float weight, Pose& out) {
+		if (a.m_uStride != b.m_uStride || a.m_uStride != out.m_uStride) {
+			LogErr("Blended poses have to belong to the same skeleton");
+			return;
+		}
+
+		MathBatch::Nlerp(RotationStream(a), RotationStream(b), weight, RotationStream(out));
+		MathBatch::Lerp(VectorStream(a, TranslationX), VectorStream(b, TranslationX), weight, VectorStream(out, TranslationX));
+		MathBatch::Lerp(VectorStream(a, ScaleX), VectorStream(b, ScaleX), weight, VectorStream(out, ScaleX));
+	}
+
+	bool AnimationClip::load(const std::string& path) {
+		const auto asset = Asset::Load(path);
+		if (asset == nullptr) {
+			LogErr("Could not load animation \"{}\": Asset not found", path);
+			return false;
+		}
+		if (asset->type() != AssetType::Animation || asset->size() < sizeof(AnimationFormat::Header)) {
+			LogErr("Could not load animation \"{}\": Asset is not an animation", path);
+			return false;
+		}
+
+		const auto* bytes = static_cast<const uint8_t*>(asset->data());
+		AnimationFormat::Header header;
+		memcpy(&header, bytes, sizeof(header));
+		if (memcmp(header.identifier, AnimationFormat::Identifier, 4) != 0) {
+			LogErr("Could not load animation \"{}\": Invalid identifier", path);
+			return false;
+		}
+		if (header.version != AnimationFormat::Version) {
+			LogErr("Could not load animation \"{}\": Unsupported version {}", path, header.version);
+			return false;
+		}
+		if (header.frame_rate <= 0.0f || header.frame_count == 0) {
+			LogErr("Could not load animation \"{}\": Invalid frame rate or frame count", path);
+			return false;
+		}
+		if (header.bone_data_offset + header.bone_count * sizeof(AnimationFormat::Bone) > asset->size() ||
+			header.track_data_offset + header.bone_count * sizeof(AnimationFormat::Track) > asset->size() ||
+			header.key_data_offset + static_cast<size_t>(header.key_count) * sizeof(AnimationFormat::Key) > asset->size()) {
+			LogErr("Could not load animation \"{}\": Data blocks are out of range", path);
+			return false;
+		}
+
+		Skeleton skeleton;
+		skeleton.parents.resize(header.bone_count);
+		skeleton.inverse_bind_poses.resize(header.bone_count);
+		for (size_t i = 0; i < header.bone_count; ++i) {
+			AnimationFormat::Bone bone;
+			memcpy(&bone, bytes + header.bone_data_offset + i * sizeof(bone), sizeof(bone));
+			if (bone.parent >= static_cast<int32_t>(i)) {
+				LogErr("Could not load animation \"{}\": Bone {} is ordered before its parent", path, i);
+				return false;
+			}
+			skeleton.parents[i] = bone.parent;
+			auto& matrix = skeleton.inverse_bind_poses[i];
+			for (size_t j = 0; j < 16; ++j) {
+				matrix.item(j) = bone.inverse_bind_pose[j];
+			}
+		}
+
+		std::vector<AnimationFormat::Key> keys(header.key_count);
+		memcpy(keys.data(), bytes + header.key_data_offset, keys.size() * sizeof(AnimationFormat::Key));
+		std::vector<AnimationFormat::Track> tracks(header.bone_count);
+		memcpy(tracks.data(), bytes + header.track_data_offset, tracks.size() * sizeof(AnimationFormat::Track));
+		for (size_t i = 0; i < tracks.size(); ++i) {
+			for (size_t c = 0; c < AnimationFormat::ChannelCount; ++c) {
+				if (tracks[i].key_count[c] == 0 || static_cast<uint64_t>(tracks[i].first_key[c]) + tracks[i].key_count[c] > header.key_count) {
+					LogErr("Could not load animation \"{}\": Track of bone {} is invalid", path, i);
+					return false;
+				}
+				// Sampling interpolates between neighbouring keys, equal frames would divide by zero
+				const auto* first = keys.data() + tracks[i].first_key[c];
+				const auto* last = first + tracks[i].key_count[c];
+				if (std::adjacent_find(first, last, [](const AnimationFormat::Key& a, const AnimationFormat::Key& b) { return a.frame >= b.frame; }) != last) {
+					LogErr("Could not load animation \"{}\": Keys of bone {} are not ordered by frame", path, i);
+					return false;
+				}
+			}
+		}
+
+		m_keys = std::move(keys);
+		m_tracks = std::move(tracks);
+		m_skeleton = std::move(skeleton);
+		m_uFrameCount = header.frame_count;
+		m_fFrameRate = header.frame_rate;
+		m_translationOffset = Vector3 { header.translation_offset[0], header.translation_offset[1], header.translation_offset[2] };
+		m_translationScale = Vector3 { header.translation_scale[0], header.translation_scale[1], header.translation_scale[2] };
+		m_scaleOffset = Vector3 { header.scale_offset[0], header.scale_offset[1], header.scale_offset[2] };
+		m_scaleScale = Vector3 { header.scale_scale[0], header.scale_scale[1], header.scale_scale[2] };
+		return true;
+	}
+
+	// Finds the keys around frame and the blend factor between them
+	static float FindKeys(const AnimationFormat::Key* keys, const uint16_t count, const float frame,
+		const AnimationFormat::Key*& from, const AnimationFormat::Key*& to) {
+		const auto* end = keys + count;
+		const auto* next = std::upper_bound(keys, end, frame, [](const float f, const AnimationFormat::Key& key) {
+			return f < static_cast<float>(key.frame);
+		});
+		if (next == keys) {
+			from = to = keys;
+			return 0.0f;
+		}
+		if (next == end) {
+			from = to = end - 1;
+			return 0.0f;
+		}
+		from = next - 1;
+		to = next;
+		return (frame - static_cast<float>(from->frame)) / static_cast<float>(to->frame - from->frame);
+	}
+
+	void AnimationClip::sample(const float time, Pose& out) const {
+		Assert(out.bone_count() == m_skeleton.bone_count(), "Pose does not match the skeleton of the animation");
+
+		const float frame = std::clamp(time * m_fFrameRate, 0.0f, static_cast<float>(m_uFrameCount - 1));
+		constexpr float unorm = 1.0f / 65535.0f;
+		constexpr float snorm = 1.0f / 32767.0f;
+
+		float* rx = out.component(Pose::RotationX);
+		float* ry = out.component(Pose::RotationY);
+		float* rz = out.component(Pose::RotationZ);
+		float* rw = out.component(Pose::RotationW);
+		float* tx = out.component(Pose::TranslationX);
+		float* ty = out.component(Pose::TranslationY);
+		float* tz = out.component(Pose::TranslationZ);
+		float* sx = out.component(Pose::ScaleX);
+		float* sy = out.component(Pose::ScaleY);
+		float* sz = out.component(Pose::ScaleZ);
+
+		const AnimationFormat::Key* from;
+		const AnimationFormat::Key* to;
+		for (size_t i = 0; i < m_tracks.size(); ++i) {
+			const auto& track = m_tracks[i];
+
+			float t = FindKeys(m_keys.data() + track.first_key[AnimationFormat::ChannelRotation],
+				track.key_count[AnimationFormat::ChannelRotation], frame, from, to);
+			float q0[4], q1[4];
+			for (size_t j = 0; j < 3; ++j) {
+				q0[j] = static_cast<float>(static_cast<int16_t>(from->value[j])) * snorm;
+				q1[j] = static_cast<float>(static_cast<int16_t>(to->value[j])) * snorm;
+			}
+			q0[3] = std::sqrt(std::max(0.0f, 1.0f - q0[0] * q0[0] - q0[1] * q0[1] - q0[2] * q0[2]));
+			q1[3] = std::sqrt(std::max(0.0f, 1.0f - q1[0] * q1[0] - q1[1] * q1[1] - q1[2] * q1[2]));
+			// Both keys have a positive w, but they can still be on opposite hemispheres
+			const float sign = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3] < 0.0f ? -1.0f : 1.0f;
+			float q[4];
+			for (size_t j = 0; j < 4; ++j) {
+				q[j] = q0[j] + (q1[j] * sign - q0[j]) * t;
+			}
+			const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			rx[i] = q[0] / length;
+			ry[i] = q[1] / length;
+			rz[i] = q[2] / length;
+			rw[i] = q[3] / length;
+
+			t = FindKeys(m_keys.data() + track.first_key[AnimationFormat::ChannelTranslation],
+				track.key_count[AnimationFormat::ChannelTranslation], frame, from, to);
+			tx[i] = m_translationOffset.x + Math::Lerp<float>(from->value[0], to->value[0], t) * unorm * m_translationScale.x;
+			ty[i] = m_translationOffset.y + Math::Lerp<float>(from->value[1], to->value[1], t) * unorm * m_translationScale.y;
+			tz[i] = m_translationOffset.z + Math::Lerp<float>(from->value[2], to->value[2], t) * unorm * m_translationScale.z;
+
+			t = FindKeys(m_keys.data() + track.first_key[AnimationFormat::ChannelScale],
+				track.key_count[AnimationFormat::ChannelScale], frame, from, to);
+			sx[i] = m_scaleOffset.x + Math::Lerp<float>(from->value[0], to->value[0], t) * unorm * m_scaleScale.x;
+			sy[i] = m_scaleOffset.y + Math::Lerp<float>(from->value[1], to->value[1], t) * unorm * m_scaleScale.y;
+			sz[i] = m_scaleOffset.z + Math::Lerp<float>(from->value[2], to->value[2], t) * unorm * m_scaleScale.z;
+		}
+	}
+
+	AnimationClipRef AnimationClip::Load(const std::string& path) {
+		if (const auto it = s_clips.find(path); it != s_clips.end()) {
+			if (auto clip = it->second.lock(); clip != nullptr) {
+				return clip;
+			}
+		}
+
+		auto clip = MakePooled<AnimationClip>();
+		if (!clip->load(path)) {
+			return nullptr;
+		}
+		s_clips[path] = clip;
+		return clip;
+	}
+
+	void AnimationPlayback::advance(const float delta_time) {
+		if (clip == nullptr) {
+			return;
+		}
+		time += delta_time * speed;
+		const float duration = clip->duration();
+		if (loop && duration > 0.0f) {
+			time = std::fmod(time, duration);
+			if (time < 0.0f) {
+				time += duration;
+			}
+		} else {
+			time = std::clamp(time, 0.0f, duration);
+		}
+	}
+
+	// Rows of the local TRS matrices in the Matrix4 layout, 4 bones at a time
+	static void BuildLocalMatrices(const Pose& pose, Matrix4* out) {
+		alignas(16) float rows[12][4];
+		for (size_t i = 0; i < pose.stride(); i += 4) {
+			const Simd::Float4 x = Simd::Load(pose.component(Pose::RotationX) + i);
+			const Simd::Float4 y = Simd::Load(pose.component(Pose::RotationY) + i);
+			const Simd::Float4 z = Simd::Load(pose.component(Pose::RotationZ) + i);
+			const Simd::Float4 w = Simd::Load(pose.component(Pose::RotationW) + i);
+			const Simd::Float4 sx = Simd::Load(pose.component(Pose::ScaleX) + i);
+			const Simd::Float4 sy = Simd::Load(pose.component(Pose::ScaleY) + i);
+			const Simd::Float4 sz = Simd::Load(pose.component(Pose::ScaleZ) + i);
+			const Simd::Float4 one = Simd::Splat(1.0f), two = Simd::Splat(2.0f);
+
+			const Simd::Float4 xx = x * x, yy = y * y, zz = z * z;
+			const Simd::Float4 xy = x * y, xz = x * z, yz = y * z;
+			const Simd::Float4 xw = x * w, yw = y * w, zw = z * w;
+
+			Simd::Store(rows[0], (one - two * (yy + zz)) * sx);
+			Simd::Store(rows[1], two * (xy - zw) * sy);
+			Simd::Store(rows[2], two * (xz + yw) * sz);
+			Simd::Store(rows[3], Simd::Load(pose.component(Pose::TranslationX) + i));
+			Simd::Store(rows[4], two * (xy + zw) * sx);
+			Simd::Store(rows[5], (one - two * (xx + zz)) * sy);
+			Simd::Store(rows[6], two * (yz - xw) * sz);
+			Simd::Store(rows[7], Simd::Load(pose.component(Pose::TranslationY) + i));
+			Simd::Store(rows[8], two * (xz - yw) * sx);
+			Simd::Store(rows[9], two * (yz + xw) * sy);
+			Simd::Store(rows[10], (one - two * (xx + yy)) * sz);
+			Simd::Store(rows[11], Simd::Load(pose.component(Pose::TranslationZ) + i));
+
+			const size_t count = std::min<size_t>(4, pose.bone_count() - i);
+			for (size_t lane = 0; lane < count; ++lane) {
+				out[i + lane] = Matrix4 {
+					Vector4 { rows[0][lane], rows[1][lane], rows[2][lane], rows[3][lane] },
+					Vector4 { rows[4][lane], rows[5][lane], rows[6][lane], rows[7][lane] },
+					Vector4 { rows[8][lane], rows[9][lane], rows[10][lane], rows[11][lane] },
+					Vector4::UNIT_W
+				};
+			}
+		}
+	}
+
+	void Animation::ComputeSkinning(const Skeleton& skeleton, const Pose& pose, Matrix4* out) {
+		thread_local std::vector<Matrix4> model;
+		model.resize(pose.stride());
+		BuildLocalMatrices(pose, model.data());
+
+		for (size_t i = 0; i < skeleton.bone_count(); ++i) {
+			if (const auto parent = skeleton.parents[i]; parent >= 0) {
+				model[i] = model[parent] * model[i];
+			}
+			out[i] = model[i] * skeleton.inverse_bind_poses[i];
+		}
+	}
+
+	static void UpdateRange(const std::span<AnimationInstance> instances, const float delta_time, const std::span<Matrix4> skinning) {
+		thread_local Pose base;
+		thread_local Pose target;
+
+		for (auto& instance : instances) {
+			if (instance.skeleton == nullptr || instance.base.clip == nullptr) {
+				continue;
+			}
+			const auto bone_count = instance.skeleton->bone_count();
+			if (instance.skinning_offset + bone_count > skinning.size()) {
+				LogErr("Skinning buffer is too small for the animation instances");
+				continue;
+			}
+
+			if (base.bone_count() != bone_count) {
+				base.resize(bone_count);
+			}
+			instance.base.advance(delta_time);
+			instance.base.clip->sample(instance.base.time, base);
+
+			if (instance.blend_target.clip != nullptr && instance.blend_weight > 0.0f) {
+				if (target.bone_count() != bone_count) {
+					target.resize(bone_count);
+				}
+				instance.blend_target.advance(delta_time);
+				instance.blend_target.clip->sample(instance.blend_target.time, target);
+				Pose::Blend(base, target, instance.blend_weight, base);
+			}
+
+			Animation::ComputeSkinning(*instance.skeleton, base, skinning.data() + instance.skinning_offset);
+		}
+	}
+
+	void Animation::Update(const std::span<AnimationInstance> instances, const float delta_time, const std::span<Matrix4> skinning) {
+		Jobs::ParallelFor(instances.size(), MinInstancesPerJob, [&](const size_t begin, const size_t end) {
+			UpdateRange(instances.subspan(begin, end - begin), delta_time, skinning);
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "gctk_math.hpp"
+#include "gctk_animation_format.hpp"
+
+namespace gctk {
+	struct Skeleton {
+		std::vector<int32_t> parents;
+		std::vector<Matrix4> inverse_bind_poses;
+
+		[[nodiscard]] size_t bone_count() const { return parents.size(); }
+	};
+
+	// Local bone transforms stored as one array per component, padded to a multiple of 4 bones
+	// so that blending and matrix building process 4 bones per SIMD instruction
+	class Pose {
+		std::vector<float> m_data;
+		size_t m_uBoneCount;
+		size_t m_uStride;
+	public:
+		enum Component {
+			RotationX, RotationY, RotationZ, RotationW,
+			TranslationX, TranslationY, TranslationZ,
+			ScaleX, ScaleY, ScaleZ,
+			ComponentCount
+		};
+
+		Pose() : m_uBoneCount(0), m_uStride(0) { }
+		explicit Pose(const size_t bone_count) : Pose() { resize(bone_count); }
+
+		void resize(size_t bone_count);
+		void set_identity();
+
+		[[nodiscard]] constexpr size_t bone_count() const { return m_uBoneCount; }
+		[[nodiscard]] constexpr size_t stride() const { return m_uStride; }
+		[[nodiscard]] inline float* component(const Component component) { return m_data.data() + component * m_uStride; }
+		[[nodiscard]] inline const float* component(const Component component) const { return m_data.data() + component * m_uStride; }
+
+		// Linear blend of translation and scale, normalized lerp of rotation along the shortest arc
+		static void Blend(const Pose& a, const Pose& b, float weight, Pose& out);
+	};
+
+	class AnimationClip;
+	using AnimationClipRef = std::shared_ptr<AnimationClip>;
+
+	class AnimationClip {
+		Skeleton m_skeleton;
+		std::vector<AnimationFormat::Track> m_tracks;
+		std::vector<AnimationFormat::Key> m_keys;
+		uint32_t m_uFrameCount;
+		float m_fFrameRate;
+		Vector3 m_translationOffset;
+		Vector3 m_translationScale;
+		Vector3 m_scaleOffset;
+		Vector3 m_scaleScale;
+	public:
+		AnimationClip() : m_uFrameCount(0), m_fFrameRate(0.0f) { }
+
+		[[nodiscard]] bool load(const std::string& path);
+		// Writes the local transforms at time (in seconds, clamped to the clip) into out, which has to match the skeleton
+		void sample(float time, Pose& out) const;
+
+		[[nodiscard]] constexpr const Skeleton& skeleton() const { return m_skeleton; }
+		[[nodiscard]] constexpr float frame_rate() const { return m_fFrameRate; }
+		[[nodiscard]] constexpr float duration() const {
+			return m_uFrameCount > 1 ? static_cast<float>(m_uFrameCount - 1) / m_fFrameRate : 0.0f;
+		}
+
+		// Loaded clips are shared by asset path
+		static AnimationClipRef Load(const std::string& path);
+	};
+
+	struct AnimationPlayback {
+		const AnimationClip* clip = nullptr;
+		float time = 0.0f;
+		float speed = 1.0f;
+		bool loop = true;
+
+		void advance(float delta_time);
+	};
+
+	// Plays base, crossfaded towards blend_target by blend_weight, and writes the skinning matrices
+	// to skinning_offset in the shared skinning buffer
+	struct AnimationInstance {
+		const Skeleton* skeleton = nullptr;
+		AnimationPlayback base;
+		AnimationPlayback blend_target;
+		float blend_weight = 0.0f;
+		uint32_t skinning_offset = 0;
+	};
+
+	namespace Animation {
+		// Multiplies the pose through the hierarchy and with the inverse bind poses, out needs skeleton.bone_count() entries.
+		// The matrices use the Matrix4 layout, so they have to be uploaded transposed.
+		void ComputeSkinning(const Skeleton& skeleton, const Pose& pose, Matrix4* out);
+		// Advances, samples and blends every instance, split into jobs for long lists
+		void Update(std::span<AnimationInstance> instances, float delta_time, std::span<Matrix4> skinning);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of .gani animation clips. Every bone has a rotation, translation and scale track whose keys
+// are quantized to 8 bytes; keys only exist where the curve can not be interpolated from its neighbours.
+namespace gctk::AnimationFormat {
+	static constexpr uint8_t Identifier[4] = { 'G', 'A', 'N', 'I' };
+	static constexpr uint16_t Version = 1;
+
+	enum Channel : uint32_t {
+		ChannelRotation,
+		ChannelTranslation,
+		ChannelScale,
+		ChannelCount
+	};
+
+	struct Header {
+		uint8_t identifier[4];
+		uint16_t version;
+		uint16_t bone_count;
+		uint32_t frame_count;
+		float frame_rate;
+
+		// Translation and scale keys are unorm16 inside these ranges: value = offset + key * scale
+		float translation_offset[3];
+		float translation_scale[3];
+		float scale_offset[3];
+		float scale_scale[3];
+
+		uint32_t bone_data_offset;
+		uint32_t track_data_offset;
+		uint32_t key_data_offset;
+		uint32_t key_count;
+	};
+	static_assert(sizeof(Header) == 80);
+
+	// Bones are ordered so that parents always come before their children
+	struct Bone {
+		int32_t parent;
+		float inverse_bind_pose[16];
+	};
+	static_assert(sizeof(Bone) == 68);
+
+	struct Track {
+		uint32_t first_key[ChannelCount];
+		uint16_t key_count[ChannelCount];
+		uint16_t reserved;
+	};
+	static_assert(sizeof(Track) == 20);
+
+	// Rotation keys store x, y, z as snorm16 of a quaternion with a positive w
+	struct Key {
+		uint16_t frame;
+		uint16_t value[3];
+	};
+	static_assert(sizeof(Key) == 8);
+}
\ No newline at end of file
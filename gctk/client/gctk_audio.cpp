@@ -0,0 +1,463 @@
+#include "gctk_audio.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_simd.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static constexpr uint8_t SOUND_IDENTIFIER[4] = { 'G', 'S', 'N', 'D' };
+	static constexpr uint16_t SOUND_VERSION = 1;
+	static constexpr size_t SOUND_HEADER_SIZE = 16;
+
+	CVar snd_backend("snd_backend", "null", CVAR_FLAG_USER_DATA);
+	CVar snd_wav_path("snd_wav_path", "audio_output.wav", CVAR_FLAG_USER_DATA);
+	CVar snd_rate("snd_rate", "48000", CVAR_FLAG_USER_DATA);
+	CVar snd_voices("snd_voices", "256", CVAR_FLAG_USER_DATA);
+	CVar snd_volume("snd_volume", "1.0", CVAR_FLAG_USER_DATA);
+	CVar snd_stream_threshold("snd_stream_threshold", "5.0", CVAR_FLAG_USER_DATA);
+
+	static std::unordered_map<std::string, std::weak_ptr<Sound>> s_sounds;
+
+	// Interleaved signed 16 bit samples to floats
+	static void DecodePcm(const int16_t* source, const size_t count, float* out) {
+		const auto scale = Simd::Splat(1.0f / 32768.0f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			Simd::Store(out + i, Simd::LoadInt16(source + i) * scale);
+		}
+		for (; i < count; ++i) {
+			out[i] = static_cast<float>(source[i]) * (1.0f / 32768.0f);
+		}
+	}
+
+	bool Sound::load(const std::string& path) {
+		// Only the header is read here, streamed sounds never load their samples as a whole
+		const auto size = Asset::EntrySize(path);
+		if (size == 0) {
+			LogErr("Could not load sound \"{}\": Asset not found", path);
+			return false;
+		}
+		uint8_t header[SOUND_HEADER_SIZE];
+		if (size < SOUND_HEADER_SIZE || !Asset::ReadRange(path, 0, SOUND_HEADER_SIZE, header)) {
+			LogErr("Could not load sound \"{}\": Asset is not a sound", path);
+			return false;
+		}
+
+		if (memcmp(header, SOUND_IDENTIFIER, 4) != 0) {
+			LogErr("Could not load sound \"{}\": Invalid identifier", path);
+			return false;
+		}
+		uint16_t version, channels;
+		uint32_t sample_rate, frame_count;
+		memcpy(&version, header + 4, 2);
+		memcpy(&channels, header + 6, 2);
+		memcpy(&sample_rate, header + 8, 4);
+		memcpy(&frame_count, header + 12, 4);
+		if (version != SOUND_VERSION) {
+			LogErr("Could not load sound \"{}\": Unsupported version {}", path, version);
+			return false;
+		}
+		if (channels < 1 || channels > 2 || sample_rate == 0) {
+			LogErr("Could not load sound \"{}\": Only mono and stereo sounds are supported", path);
+			return false;
+		}
+		if (SOUND_HEADER_SIZE + static_cast<size_t>(frame_count) * channels * sizeof(int16_t) > size) {
+			LogErr("Could not load sound \"{}\": Sample data is truncated", path);
+			return false;
+		}
+
+		m_uChannels = channels;
+		m_uSampleRate = sample_rate;
+		m_uFrameCount = frame_count;
+		m_samples.clear();
+		m_sStreamPath.clear();
+		if (duration() > snd_stream_threshold.get_float()) {
+			m_sStreamPath = path;
+			return true;
+		}
+
+		const auto asset = Asset::Load(path);
+		if (asset == nullptr || asset->type() != AssetType::SoundEffect || asset->size() != size) {
+			LogErr("Could not load sound \"{}\": Asset is not a sound", path);
+			return false;
+		}
+		m_samples.resize(static_cast<size_t>(frame_count) * channels);
+		DecodePcm(reinterpret_cast<const int16_t*>(static_cast<const uint8_t*>(asset->data()) + SOUND_HEADER_SIZE), m_samples.size(), m_samples.data());
+		return true;
+	}
+
+	const float* Sound::frames(const uint32_t frame) const {
+		return m_samples.data() + static_cast<size_t>(frame) * m_uChannels;
+	}
+	float Sound::sample(const uint32_t frame, const uint32_t channel) const {
+		return m_samples[static_cast<size_t>(frame) * m_uChannels + channel];
+	}
+
+	SoundRef Sound::Load(const std::string& path) {
+		if (const auto it = s_sounds.find(path); it != s_sounds.end()) {
+			if (auto sound = it->second.lock(); sound != nullptr) {
+				return sound;
+			}
+		}
+
+		auto sound = MakePooled<Sound>();
+		if (!sound->load(path)) {
+			return nullptr;
+		}
+		s_sounds[path] = sound;
+		return sound;
+	}
+
+	SoundStream::SoundStream(SoundRef sound, const bool loop) : m_pSound(std::move(sound)), m_bLoop(loop) {
+		m_uChunkCount = (m_pSound->frame_count() + ChunkFrames - 1) / ChunkFrames;
+		request(m_chunks[0], 0);
+	}
+
+	SoundStream::Chunk* SoundStream::find(const uint32_t index) {
+		for (auto& chunk : m_chunks) {
+			if (chunk.index == index) {
+				return &chunk;
+			}
+		}
+		return nullptr;
+	}
+	SoundStream::Chunk& SoundStream::free_slot(const uint32_t index) {
+		const uint32_t previous = index > 0 ? index - 1 : (m_bLoop ? m_uChunkCount - 1 : NoChunk);
+		for (auto& chunk : m_chunks) {
+			if (chunk.index == NoChunk || (chunk.index != index && chunk.index != previous)) {
+				return chunk;
+			}
+		}
+		return m_chunks[0];
+	}
+	void SoundStream::request(Chunk& chunk, const uint32_t index) const {
+		const uint32_t first = index * ChunkFrames;
+		const uint32_t count = std::min(ChunkFrames, m_pSound->frame_count() - first);
+		const size_t frame_size = static_cast<size_t>(m_pSound->channels()) * sizeof(int16_t);
+		chunk.pending = Asset::ReadRangeAsync(m_pSound->stream_path(), SOUND_HEADER_SIZE + first * frame_size, count * frame_size);
+		chunk.index = index;
+	}
+
+	const SoundStream::Chunk& SoundStream::chunk(const uint32_t index) {
+		Chunk* current = find(index);
+		if (current != nullptr && !current->pending.valid()) {
+			return *current;
+		}
+		if (current == nullptr) {
+			current = &free_slot(index);
+			request(*current, index);
+		}
+
+		// First use of the chunk, decode it and request the next one
+		const auto bytes = current->pending.get();
+		const uint32_t count = std::min(ChunkFrames, m_pSound->frame_count() - index * ChunkFrames) * m_pSound->channels();
+		current->samples.resize(count);
+		if (bytes.size() == count * sizeof(int16_t)) {
+			DecodePcm(reinterpret_cast<const int16_t*>(bytes.data()), count, current->samples.data());
+		} else {
+			LogErr("Failed to stream sound \"{}\", chunk {} is silent", m_pSound->stream_path(), index);
+			std::ranges::fill(current->samples, 0.0f);
+		}
+		const uint32_t next = index + 1 < m_uChunkCount ? index + 1 : (m_bLoop ? 0 : NoChunk);
+		if (next != NoChunk && find(next) == nullptr) {
+			request(free_slot(index), next);
+		}
+		return *current;
+	}
+
+	const float* SoundStream::frames(const uint32_t frame, uint32_t& count) {
+		const uint32_t index = frame / ChunkFrames;
+		const uint32_t offset = frame - index * ChunkFrames;
+		const auto& current = chunk(index);
+		count = std::min(count, static_cast<uint32_t>(current.samples.size() / m_pSound->channels()) - offset);
+		return current.samples.data() + static_cast<size_t>(offset) * m_pSound->channels();
+	}
+	float SoundStream::sample(const uint32_t frame, const uint32_t channel) {
+		const uint32_t index = frame / ChunkFrames;
+		return chunk(index).samples[static_cast<size_t>(frame - index * ChunkFrames) * m_pSound->channels() + channel];
+	}
+
+	WavAudioBackend::~WavAudioBackend() {
+		close();
+	}
+	bool WavAudioBackend::open(const uint32_t sample_rate, const uint32_t channels) {
+		close();
+		m_pFile = fopen(m_path.string().c_str(), "wb");
+		if (m_pFile == nullptr) {
+			LogErr("Failed to open wave output \"{}\"", m_path);
+			return false;
+		}
+		m_uChannels = channels;
+		m_uDataSize = 0;
+
+		// The chunk sizes are filled in on close
+		const uint16_t format = 1, bits = 16;
+		const uint16_t block_align = static_cast<uint16_t>(channels * sizeof(int16_t));
+		const uint16_t channel_count = static_cast<uint16_t>(channels);
+		const uint32_t byte_rate = sample_rate * block_align;
+		const uint32_t format_size = 16, placeholder = 0;
+		fwrite("RIFF", 1, 4, m_pFile);
+		fwrite(&placeholder, 4, 1, m_pFile);
+		fwrite("WAVEfmt ", 1, 8, m_pFile);
+		fwrite(&format_size, 4, 1, m_pFile);
+		fwrite(&format, 2, 1, m_pFile);
+		fwrite(&channel_count, 2, 1, m_pFile);
+		fwrite(&sample_rate, 4, 1, m_pFile);
+		fwrite(&byte_rate, 4, 1, m_pFile);
+		fwrite(&block_align, 2, 1, m_pFile);
+		fwrite(&bits, 2, 1, m_pFile);
+		fwrite("data", 1, 4, m_pFile);
+		fwrite(&placeholder, 4, 1, m_pFile);
+		return true;
+	}
+	void WavAudioBackend::write(const float* samples, const size_t frames) {
+		if (m_pFile == nullptr) {
+			return;
+		}
+		const size_t count = frames * m_uChannels;
+		m_buffer.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			m_buffer[i] = static_cast<int16_t>(std::lrint(std::clamp(samples[i], -1.0f, 1.0f) * 32767.0f));
+		}
+		fwrite(m_buffer.data(), sizeof(int16_t), count, m_pFile);
+		m_uDataSize += static_cast<uint32_t>(count * sizeof(int16_t));
+	}
+	void WavAudioBackend::close() {
+		if (m_pFile == nullptr) {
+			return;
+		}
+		const uint32_t riff_size = 36 + m_uDataSize;
+		fseek(m_pFile, 4, SEEK_SET);
+		fwrite(&riff_size, 4, 1, m_pFile);
+		fseek(m_pFile, 40, SEEK_SET);
+		fwrite(&m_uDataSize, 4, 1, m_pFile);
+		fclose(m_pFile);
+		m_pFile = nullptr;
+	}
+
+	AudioMixer::AudioMixer(std::unique_ptr<AudioBackend> backend, const uint32_t sample_rate, const size_t max_voices) :
+		m_pBackend(std::move(backend)), m_voices(max_voices), m_mix(BlockFrames * 2), m_resampled(BlockFrames * 2), m_uSampleRate(sample_rate), m_dPendingFrames(0.0) {
+		for (auto& voice : m_voices) {
+			voice.generation = 1;
+			voice.active = false;
+		}
+		if (m_pBackend != nullptr && !m_pBackend->open(sample_rate, 2)) {
+			LogErr("Failed to open the audio backend, audio output is disabled");
+			m_pBackend = nullptr;
+		}
+	}
+	AudioMixer::~AudioMixer() {
+		if (m_pBackend != nullptr) {
+			m_pBackend->close();
+		}
+	}
+
+	std::unique_ptr<AudioMixer> AudioMixer::Create() {
+		std::unique_ptr<AudioBackend> backend;
+		if (const auto name = StringUtil::ToLower(snd_backend.get_string()); name == "wav") {
+			backend = std::make_unique<WavAudioBackend>(Paths::UserDataPath() / snd_wav_path.get_string());
+		} else {
+			if (name != "null") {
+				LogWarn("Unknown audio backend \"{}\", using \"null\"", name);
+			}
+			backend = std::make_unique<NullAudioBackend>();
+		}
+		const auto rate = static_cast<uint32_t>(std::max(snd_rate.get_integer(), 8000));
+		const auto voices = static_cast<size_t>(std::clamp(snd_voices.get_integer(), 1, 0xFFFF));
+		return std::make_unique<AudioMixer>(std::move(backend), rate, voices);
+	}
+
+	// The slot index is in the low 16 bits, the generation of the slot in the high ones
+	AudioMixer::Voice* AudioMixer::find_voice(const VoiceHandle handle) {
+		const size_t index = handle & 0xFFFF;
+		if (index >= m_voices.size()) {
+			return nullptr;
+		}
+		auto& voice = m_voices[index];
+		return voice.active && voice.generation == handle >> 16 ? &voice : nullptr;
+	}
+
+	VoiceHandle AudioMixer::play(const SoundRef& sound, const float volume, const float pan, const bool loop) {
+		if (sound == nullptr || sound->frame_count() == 0) {
+			return INVALID_VOICE;
+		}
+		for (size_t i = 0; i < m_voices.size(); ++i) {
+			auto& voice = m_voices[i];
+			if (voice.active) {
+				continue;
+			}
+			voice.sound = sound;
+			voice.stream = sound->is_streamed() ? std::make_unique<SoundStream>(sound, loop) : nullptr;
+			voice.position = 0.0;
+			voice.step = static_cast<double>(sound->sample_rate()) / m_uSampleRate;
+			voice.volume = volume;
+			voice.pan = std::clamp(pan, -1.0f, 1.0f);
+			voice.loop = loop;
+			voice.active = true;
+			return static_cast<VoiceHandle>(voice.generation) << 16 | static_cast<VoiceHandle>(i);
+		}
+		return INVALID_VOICE;
+	}
+	void AudioMixer::stop(const VoiceHandle handle) {
+		if (auto* voice = find_voice(handle); voice != nullptr) {
+			voice->active = false;
+			voice->sound = nullptr;
+			voice->stream = nullptr;
+			voice->generation = static_cast<uint16_t>(voice->generation + 1 == 0 ? 1 : voice->generation + 1);
+		}
+	}
+	void AudioMixer::stop_all() {
+		for (size_t i = 0; i < m_voices.size(); ++i) {
+			if (m_voices[i].active) {
+				stop(static_cast<VoiceHandle>(m_voices[i].generation) << 16 | static_cast<VoiceHandle>(i));
+			}
+		}
+	}
+	void AudioMixer::set_volume(const VoiceHandle handle, const float volume) {
+		if (auto* voice = find_voice(handle); voice != nullptr) {
+			voice->volume = volume;
+		}
+	}
+	void AudioMixer::set_pan(const VoiceHandle handle, const float pan) {
+		if (auto* voice = find_voice(handle); voice != nullptr) {
+			voice->pan = std::clamp(pan, -1.0f, 1.0f);
+		}
+	}
+	bool AudioMixer::is_playing(const VoiceHandle handle) const {
+		const size_t index = handle & 0xFFFF;
+		return index < m_voices.size() && m_voices[index].active && m_voices[index].generation == handle >> 16;
+	}
+	size_t AudioMixer::active_voices() const {
+		return std::ranges::count_if(m_voices, [](const Voice& voice) { return voice.active; });
+	}
+
+	// Adds frames of a mono or stereo source to the stereo output with per-channel gains, 2 or 4 samples per lane
+	static void Accumulate(float* out, const float* source, const size_t frames, const uint32_t channels, const float left, const float right) {
+		const float gains_array[4] = { left, right, left, right };
+		const auto gains = Simd::Load(gains_array);
+		size_t i = 0;
+		if (channels == 2) {
+			for (; i + 2 <= frames; i += 2) {
+				Simd::Store(out + i * 2, Simd::Load(out + i * 2) + Simd::Load(source + i * 2) * gains);
+			}
+			for (; i < frames; ++i) {
+				out[i * 2] += source[i * 2] * left;
+				out[i * 2 + 1] += source[i * 2 + 1] * right;
+			}
+		} else {
+			for (; i + 2 <= frames; i += 2) {
+				const float duplicated[4] = { source[i], source[i], source[i + 1], source[i + 1] };
+				Simd::Store(out + i * 2, Simd::Load(out + i * 2) + Simd::Load(duplicated) * gains);
+			}
+			for (; i < frames; ++i) {
+				out[i * 2] += source[i] * left;
+				out[i * 2 + 1] += source[i] * right;
+			}
+		}
+	}
+
+	void AudioMixer::mix_voice(Voice& voice, float* out, const size_t frames) {
+		const auto& sound = *voice.sound;
+		const uint32_t frame_count = sound.frame_count();
+		const uint32_t channels = sound.channels();
+
+		// Constant power panning
+		const float angle = (voice.pan + 1.0f) * Math::Pi<float> * 0.25f;
+		const float left = std::cos(angle) * voice.volume;
+		const float right = std::sin(angle) * voice.volume;
+
+		size_t done = 0;
+		while (done < frames && voice.active) {
+			const size_t block = std::min(frames - done, BlockFrames);
+			size_t count;
+
+			if (voice.step == 1.0) {
+				const auto position = static_cast<uint32_t>(voice.position);
+				auto available = static_cast<uint32_t>(std::min<size_t>(block, frame_count - position));
+				const float* source = voice.stream != nullptr ? voice.stream->frames(position, available) : sound.frames(position);
+				count = available;
+				Accumulate(out + done * 2, source, count, channels, left, right);
+				voice.position += static_cast<double>(count);
+			} else {
+				// Linear interpolation into stereo frames, then the same accumulation
+				count = block;
+				for (size_t i = 0; i < block; ++i) {
+					const auto frame = static_cast<uint32_t>(voice.position);
+					if (frame >= frame_count) {
+						count = i;
+						break;
+					}
+					const uint32_t next = frame + 1 < frame_count ? frame + 1 : (voice.loop ? 0 : frame);
+					const auto t = static_cast<float>(voice.position - frame);
+					for (uint32_t c = 0; c < 2; ++c) {
+						const uint32_t channel = std::min(c, channels - 1);
+						const float a = voice.stream != nullptr ? voice.stream->sample(frame, channel) : sound.sample(frame, channel);
+						const float b = voice.stream != nullptr ? voice.stream->sample(next, channel) : sound.sample(next, channel);
+						m_resampled[i * 2 + c] = a + (b - a) * t;
+					}
+					voice.position += voice.step;
+				}
+				Accumulate(out + done * 2, m_resampled.data(), count, 2, left, right);
+			}
+			done += count;
+
+			if (voice.position >= frame_count) {
+				if (voice.loop) {
+					voice.position = std::fmod(voice.position, static_cast<double>(frame_count));
+				} else {
+					voice.active = false;
+					voice.sound = nullptr;
+					voice.stream = nullptr;
+					voice.generation = static_cast<uint16_t>(voice.generation + 1 == 0 ? 1 : voice.generation + 1);
+				}
+			}
+		}
+	}
+
+	void AudioMixer::mix(float* out, const size_t frames) {
+		for (auto& voice : m_voices) {
+			if (voice.active) {
+				mix_voice(voice, out, frames);
+			}
+		}
+	}
+
+	void AudioMixer::render(size_t frames) {
+		const auto volume = Simd::Splat(snd_volume.get_float());
+		const auto low = Simd::Splat(-1.0f), high = Simd::Splat(1.0f);
+
+		while (frames > 0) {
+			const size_t block = std::min(frames, BlockFrames);
+			std::fill_n(m_mix.begin(), block * 2, 0.0f);
+			mix(m_mix.data(), block);
+
+			// Blocks are whole frames, so the sample count is even and a multiple of 4 except for the tail
+			size_t i = 0;
+			for (; i + 4 <= block * 2; i += 4) {
+				Simd::Store(m_mix.data() + i, Simd::Min(Simd::Max(Simd::Load(m_mix.data() + i) * volume, low), high));
+			}
+			for (; i < block * 2; ++i) {
+				m_mix[i] = std::clamp(m_mix[i] * snd_volume.get_float(), -1.0f, 1.0f);
+			}
+
+			if (m_pBackend != nullptr) {
+				m_pBackend->write(m_mix.data(), block);
+			}
+			frames -= block;
+		}
+	}
+
+	void AudioMixer::update(const double delta_time) {
+		m_dPendingFrames += delta_time * m_uSampleRate;
+		const auto frames = static_cast<size_t>(m_dPendingFrames);
+		m_dPendingFrames -= static_cast<double>(frames);
+		render(frames);
+	}
+}
\ No newline at end of file
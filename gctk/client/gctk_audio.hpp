@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gctk_asset.hpp"
+#include "gctk_filesys.hpp"
+
+namespace gctk {
+	class Sound;
+	using SoundRef = std::shared_ptr<Sound>;
+
+	// A .gsnd asset: "GSND", uint16 version, uint16 channel count, uint32 sample rate, uint32 frame count,
+	// followed by interleaved signed 16 bit samples
+	class Sound {
+		std::string m_sStreamPath;
+		std::vector<float> m_samples;
+		uint32_t m_uChannels;
+		uint32_t m_uSampleRate;
+		uint32_t m_uFrameCount;
+	public:
+		Sound() : m_uChannels(0), m_uSampleRate(0), m_uFrameCount(0) { }
+
+		// Short sounds are converted to float up front, ones longer than snd_stream_threshold seconds
+		// are read from the asset pack while they play, see SoundStream
+		[[nodiscard]] bool load(const std::string& path);
+
+		// Interleaved frames starting at frame, only for sounds that are not streamed
+		[[nodiscard]] const float* frames(uint32_t frame) const;
+		[[nodiscard]] float sample(uint32_t frame, uint32_t channel) const;
+
+		[[nodiscard]] constexpr bool is_streamed() const { return !m_sStreamPath.empty(); }
+		[[nodiscard]] constexpr const std::string& stream_path() const { return m_sStreamPath; }
+		[[nodiscard]] constexpr uint32_t channels() const { return m_uChannels; }
+		[[nodiscard]] constexpr uint32_t sample_rate() const { return m_uSampleRate; }
+		[[nodiscard]] constexpr uint32_t frame_count() const { return m_uFrameCount; }
+		[[nodiscard]] constexpr double duration() const {
+			return m_uSampleRate > 0 ? static_cast<double>(m_uFrameCount) / m_uSampleRate : 0.0;
+		}
+
+		// Loaded sounds are shared by asset path
+		static SoundRef Load(const std::string& path);
+	};
+
+	// Reads a streamed sound in chunks on the asset IO thread. The chunk after the one being mixed is requested
+	// as soon as that one is in use, the one before it is kept for interpolating across the boundary.
+	class SoundStream {
+		struct Chunk {
+			std::future<std::vector<uint8_t>> pending;
+			std::vector<float> samples;
+			uint32_t index = NoChunk;
+		};
+		static constexpr uint32_t NoChunk = 0xFFFFFFFF;
+
+		SoundRef m_pSound;
+		Chunk m_chunks[3];
+		uint32_t m_uChunkCount;
+		bool m_bLoop;
+
+		[[nodiscard]] Chunk* find(uint32_t index);
+		// A slot that holds neither index nor the chunk before it
+		[[nodiscard]] Chunk& free_slot(uint32_t index);
+		void request(Chunk& chunk, uint32_t index) const;
+		// Waits for the chunk if its read has not finished yet
+		[[nodiscard]] const Chunk& chunk(uint32_t index);
+	public:
+		static constexpr uint32_t ChunkFrames = 8192;
+
+		SoundStream(SoundRef sound, bool loop);
+
+		// Interleaved frames starting at frame, count is reduced to the frames left in its chunk
+		[[nodiscard]] const float* frames(uint32_t frame, uint32_t& count);
+		[[nodiscard]] float sample(uint32_t frame, uint32_t channel);
+	};
+
+	// Receives the mixed interleaved stereo output
+	class AudioBackend {
+	public:
+		virtual ~AudioBackend() = default;
+
+		[[nodiscard]] virtual bool open(uint32_t sample_rate, uint32_t channels) = 0;
+		virtual void write(const float* samples, size_t frames) = 0;
+		virtual void close() = 0;
+	};
+
+	// Discards the output, for running and benchmarking the mixer headless
+	class NullAudioBackend final : public AudioBackend {
+	public:
+		[[nodiscard]] bool open(uint32_t, uint32_t) override { return true; }
+		void write(const float*, size_t) override { }
+		void close() override { }
+	};
+
+	// Writes the output to a 16 bit PCM wave file
+	class WavAudioBackend final : public AudioBackend {
+		Path m_path;
+		FILE* m_pFile;
+		uint32_t m_uChannels;
+		uint32_t m_uDataSize;
+		std::vector<int16_t> m_buffer;
+	public:
+		explicit WavAudioBackend(Path path) : m_path(std::move(path)), m_pFile(nullptr), m_uChannels(0), m_uDataSize(0) { }
+		~WavAudioBackend() override;
+
+		[[nodiscard]] bool open(uint32_t sample_rate, uint32_t channels) override;
+		void write(const float* samples, size_t frames) override;
+		void close() override;
+	};
+
+	using VoiceHandle = uint32_t;
+	static constexpr VoiceHandle INVALID_VOICE = 0;
+
+	class AudioMixer {
+		struct Voice {
+			SoundRef sound;
+			// Only set for streamed sounds
+			std::unique_ptr<SoundStream> stream;
+			double position;
+			double step;
+			float volume;
+			float pan;
+			uint16_t generation;
+			bool loop;
+			bool active;
+		};
+
+		std::unique_ptr<AudioBackend> m_pBackend;
+		std::vector<Voice> m_voices;
+		std::vector<float> m_mix;
+		std::vector<float> m_resampled;
+		uint32_t m_uSampleRate;
+		double m_dPendingFrames;
+
+		[[nodiscard]] Voice* find_voice(VoiceHandle handle);
+		void mix_voice(Voice& voice, float* out, size_t frames);
+	public:
+		// Size of the blocks handed to the backend
+		static constexpr size_t BlockFrames = 512;
+
+		explicit AudioMixer(std::unique_ptr<AudioBackend> backend, uint32_t sample_rate = 48000, size_t max_voices = 256);
+		virtual ~AudioMixer();
+		AudioMixer(const AudioMixer&) = delete;
+		AudioMixer& operator=(const AudioMixer&) = delete;
+
+		// Returns INVALID_VOICE when all voices are in use
+		VoiceHandle play(const SoundRef& sound, float volume = 1.0f, float pan = 0.0f, bool loop = false);
+		void stop(VoiceHandle handle);
+		void stop_all();
+		void set_volume(VoiceHandle handle, float volume);
+		void set_pan(VoiceHandle handle, float pan);
+		[[nodiscard]] bool is_playing(VoiceHandle handle) const;
+		[[nodiscard]] size_t active_voices() const;
+
+		// Mixes all voices into out as interleaved stereo, adding nothing for silent frames
+		void mix(float* out, size_t frames);
+		// Mixes and writes frames to the backend
+		void render(size_t frames);
+		// Renders the frames that fit into delta_time seconds
+		void update(double delta_time);
+
+		[[nodiscard]] constexpr uint32_t sample_rate() const { return m_uSampleRate; }
+
+		// Creates a mixer with the backend, sample rate and voice count set by the snd_* CVars
+		static std::unique_ptr<AudioMixer> Create();
+	};
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <GL/glew.h>
 
 #include "gctk.hpp"
+#include "gctk_gl_state.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -18,13 +19,18 @@ namespace gctk {
 	CVar vid_fullscreen("vid_fullscreen", "false", CVAR_FLAG_USER_DATA, &UpdateWindowState);
 	CVar vid_monitor("vid_monitor", "-1", CVAR_FLAG_USER_DATA, &UpdateWindowState);
 	CVar vid_vsync("vid_vsync", "false", CVAR_FLAG_USER_DATA, &UpdateSwapInterval);
+	CVar vid_hidden("vid_hidden", "false", CVAR_DEFAULT_FLAGS);
+	CVar vid_render_thread("vid_render_thread", "false", CVAR_FLAG_USER_DATA);
+	CVar vid_gl_stats("vid_gl_stats", "false", CVAR_DEFAULT_FLAGS);
 
 	static Client* s_client_instance = nullptr;
 
 	Client::Client(const int argc, char** argv, const std::string& name,
 			const std::vector<std::string>& asset_packs,
 			const std::optional<Path>& mod_path) :
-		m_pWindow(nullptr), m_bGlfwInitialized(false), m_pIconImage(nullptr), m_sName(name) {
+		m_pWindow(nullptr), m_bGlfwInitialized(false), m_pIconImage(nullptr), m_sName(name),
+		m_pSpriteBatch(nullptr), m_uRecordIndex(0), m_bRenderThread(false), m_bRenderPending(false), m_bRenderStop(false),
+		m_uRenderTasksQueued(0), m_uRenderTasksDone(0), m_bFrameBegun(false) {
 		if (s_client_instance != nullptr) {
 			FatalError("Client already running!");
 		}
@@ -41,6 +47,22 @@ namespace gctk {
 		Console::StoreUserData();
 		Input::SaveInputs();
 		Input::Dispose();
+		m_pAudioMixer = nullptr;
+
+		if (m_tRenderThread.joinable()) {
+			{
+				std::lock_guard lock(m_mRenderMutex);
+				m_bRenderStop = true;
+			}
+			m_cvRenderSignal.notify_all();
+			m_tRenderThread.join();
+			m_bRenderThread = false;
+		}
+		if (m_pSpriteBatch != nullptr) {
+			glfwMakeContextCurrent(m_pWindow);
+			delete m_pSpriteBatch;
+			m_pSpriteBatch = nullptr;
+		}
 
 		glfwSetWindowIcon(m_pWindow, 0, nullptr);
 		glfwSetCursor(m_pWindow, nullptr);
@@ -100,6 +122,7 @@ namespace gctk {
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, vid_hidden.get_boolean() ? GLFW_FALSE : GLFW_TRUE);
 		m_pWindow = glfwCreateWindow(
 			vid_window_width.get_integer(), vid_window_height.get_integer(),
 			m_sName.c_str(), monitor, nullptr
@@ -142,21 +165,163 @@ namespace gctk {
 
 		Input::Initialize(*this);
 		Time::Initialize();
+
+		m_pSpriteBatch = new SpriteBatch();
+		m_pAudioMixer = AudioMixer::Create();
+
+		m_bRenderThread = vid_render_thread.get_boolean();
+		if (m_bRenderThread) {
+			glfwMakeContextCurrent(nullptr);
+			m_tRenderThread = std::thread(&Client::render_thread_main, this);
+		} else if (Input::SampleRate() > 0.0) {
+			// The main thread is kept for input sampling, the game thread takes the context on its first update
+			glfwMakeContextCurrent(nullptr);
+		}
 		LogInfo("Client initialized successfully");
 	}
 
+	void Client::begin_frame() {
+		m_bFrameBegun = true;
+		Profiler::Collect();
+		Memory::BeginFrame();
+		Time::UpdateDeltaTime();
+		if (m_pAudioMixer != nullptr) {
+			m_pAudioMixer->update(Time::DeltaTime());
+		}
+	}
+
 	void Client::update() {
-		glfwPollEvents();
+		GCTK_PROFILE_SCOPE("Client::update");
+		if (!m_bRenderThread && glfwGetCurrentContext() != m_pWindow) {
+			glfwMakeContextCurrent(m_pWindow);
+		}
+		if (!m_bFrameBegun) {
+			begin_frame();
+		}
 		Input::Poll();
 	}
 
 	void Client::render() {
-		glClearColor(m_cBackgroundColor.r, m_cBackgroundColor.g, m_cBackgroundColor.b, m_cBackgroundColor.a);
+		GCTK_PROFILE_SCOPE("Client::render");
+		m_bFrameBegun = false;
+		if (!m_bRenderThread) {
+			render_frame(m_uRecordIndex, m_cBackgroundColor);
+
+			if (Input::SampleRate() > 0.0 && should_exit()) {
+				// Let the main thread destroy the window once the game thread stops
+				glfwMakeContextCurrent(nullptr);
+			}
+			return;
+		}
+
+		// Wait for the previous frame to be submitted, then hand this one over and keep recording into the other list
+		std::unique_lock lock(m_mRenderMutex);
+		m_cvRenderSignal.wait(lock, [this]() { return !m_bRenderPending; });
+		m_cSubmittedColor = m_cBackgroundColor;
+		m_uRecordIndex = 1 - m_uRecordIndex;
+		m_bRenderPending = true;
+		lock.unlock();
+		m_cvRenderSignal.notify_all();
+	}
+	void Client::render_frame(const uint32_t index, const Color& clear_color) {
+		GCTK_PROFILE_SCOPE("Client::render_frame");
+		// Jobs that need the GL context, e.g. uploads prepared on the workers
+		Jobs::RunMainThreadJobs();
+
+		GLState::ClearColor(clear_color);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Render code goes here
+		m_commandLists[index].execute();
+		m_pSpriteBatch->draw(m_sprites[index]);
 
 		glfwSwapBuffers(m_pWindow);
+
+		GLState::EndFrame();
+		if (vid_gl_stats.get_boolean()) {
+			static double last_report = 0.0;
+			if (const auto now = Time::CurrentTime(); now - last_report >= 1.0) {
+				const auto stats = GLState::LastFrameStats();
+				LogInfo("GL state calls: {} issued, {} elided", stats.issued, stats.elided);
+				last_report = now;
+			}
+		}
+
+		m_commandLists[index].clear();
+		m_sprites[index].clear();
+	}
+	void Client::draw_sprite(const Sprite& sprite) {
+		m_sprites[m_uRecordIndex].push_back(sprite);
+	}
+	void Client::render_thread_main() {
+		Profiler::SetThreadName("Render");
+		glfwMakeContextCurrent(m_pWindow);
+
+		std::unique_lock lock(m_mRenderMutex);
+		while (true) {
+			m_cvRenderSignal.wait(lock, [this]() { return m_bRenderPending || m_bRenderStop || !m_renderTasks.empty(); });
+			if (!m_renderTasks.empty()) {
+				run_render_tasks(lock);
+				continue;
+			}
+			if (!m_bRenderPending) {
+				break;
+			}
+
+			const auto index = 1 - m_uRecordIndex;
+			const auto clear_color = m_cSubmittedColor;
+			lock.unlock();
+
+			render_frame(index, clear_color);
+
+			lock.lock();
+			m_bRenderPending = false;
+			m_cvRenderSignal.notify_all();
+		}
+
+		glfwMakeContextCurrent(nullptr);
+	}
+	void Client::run_render_tasks(std::unique_lock<std::mutex>& lock) {
+		std::vector<std::function<void()>> tasks;
+		tasks.swap(m_renderTasks);
+		lock.unlock();
+
+		for (const auto& task : tasks) {
+			task();
+		}
+
+		lock.lock();
+		m_uRenderTasksDone += tasks.size();
+		m_cvRenderSignal.notify_all();
+	}
+	void Client::queue_render_task(std::function<void()> fn, const bool wait) {
+		std::unique_lock lock(m_mRenderMutex);
+		m_renderTasks.push_back(std::move(fn));
+		const uint64_t ticket = ++m_uRenderTasksQueued;
+		m_cvRenderSignal.notify_all();
+		if (wait) {
+			// Tasks run in order, so the counter passing the ticket means this one is done
+			m_cvRenderSignal.wait(lock, [this, ticket]() { return m_uRenderTasksDone >= ticket; });
+		}
+	}
+
+	void GLContext::Run(const std::function<void()>& fn) {
+		if (glfwGetCurrentContext() != nullptr) {
+			fn();
+			return;
+		}
+		AssertFatal(s_client_instance != nullptr && s_client_instance->has_render_thread(), "GL call on a thread without a context");
+		s_client_instance->queue_render_task(fn, true);
+	}
+	void GLContext::Post(std::function<void()> fn) {
+		if (glfwGetCurrentContext() != nullptr) {
+			fn();
+			return;
+		}
+		const bool has_render_thread = s_client_instance != nullptr && s_client_instance->has_render_thread();
+		Assert(has_render_thread, "GL objects released on a thread without a context");
+		if (has_render_thread) {
+			s_client_instance->queue_render_task(std::move(fn), false);
+		}
 	}
 
 	bool Client::should_exit() const {
@@ -381,7 +546,11 @@ namespace gctk {
 		try {
 			const std::string lowercase = StringUtil::ToLower(value);
 			const int i = lowercase == "true" ? 1 : (lowercase == "false" ? 0 : std::stoi(value));
-			glfwSwapInterval(i);
+			if (s_client_instance != nullptr) {
+				s_client_instance->record_render_command([i]() { glfwSwapInterval(i); });
+			} else {
+				glfwSwapInterval(i);
+			}
 			return true;
 		} catch (...) {
 			return false;
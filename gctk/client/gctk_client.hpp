@@ -1,10 +1,18 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "gctk_math.hpp"
 #include "gctk_filesys.hpp"
+#include "gctk_audio.hpp"
+#include "gctk_command_list.hpp"
+#include "gctk_culling.hpp"
+#include "gctk_sprite_batch.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -23,6 +31,31 @@ namespace gctk {
 		GLFWimage* m_pCursorImage;
 		Color m_cBackgroundColor;
 		std::string m_sName;
+
+		// Frame N is replayed from one list while frame N+1 is recorded into the other
+		CommandList m_commandLists[2];
+		std::vector<Sprite> m_sprites[2];
+		SpriteBatch* m_pSpriteBatch;
+		uint32_t m_uRecordIndex;
+		bool m_bRenderThread;
+		std::thread m_tRenderThread;
+		std::mutex m_mRenderMutex;
+		std::condition_variable m_cvRenderSignal;
+		bool m_bRenderPending;
+		bool m_bRenderStop;
+		// GLContext work from other threads, run by the render thread between frames
+		std::vector<std::function<void()>> m_renderTasks;
+		uint64_t m_uRenderTasksQueued;
+		uint64_t m_uRenderTasksDone;
+		// Set by begin_frame, cleared by render
+		bool m_bFrameBegun;
+		Color m_cSubmittedColor;
+		std::unique_ptr<AudioMixer> m_pAudioMixer;
+		CullingStage m_culling;
+
+		void render_frame(uint32_t index, const Color& clear_color);
+		void render_thread_main();
+		void run_render_tasks(std::unique_lock<std::mutex>& lock);
 	public:
 		Client(int argc, char** argv, const std::string& name,
 			const std::vector<std::string>& asset_packs,
@@ -31,10 +64,26 @@ namespace gctk {
 		virtual ~Client();
 
 		void init();
+		// Once per rendered frame before its ticks: frame time, arenas and audio.
+		// update() calls it itself when the first tick of a frame runs without it.
+		void begin_frame();
+		// Once per simulation tick, tick code should use Time::TickDeltaTime()
 		void update();
 		void render();
 		[[nodiscard]] bool should_exit() const;
 
+		// Commands run on the thread owning the GL context when the current frame is rendered
+		template<typename F>
+		void record_render_command(F&& fn) {
+			m_commandLists[m_uRecordIndex].record(std::forward<F>(fn));
+		}
+		[[nodiscard]] constexpr bool has_render_thread() const { return m_bRenderThread; }
+		// Used by GLContext while the render thread owns the context
+		void queue_render_task(std::function<void()> fn, bool wait);
+
+		// Queues a sprite for the current frame, drawn in one sorted batch after the recorded render commands
+		void draw_sprite(const Sprite& sprite);
+
 		void set_window_title(const std::string& title) const;
 		[[nodiscard]] std::string get_window_title() const;
 		void set_window_location(int x, int y) const;
@@ -56,6 +105,9 @@ namespace gctk {
 		[[nodiscard]] CursorMode get_cursor_mode() const;
 
 		[[nodiscard]] constexpr GLFWwindow* get_window() const { return m_pWindow; }
+		[[nodiscard]] AudioMixer* audio() const { return m_pAudioMixer.get(); }
+		// Run before recording the draws of a frame, so only the visible objects are submitted
+		[[nodiscard]] CullingStage& culling() { return m_culling; }
 
 		void set_background_color(const Color& color);
 		[[nodiscard]] Color get_background_color() const;
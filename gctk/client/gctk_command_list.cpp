@@ -0,0 +1,53 @@
+#include "gctk_command_list.hpp"
+
+namespace gctk {
+	CommandList::CommandList() :
+		m_uBlockIndex(0), m_uBlockOffset(0), m_pFirst(nullptr), m_pLast(nullptr), m_uCount(0) {
+	}
+	CommandList::~CommandList() {
+		clear();
+	}
+
+	void CommandList::execute() const {
+		for (const Command* command = m_pFirst; command != nullptr; command = command->next) {
+			command->execute(command->data);
+		}
+	}
+	void CommandList::clear() {
+		for (const Command* command = m_pFirst; command != nullptr; command = command->next) {
+			command->destroy(command->data);
+		}
+		m_pFirst = nullptr;
+		m_pLast = nullptr;
+		m_uCount = 0;
+		m_uBlockIndex = 0;
+		m_uBlockOffset = 0;
+	}
+
+	void* CommandList::allocate(const size_t size, const size_t alignment) {
+		if (m_blocks.empty()) {
+			m_blocks.emplace_back(std::make_unique<Block>());
+		}
+
+		size_t offset = (m_uBlockOffset + alignment - 1) & ~(alignment - 1);
+		if (offset + size > BlockSize) {
+			++m_uBlockIndex;
+			if (m_uBlockIndex == m_blocks.size()) {
+				m_blocks.emplace_back(std::make_unique<Block>());
+			}
+			offset = 0;
+		}
+
+		m_uBlockOffset = offset + size;
+		return m_blocks[m_uBlockIndex]->data + offset;
+	}
+	void CommandList::append(Command* command) {
+		if (m_pLast == nullptr) {
+			m_pFirst = command;
+		} else {
+			m_pLast->next = command;
+		}
+		m_pLast = command;
+		++m_uCount;
+	}
+}
\ No newline at end of file
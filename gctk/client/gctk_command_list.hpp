@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gctk {
+	// Records render commands into reusable memory blocks, so a frame can be built on one thread and replayed on another
+	class CommandList {
+		static constexpr size_t BlockSize = 64 * 1024;
+
+		struct Command {
+			void (*execute)(void* data);
+			void (*destroy)(void* data);
+			void* data;
+			Command* next;
+		};
+		struct Block {
+			alignas(std::max_align_t) std::byte data[BlockSize];
+		};
+
+		std::vector<std::unique_ptr<Block>> m_blocks;
+		size_t m_uBlockIndex;
+		size_t m_uBlockOffset;
+		Command* m_pFirst;
+		Command* m_pLast;
+		size_t m_uCount;
+
+		void* allocate(size_t size, size_t alignment);
+		void append(Command* command);
+	public:
+		CommandList();
+		~CommandList();
+		CommandList(const CommandList&) = delete;
+		CommandList& operator=(const CommandList&) = delete;
+
+		template<typename F>
+		void record(F&& fn) {
+			using Fn = std::decay_t<F>;
+			static_assert(sizeof(Fn) + alignof(Fn) <= BlockSize, "Render command is too large for a command list block");
+
+			auto* command = static_cast<Command*>(allocate(sizeof(Command), alignof(Command)));
+			command->data = new (allocate(sizeof(Fn), alignof(Fn))) Fn(std::forward<F>(fn));
+			command->execute = [](void* data) { (*static_cast<Fn*>(data))(); };
+			command->destroy = [](void* data) { static_cast<Fn*>(data)->~Fn(); };
+			command->next = nullptr;
+			append(command);
+		}
+
+		void execute() const;
+		// Destroys the recorded commands, the memory blocks are kept for the next frame
+		void clear();
+
+		[[nodiscard]] constexpr size_t size() const { return m_uCount; }
+		[[nodiscard]] constexpr bool empty() const { return m_uCount == 0; }
+	};
+}
\ No newline at end of file
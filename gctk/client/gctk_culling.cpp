@@ -0,0 +1,380 @@
+#include "gctk_culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "gctk_cvar.hpp"
+#include "gctk_jobs.hpp"
+#include "gctk_simd.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static bool ValidatePositiveOrZero(const CVar* self, const std::string& value);
+
+	// Upper bound for the threads one cull call is split across, 0 uses all job workers
+	CVar cull_threads("cull_threads", "0", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+
+	// Below this many objects per job the culling stays on the calling thread
+	static constexpr size_t MinCullBatch = 16384;
+	// Vertices with a smaller clip w are treated as crossing the near plane
+	static constexpr float MinClipW = 1e-5f;
+	// Occludees are tested at the pyramid level where their rectangle spans about this many texels
+	static constexpr int32_t OcclusionTestTexels = 4;
+
+	static constexpr int BoxTriangles[36] = {
+		0, 1, 3, 0, 3, 2, // -x
+		4, 6, 7, 4, 7, 5, // +x
+		0, 4, 5, 0, 5, 1, // -y
+		2, 3, 7, 2, 7, 6, // +y
+		0, 2, 6, 0, 6, 4, // -z
+		1, 5, 7, 1, 7, 3  // +z
+	};
+
+	static std::array<Vector3, 8> Corners(const AABB& bounds) {
+		std::array<Vector3, 8> corners;
+		for (int i = 0; i < 8; i++) {
+			corners[i] = Vector3 {
+				i & 4 ? bounds.max.x : bounds.min.x,
+				i & 2 ? bounds.max.y : bounds.min.y,
+				i & 1 ? bounds.max.z : bounds.min.z
+			};
+		}
+		return corners;
+	}
+
+	static Plane NormalizePlane(const Vector4& v) {
+		const float length = Vector3 { v.x, v.y, v.z }.length();
+		return Plane { Vector3 { v.x, v.y, v.z } / length, v.w / length };
+	}
+
+	Frustum Frustum::FromMatrix(const Matrix4& view_projection) {
+		// The columnN members hold the rows of the matrix, the planes are the sums and differences of the last row with the others
+		const Vector4& r0 = view_projection.column0;
+		const Vector4& r1 = view_projection.column1;
+		const Vector4& r2 = view_projection.column2;
+		const Vector4& r3 = view_projection.column3;
+
+		Frustum frustum;
+		frustum.planes[Left]   = NormalizePlane(r3 + r0);
+		frustum.planes[Right]  = NormalizePlane(r3 - r0);
+		frustum.planes[Bottom] = NormalizePlane(r3 + r1);
+		frustum.planes[Top]    = NormalizePlane(r3 - r1);
+		frustum.planes[Near]   = NormalizePlane(r3 + r2);
+		frustum.planes[Far]    = NormalizePlane(r3 - r2);
+		return frustum;
+	}
+
+	bool Frustum::intersects(const Vector3& center, const float radius) const {
+		return std::ranges::all_of(planes, [&](const Plane& plane) { return plane.signed_distance(center) >= -radius; });
+	}
+	bool Frustum::intersects(const AABB& bounds) const {
+		return classify(bounds) != Spatial::Containment::Outside;
+	}
+	Spatial::Containment Frustum::classify(const AABB& bounds) const {
+		const Vector3 center = bounds.center();
+		const Vector3 extents = bounds.extents();
+		auto result = Spatial::Containment::Inside;
+		for (const auto& plane : planes) {
+			const float distance = plane.signed_distance(center);
+			const float radius = std::abs(plane.normal.x) * extents.x + std::abs(plane.normal.y) * extents.y + std::abs(plane.normal.z) * extents.z;
+			if (distance < -radius) {
+				return Spatial::Containment::Outside;
+			}
+			if (distance < radius) {
+				result = Spatial::Containment::Intersecting;
+			}
+		}
+		return result;
+	}
+
+	void OcclusionBuffer::begin(const Matrix4& view_projection, const int32_t width, const int32_t height) {
+		m_viewProjection = view_projection;
+		m_levels.resize(1);
+		m_levels[0].width = std::max(width, 1);
+		m_levels[0].height = std::max(height, 1);
+		m_levels[0].depth.assign(static_cast<size_t>(m_levels[0].width) * m_levels[0].height, 1.0f);
+	}
+
+	// Takes screen space x, y and depth in [0, 1], writes the farthest depth of the triangle wherever it is nearer
+	void OcclusionBuffer::rasterize(const Vector4& a, const Vector4& b, const Vector4& c) {
+		Level& level = m_levels[0];
+		const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (std::abs(area) < 1e-8f) {
+			return;
+		}
+		const float sign = area > 0.0f ? 1.0f : -1.0f;
+		const float depth = std::max({ a.z, b.z, c.z });
+
+		const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(std::min({ a.x, b.x, c.x }))));
+		const int32_t x1 = std::min(level.width - 1, static_cast<int32_t>(std::ceil(std::max({ a.x, b.x, c.x }))));
+		const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(std::min({ a.y, b.y, c.y }))));
+		const int32_t y1 = std::min(level.height - 1, static_cast<int32_t>(std::ceil(std::max({ a.y, b.y, c.y }))));
+
+		const auto edge = [sign](const Vector4& p, const Vector4& q, const float x, const float y) {
+			return sign * ((q.x - p.x) * (y - p.y) - (q.y - p.y) * (x - p.x));
+		};
+		for (int32_t y = y0; y <= y1; y++) {
+			const float py = static_cast<float>(y) + 0.5f;
+			float* row = level.depth.data() + static_cast<size_t>(y) * level.width;
+			for (int32_t x = x0; x <= x1; x++) {
+				const float px = static_cast<float>(x) + 0.5f;
+				if (edge(a, b, px, py) >= 0.0f && edge(b, c, px, py) >= 0.0f && edge(c, a, px, py) >= 0.0f) {
+					row[x] = std::min(row[x], depth);
+				}
+			}
+		}
+	}
+
+	void OcclusionBuffer::add_occluder(const AABB& bounds) {
+		const auto corners = Corners(bounds);
+		std::array<Vector3, 36> triangles;
+		for (size_t i = 0; i < triangles.size(); i++) {
+			triangles[i] = corners[BoxTriangles[i]];
+		}
+		add_occluder(triangles);
+	}
+
+	void OcclusionBuffer::add_occluder(const std::span<const Vector3> triangles) {
+		if (m_levels.empty()) {
+			return;
+		}
+
+		const auto width = static_cast<float>(m_levels[0].width);
+		const auto height = static_cast<float>(m_levels[0].height);
+		for (size_t i = 0; i + 3 <= triangles.size(); i += 3) {
+			Vector4 screen[3];
+			bool clipped = false;
+			for (int v = 0; v < 3 && !clipped; v++) {
+				const Vector4 clip = m_viewProjection.transform(Vector4 { triangles[i + v].x, triangles[i + v].y, triangles[i + v].z, 1.0f });
+				clipped = clip.w < MinClipW;
+				const float inv_w = 1.0f / clip.w;
+				screen[v] = Vector4 {
+					(clip.x * inv_w * 0.5f + 0.5f) * width,
+					(clip.y * inv_w * 0.5f + 0.5f) * height,
+					clip.z * inv_w * 0.5f + 0.5f,
+					1.0f
+				};
+			}
+			if (!clipped) {
+				rasterize(screen[0], screen[1], screen[2]);
+			}
+		}
+	}
+
+	void OcclusionBuffer::finish() {
+		if (m_levels.empty()) {
+			return;
+		}
+
+		m_levels.resize(1);
+		while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+			const Level& source = m_levels.back();
+			Level level { (source.width + 1) / 2, (source.height + 1) / 2, { } };
+			level.depth.resize(static_cast<size_t>(level.width) * level.height);
+			for (int32_t y = 0; y < level.height; y++) {
+				const int32_t sy0 = y * 2, sy1 = std::min(y * 2 + 1, source.height - 1);
+				for (int32_t x = 0; x < level.width; x++) {
+					const int32_t sx0 = x * 2, sx1 = std::min(x * 2 + 1, source.width - 1);
+					level.depth[static_cast<size_t>(y) * level.width + x] = std::max({
+						source.depth[static_cast<size_t>(sy0) * source.width + sx0], source.depth[static_cast<size_t>(sy0) * source.width + sx1],
+						source.depth[static_cast<size_t>(sy1) * source.width + sx0], source.depth[static_cast<size_t>(sy1) * source.width + sx1]
+					});
+				}
+			}
+			m_levels.push_back(std::move(level));
+		}
+	}
+
+	bool OcclusionBuffer::is_visible(const AABB& bounds) const {
+		if (m_levels.empty()) {
+			return true;
+		}
+
+		const auto width = static_cast<float>(m_levels[0].width);
+		const auto height = static_cast<float>(m_levels[0].height);
+		float min_x = width, max_x = 0.0f, min_y = height, max_y = 0.0f, min_depth = 1.0f;
+		for (const auto& corner : Corners(bounds)) {
+			const Vector4 clip = m_viewProjection.transform(Vector4 { corner.x, corner.y, corner.z, 1.0f });
+			if (clip.w < MinClipW) {
+				return true;
+			}
+			const float inv_w = 1.0f / clip.w;
+			const float x = (clip.x * inv_w * 0.5f + 0.5f) * width;
+			const float y = (clip.y * inv_w * 0.5f + 0.5f) * height;
+			min_x = std::min(min_x, x);
+			max_x = std::max(max_x, x);
+			min_y = std::min(min_y, y);
+			max_y = std::max(max_y, y);
+			min_depth = std::min(min_depth, clip.z * inv_w * 0.5f + 0.5f);
+		}
+
+		const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(min_x)));
+		const int32_t x1 = std::min(m_levels[0].width - 1, static_cast<int32_t>(std::floor(max_x)));
+		const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(min_y)));
+		const int32_t y1 = std::min(m_levels[0].height - 1, static_cast<int32_t>(std::floor(max_y)));
+		if (x0 > x1 || y0 > y1) {
+			// Entirely off screen, that is the frustum test's call
+			return true;
+		}
+
+		size_t index = 0;
+		while (index + 1 < m_levels.size() && std::max(x1 - x0, y1 - y0) >> index >= OcclusionTestTexels) {
+			index++;
+		}
+		const Level& level = m_levels[index];
+		for (int32_t y = y0 >> index; y <= y1 >> index; y++) {
+			for (int32_t x = x0 >> index; x <= x1 >> index; x++) {
+				if (level.depth[static_cast<size_t>(y) * level.width + x] >= min_depth) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Runs fn(begin, end, out) over the whole range, every job appends to its own list and the lists are joined in order
+	template<typename Fn>
+	void CullingStage::run(const size_t count, Fn&& fn) {
+		size_t ranges = count > MinCullBatch ? Jobs::SplitCount(count, MinCullBatch) : 1;
+		if (const auto max_threads = cull_threads.get_integer(); max_threads > 0) {
+			ranges = std::min(ranges, static_cast<size_t>(max_threads));
+		}
+
+		m_visible.clear();
+		if (ranges == 1) {
+			fn(0, count, m_visible);
+			return;
+		}
+
+		m_partial.resize(ranges);
+		const size_t chunk = (count + ranges - 1) / ranges;
+		JobCounter counter;
+		for (size_t r = 1; r < ranges && r * chunk < count; r++) {
+			Jobs::Run([&, r] {
+				m_partial[r].clear();
+				fn(r * chunk, std::min(count, (r + 1) * chunk), m_partial[r]);
+			}, &counter);
+		}
+		fn(0, chunk, m_visible);
+		Jobs::Wait(counter);
+		for (size_t r = 1; r < ranges && r * chunk < count; r++) {
+			m_visible.insert(m_visible.end(), m_partial[r].begin(), m_partial[r].end());
+		}
+	}
+
+	std::span<const uint32_t> CullingStage::cull_spheres(
+		const Frustum& frustum, const ConstVector3Stream centers, const std::span<const float> radii, const OcclusionBuffer* occlusion
+	) {
+		run(centers.size(), [&](const size_t begin, const size_t end, std::vector<uint32_t>& out) {
+			const auto accept = [&](const size_t i) {
+				const Vector3 center = { centers.x[i], centers.y[i], centers.z[i] };
+				const Vector3 radius = { radii[i], radii[i], radii[i] };
+				if (occlusion == nullptr || occlusion->is_visible(AABB::FromCenter(center, radius))) {
+					out.push_back(static_cast<uint32_t>(i));
+				}
+			};
+
+			// The smallest of the plane distances plus the radius, negative means outside
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 x = Simd::Load(centers.x.data() + i);
+				const Simd::Float4 y = Simd::Load(centers.y.data() + i);
+				const Simd::Float4 z = Simd::Load(centers.z.data() + i);
+				const Simd::Float4 r = Simd::Load(radii.data() + i);
+				Simd::Float4 margin = Simd::Splat(std::numeric_limits<float>::max());
+				for (const auto& plane : frustum.planes) {
+					const Simd::Float4 distance = Simd::MulAdd(Simd::Splat(plane.normal.x), x,
+						Simd::MulAdd(Simd::Splat(plane.normal.y), y, Simd::MulAdd(Simd::Splat(plane.normal.z), z, Simd::Splat(plane.distance))));
+					margin = Simd::Min(margin, distance + r);
+				}
+
+				float lanes[4];
+				Simd::Store(lanes, margin);
+				for (size_t lane = 0; lane < 4; lane++) {
+					if (lanes[lane] >= 0.0f) {
+						accept(i + lane);
+					}
+				}
+			}
+			for (; i < end; i++) {
+				if (frustum.intersects(Vector3 { centers.x[i], centers.y[i], centers.z[i] }, radii[i])) {
+					accept(i);
+				}
+			}
+		});
+		return m_visible;
+	}
+
+	std::span<const uint32_t> CullingStage::cull_boxes(
+		const Frustum& frustum, const ConstVector3Stream centers, const ConstVector3Stream extents, const OcclusionBuffer* occlusion
+	) {
+		run(centers.size(), [&](const size_t begin, const size_t end, std::vector<uint32_t>& out) {
+			const auto accept = [&](const size_t i) {
+				const Vector3 center = { centers.x[i], centers.y[i], centers.z[i] };
+				const Vector3 extent = { extents.x[i], extents.y[i], extents.z[i] };
+				if (occlusion == nullptr || occlusion->is_visible(AABB::FromCenter(center, extent))) {
+					out.push_back(static_cast<uint32_t>(i));
+				}
+			};
+
+			// A box reaches as far towards a plane as its extents projected on the absolute normal
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 x = Simd::Load(centers.x.data() + i);
+				const Simd::Float4 y = Simd::Load(centers.y.data() + i);
+				const Simd::Float4 z = Simd::Load(centers.z.data() + i);
+				const Simd::Float4 ex = Simd::Load(extents.x.data() + i);
+				const Simd::Float4 ey = Simd::Load(extents.y.data() + i);
+				const Simd::Float4 ez = Simd::Load(extents.z.data() + i);
+				Simd::Float4 margin = Simd::Splat(std::numeric_limits<float>::max());
+				for (const auto& plane : frustum.planes) {
+					const Simd::Float4 distance = Simd::MulAdd(Simd::Splat(plane.normal.x), x,
+						Simd::MulAdd(Simd::Splat(plane.normal.y), y, Simd::MulAdd(Simd::Splat(plane.normal.z), z, Simd::Splat(plane.distance))));
+					const Simd::Float4 reach = Simd::MulAdd(Simd::Splat(std::abs(plane.normal.x)), ex,
+						Simd::MulAdd(Simd::Splat(std::abs(plane.normal.y)), ey, Simd::Splat(std::abs(plane.normal.z)) * ez));
+					margin = Simd::Min(margin, distance + reach);
+				}
+
+				float lanes[4];
+				Simd::Store(lanes, margin);
+				for (size_t lane = 0; lane < 4; lane++) {
+					if (lanes[lane] >= 0.0f) {
+						accept(i + lane);
+					}
+				}
+			}
+			for (; i < end; i++) {
+				const Vector3 center = { centers.x[i], centers.y[i], centers.z[i] };
+				const Vector3 extent = { extents.x[i], extents.y[i], extents.z[i] };
+				if (frustum.intersects(AABB::FromCenter(center, extent))) {
+					accept(i);
+				}
+			}
+		});
+		return m_visible;
+	}
+
+	std::span<const uint32_t> CullingStage::cull_tree(const Frustum& frustum, const AABBTree& tree, const OcclusionBuffer* occlusion) {
+		// Hidden nodes reject their whole subtree, leaves below a node inside the frustum still get their own occlusion test
+		m_visible.clear();
+		tree.query_hierarchical([&](const AABB& bounds) {
+			if (occlusion != nullptr && !occlusion->is_visible(bounds)) {
+				return Spatial::Containment::Outside;
+			}
+			return frustum.classify(bounds);
+		}, [&](const int32_t proxy) {
+			if (occlusion == nullptr || occlusion->is_visible(tree.fat_bounds(proxy))) {
+				m_visible.push_back(static_cast<uint32_t>(tree.user_data(proxy)));
+			}
+			return true;
+		});
+		std::ranges::sort(m_visible);
+		return m_visible;
+	}
+
+	static bool ValidatePositiveOrZero(const CVar*, const std::string& value) {
+		int32_t number;
+		return StringUtil::ParseInt(value, number) && number >= 0;
+	}
+}
\ No newline at end of file
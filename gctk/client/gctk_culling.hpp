@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+
+#include "gctk_math.hpp"
+#include "gctk_math_batch.hpp"
+#include "gctk_spatial.hpp"
+
+namespace gctk {
+	struct Plane {
+		Vector3 normal;
+		float distance;
+
+		// Positive on the side the normal points to
+		[[nodiscard]] constexpr float signed_distance(const Vector3& point) const { return normal.dot(point) + distance; }
+	};
+
+	// Clip planes of a view-projection matrix, the normals point into the frustum
+	struct Frustum {
+		enum PlaneIndex {
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far
+		};
+
+		std::array<Plane, 6> planes;
+
+		[[nodiscard]] bool intersects(const Vector3& center, float radius) const;
+		[[nodiscard]] bool intersects(const AABB& bounds) const;
+		[[nodiscard]] Spatial::Containment classify(const AABB& bounds) const;
+
+		[[nodiscard]] static Frustum FromMatrix(const Matrix4& view_projection);
+	};
+
+	// Coarse software depth buffer for occlusion culling. Occluders are rasterized at the farthest depth of each triangle
+	// and occludees are tested by their screen rectangle at their nearest depth, so only hidden objects are rejected.
+	// Anything crossing the near plane is never used as an occluder and never rejected.
+	class OcclusionBuffer {
+		struct Level {
+			int32_t width, height;
+			std::vector<float> depth;
+		};
+
+		Matrix4 m_viewProjection;
+		std::vector<Level> m_levels; // Level 0 is the full resolution buffer, every further level keeps the maximum of 2x2 texels
+
+		void rasterize(const Vector4& a, const Vector4& b, const Vector4& c);
+	public:
+		OcclusionBuffer() = default;
+
+		// Clears the buffer for a new frame
+		void begin(const Matrix4& view_projection, int32_t width, int32_t height);
+		// Boxes must be fully solid, like walls, terrain blocks or building shells
+		void add_occluder(const AABB& bounds);
+		// World space triangle list, every three vertices make a triangle
+		void add_occluder(std::span<const Vector3> triangles);
+		// Builds the depth pyramid, call it after the last occluder and before testing
+		void finish();
+
+		[[nodiscard]] bool is_visible(const AABB& bounds) const;
+
+		[[nodiscard]] inline int32_t width() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+		[[nodiscard]] inline int32_t height() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+	};
+
+	// Visibility determination before rendering. Each call returns the indices of the visible inputs in ascending order,
+	// the span stays valid until the next call. Long inputs are split into jobs.
+	class CullingStage {
+		std::vector<uint32_t> m_visible;
+		std::vector<std::vector<uint32_t>> m_partial;
+
+		template<typename Fn>
+		void run(size_t count, Fn&& fn);
+	public:
+		CullingStage() = default;
+
+		CullingStage(const CullingStage&) = delete;
+		CullingStage& operator=(const CullingStage&) = delete;
+
+		std::span<const uint32_t> cull_spheres(
+			const Frustum& frustum, ConstVector3Stream centers, std::span<const float> radii, const OcclusionBuffer* occlusion = nullptr
+		);
+		std::span<const uint32_t> cull_boxes(
+			const Frustum& frustum, ConstVector3Stream centers, ConstVector3Stream extents, const OcclusionBuffer* occlusion = nullptr
+		);
+		// Skips whole subtrees outside the frustum, returns the user data of the visible leaves truncated to 32 bits
+		std::span<const uint32_t> cull_tree(const Frustum& frustum, const AABBTree& tree, const OcclusionBuffer* occlusion = nullptr);
+
+		[[nodiscard]] inline std::span<const uint32_t> visible() const { return m_visible; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "gctk_gl_state.hpp"
+
+#include <algorithm>
+
+namespace gctk {
+	static constexpr GLuint UNKNOWN_BINDING = UINT32_MAX;
+	static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+	static constexpr GLuint MAX_UNIFORM_BINDINGS = 16;
+	static constexpr GLenum UNKNOWN_ENUM = 0xFFFFFFFF;
+
+	enum class TrackedCapability : uint8_t {
+		Blend,
+		DepthTest,
+		CullFace,
+		ScissorTest,
+		Count
+	};
+	enum class TrackedBuffer : uint8_t {
+		Array,
+		ElementArray,
+		Uniform,
+		ShaderStorage,
+		DrawIndirect,
+		PixelUnpack,
+		Count
+	};
+
+	static constexpr GLenum TEXTURE_TARGETS[] = {
+		GL_TEXTURE_1D, GL_TEXTURE_1D_ARRAY,
+		GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY,
+		GL_TEXTURE_3D,
+		GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_ARRAY
+	};
+	static constexpr size_t TEXTURE_TARGET_COUNT = std::size(TEXTURE_TARGETS);
+
+	struct BufferRange {
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+
+		bool operator==(const BufferRange& other) const = default;
+	};
+
+	static struct {
+		GLuint active_unit;
+		GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+		// Binding made through glBindTextureUnit, which doesn't tell which target it used
+		GLuint unit_textures[MAX_TEXTURE_UNITS];
+		GLuint program;
+		GLuint vertex_array;
+		GLuint buffers[static_cast<size_t>(TrackedBuffer::Count)];
+		BufferRange uniform_ranges[MAX_UNIFORM_BINDINGS];
+		int8_t capabilities[static_cast<size_t>(TrackedCapability::Count)];
+		GLenum blend_source;
+		GLenum blend_destination;
+		GLenum depth_func;
+		int8_t depth_mask;
+		Color clear_color;
+		bool clear_color_known;
+	} s_state;
+
+	static GLStateStats s_frame_stats = { };
+	static GLStateStats s_last_frame_stats = { };
+	static bool s_state_initialized = false;
+
+	static void EnsureInitialized() {
+		if (!s_state_initialized) {
+			GLState::Invalidate();
+		}
+	}
+	// Returns true when the call has to be issued, the shadow value is updated in that case
+	template<typename T>
+	static bool Track(T& shadow, const T& value) {
+		EnsureInitialized();
+		if (shadow == value) {
+			++s_frame_stats.elided;
+			return false;
+		}
+		shadow = value;
+		++s_frame_stats.issued;
+		return true;
+	}
+	static int TextureTargetIndex(const GLenum target) {
+		for (size_t i = 0; i < TEXTURE_TARGET_COUNT; ++i) {
+			if (TEXTURE_TARGETS[i] == target) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+	static int BufferTargetIndex(const GLenum target) {
+		switch (target) {
+			case GL_ARRAY_BUFFER: return static_cast<int>(TrackedBuffer::Array);
+			case GL_ELEMENT_ARRAY_BUFFER: return static_cast<int>(TrackedBuffer::ElementArray);
+			case GL_UNIFORM_BUFFER: return static_cast<int>(TrackedBuffer::Uniform);
+			case GL_SHADER_STORAGE_BUFFER: return static_cast<int>(TrackedBuffer::ShaderStorage);
+			case GL_DRAW_INDIRECT_BUFFER: return static_cast<int>(TrackedBuffer::DrawIndirect);
+			case GL_PIXEL_UNPACK_BUFFER: return static_cast<int>(TrackedBuffer::PixelUnpack);
+			default: return -1;
+		}
+	}
+	static int CapabilityIndex(const GLenum capability) {
+		switch (capability) {
+			case GL_BLEND: return static_cast<int>(TrackedCapability::Blend);
+			case GL_DEPTH_TEST: return static_cast<int>(TrackedCapability::DepthTest);
+			case GL_CULL_FACE: return static_cast<int>(TrackedCapability::CullFace);
+			case GL_SCISSOR_TEST: return static_cast<int>(TrackedCapability::ScissorTest);
+			default: return -1;
+		}
+	}
+
+	void GLState::ActiveTexture(const GLuint unit) {
+		if (Track(s_state.active_unit, unit)) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+	}
+	void GLState::BindTexture(const GLenum target, const GLuint texture) {
+		EnsureInitialized();
+		const auto index = TextureTargetIndex(target);
+		const auto unit = s_state.active_unit;
+		if (index < 0 || unit >= MAX_TEXTURE_UNITS) {
+			++s_frame_stats.issued;
+			glBindTexture(target, texture);
+			return;
+		}
+		if (Track(s_state.textures[unit][index], texture)) {
+			s_state.unit_textures[unit] = UNKNOWN_BINDING;
+			glBindTexture(target, texture);
+		}
+	}
+	void GLState::BindTextureUnit(const GLuint unit, const GLuint texture) {
+		EnsureInitialized();
+		if (unit >= MAX_TEXTURE_UNITS) {
+			++s_frame_stats.issued;
+			glBindTextureUnit(unit, texture);
+			return;
+		}
+		if (Track(s_state.unit_textures[unit], texture)) {
+			std::fill(std::begin(s_state.textures[unit]), std::end(s_state.textures[unit]), UNKNOWN_BINDING);
+			glBindTextureUnit(unit, texture);
+		}
+	}
+	void GLState::UseProgram(const GLuint program) {
+		if (Track(s_state.program, program)) {
+			glUseProgram(program);
+		}
+	}
+	void GLState::BindVertexArray(const GLuint vertex_array) {
+		if (Track(s_state.vertex_array, vertex_array)) {
+			// The element buffer binding is part of the vertex array object
+			s_state.buffers[static_cast<size_t>(TrackedBuffer::ElementArray)] = UNKNOWN_BINDING;
+			glBindVertexArray(vertex_array);
+		}
+	}
+	void GLState::BindBuffer(const GLenum target, const GLuint buffer) {
+		EnsureInitialized();
+		if (const auto index = BufferTargetIndex(target); index < 0) {
+			++s_frame_stats.issued;
+			glBindBuffer(target, buffer);
+		} else if (Track(s_state.buffers[index], buffer)) {
+			glBindBuffer(target, buffer);
+		}
+	}
+
+	void GLState::BindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size) {
+		EnsureInitialized();
+		if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+			++s_frame_stats.issued;
+			if (const auto generic = BufferTargetIndex(target); generic >= 0) {
+				s_state.buffers[generic] = buffer;
+			}
+			glBindBufferRange(target, index, buffer, offset, size);
+			return;
+		}
+		if (Track(s_state.uniform_ranges[index], BufferRange { buffer, offset, size })) {
+			// Binding an indexed range also binds the generic binding point
+			s_state.buffers[static_cast<size_t>(TrackedBuffer::Uniform)] = buffer;
+			glBindBufferRange(target, index, buffer, offset, size);
+		}
+	}
+
+	void GLState::SetEnabled(const GLenum capability, const bool enabled) {
+		const auto index = CapabilityIndex(capability);
+		if (index >= 0 && !Track(s_state.capabilities[index], static_cast<int8_t>(enabled))) {
+			return;
+		}
+		if (index < 0) {
+			++s_frame_stats.issued;
+		}
+
+		if (enabled) {
+			glEnable(capability);
+		} else {
+			glDisable(capability);
+		}
+	}
+	void GLState::BlendFunc(const GLenum source, const GLenum destination) {
+		EnsureInitialized();
+		if (s_state.blend_source == source && s_state.blend_destination == destination) {
+			++s_frame_stats.elided;
+			return;
+		}
+		s_state.blend_source = source;
+		s_state.blend_destination = destination;
+		++s_frame_stats.issued;
+		glBlendFunc(source, destination);
+	}
+	void GLState::DepthFunc(const GLenum func) {
+		if (Track(s_state.depth_func, func)) {
+			glDepthFunc(func);
+		}
+	}
+	void GLState::DepthMask(const bool write) {
+		if (Track(s_state.depth_mask, static_cast<int8_t>(write))) {
+			glDepthMask(write ? GL_TRUE : GL_FALSE);
+		}
+	}
+	void GLState::ClearColor(const Color& color) {
+		EnsureInitialized();
+		if (s_state.clear_color_known && s_state.clear_color.r == color.r && s_state.clear_color.g == color.g &&
+			s_state.clear_color.b == color.b && s_state.clear_color.a == color.a) {
+			++s_frame_stats.elided;
+			return;
+		}
+		s_state.clear_color = color;
+		s_state.clear_color_known = true;
+		++s_frame_stats.issued;
+		glClearColor(color.r, color.g, color.b, color.a);
+	}
+
+	void GLState::ForgetTexture(const GLuint texture) {
+		for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+			for (auto& bound : s_state.textures[unit]) {
+				if (bound == texture) {
+					bound = UNKNOWN_BINDING;
+				}
+			}
+			if (s_state.unit_textures[unit] == texture) {
+				s_state.unit_textures[unit] = UNKNOWN_BINDING;
+			}
+		}
+	}
+	void GLState::ForgetProgram(const GLuint program) {
+		if (s_state.program == program) {
+			s_state.program = UNKNOWN_BINDING;
+		}
+	}
+	void GLState::ForgetVertexArray(const GLuint vertex_array) {
+		if (s_state.vertex_array == vertex_array) {
+			s_state.vertex_array = UNKNOWN_BINDING;
+		}
+	}
+	void GLState::ForgetBuffer(const GLuint buffer) {
+		for (auto& bound : s_state.buffers) {
+			if (bound == buffer) {
+				bound = UNKNOWN_BINDING;
+			}
+		}
+		for (auto& range : s_state.uniform_ranges) {
+			if (range.buffer == buffer) {
+				range.buffer = UNKNOWN_BINDING;
+			}
+		}
+	}
+	void GLState::Invalidate() {
+		s_state.active_unit = UNKNOWN_BINDING;
+		for (auto& unit : s_state.textures) {
+			std::fill(std::begin(unit), std::end(unit), UNKNOWN_BINDING);
+		}
+		std::fill(std::begin(s_state.unit_textures), std::end(s_state.unit_textures), UNKNOWN_BINDING);
+		s_state.program = UNKNOWN_BINDING;
+		s_state.vertex_array = UNKNOWN_BINDING;
+		std::fill(std::begin(s_state.buffers), std::end(s_state.buffers), UNKNOWN_BINDING);
+		std::fill(std::begin(s_state.uniform_ranges), std::end(s_state.uniform_ranges), BufferRange { UNKNOWN_BINDING, 0, 0 });
+		std::fill(std::begin(s_state.capabilities), std::end(s_state.capabilities), -1);
+		s_state.blend_source = UNKNOWN_ENUM;
+		s_state.blend_destination = UNKNOWN_ENUM;
+		s_state.depth_func = UNKNOWN_ENUM;
+		s_state.depth_mask = -1;
+		s_state.clear_color_known = false;
+		s_state_initialized = true;
+	}
+
+	void GLState::EndFrame() {
+		s_last_frame_stats = s_frame_stats;
+		s_frame_stats = { };
+	}
+	GLStateStats GLState::LastFrameStats() {
+		return s_last_frame_stats;
+	}
+}
\ No newline at end of file
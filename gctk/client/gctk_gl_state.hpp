@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include "gctk_math.hpp"
+
+namespace gctk {
+	struct GLStateStats {
+		uint32_t issued;
+		uint32_t elided;
+	};
+
+	// Shadows the bound objects and fixed-function state of the current context and skips calls that would not change it
+	namespace GLState {
+		void ActiveTexture(GLuint unit);
+		void BindTexture(GLenum target, GLuint texture);
+		void BindTextureUnit(GLuint unit, GLuint texture);
+		void UseProgram(GLuint program);
+		void BindVertexArray(GLuint vertex_array);
+		void BindBuffer(GLenum target, GLuint buffer);
+		// Uniform buffer binding points are tracked with their range, other targets are passed through
+		void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		void SetEnabled(GLenum capability, bool enabled);
+		void BlendFunc(GLenum source, GLenum destination);
+		void DepthFunc(GLenum func);
+		void DepthMask(bool write);
+		void ClearColor(const Color& color);
+
+		// Objects are unbound by GL when deleted and their names may be reused, so the shadow has to forget them
+		void ForgetTexture(GLuint texture);
+		void ForgetProgram(GLuint program);
+		void ForgetVertexArray(GLuint vertex_array);
+		void ForgetBuffer(GLuint buffer);
+		// Marks everything unknown, needed after GL calls that bypassed the cache
+		void Invalidate();
+
+		// Closes the counters of the current frame, LastFrameStats returns them until the next call
+		void EndFrame();
+		GLStateStats LastFrameStats();
+	}
+
+	// With vid_render_thread only the render thread has a context, code outside the render commands
+	// (loaders, destructors) goes through these instead of calling GL itself
+	namespace GLContext {
+		// Runs fn on the thread owning the context and waits for it, directly if that is the calling thread
+		void Run(const std::function<void()>& fn);
+		// Same without waiting, for releasing objects
+		void Post(std::function<void()> fn);
+	}
+}
\ No newline at end of file
@@ -1,14 +1,17 @@
 #include "gctk_input_client.hpp"
 
+#include <atomic>
 #include <cstring>
 #include <fstream>
-#include <ranges>
 #include <GLFW/glfw3.h>
 
 #include "gctk_cvar.hpp"
 #include "gctk_debug.hpp"
 #include "gctk_filesys.hpp"
+#include "gctk_profiler.hpp"
+#include "gctk_ring_buffer.hpp"
 #include "gctk_str.hpp"
+#include "gctk_time.hpp"
 
 #define MOUSE_BUTTON_ORIGIN (GLFW_KEY_LAST + 1)
 #define GAMEPAD_BUTTONS_ORIGIN (MOUSE_BUTTON_ORIGIN + 2)
@@ -18,6 +21,11 @@
 
 #define GAMEPAD_AXIS_ORIGIN (MOUSE_MOTION_ORIGIN + 2)
 
+#define KEYCODE_COUNT (GAMEPAD_AXIS_ORIGIN + GLFW_GAMEPAD_AXIS_LAST + 1)
+
+#define INPUT_RECORDING_VERSION 1
+#define INPUT_RECORDING_TAPPED_BIT 0x80
+
 namespace gctk {
 	void _cmd_bind_mult(const std::vector<std::string>& args);
 
@@ -61,87 +69,115 @@ namespace gctk {
 		float value;
 		int direction;
 		bool changed;
+		double timestamp;
 	};
 
-	struct InputBinding {
-		virtual ~InputBinding() = default;
-
-		[[nodiscard]] virtual float value() = 0;
-		[[nodiscard]] virtual Input::KeyState keystate() = 0;
-		[[nodiscard]] virtual bool is_axis() const = 0;
+	struct InputEvent {
+		double timestamp;
+		int keycode;
+		uint8_t device_id;
+		float value;
 	};
 
-	struct ActionBinding final : public InputBinding {
-		std::vector<InputState*> states;
-		Input::KeyState last_state = Input::KeyState::Up;
+	static constexpr uint8_t INPUT_RECORDING_IDENTIFIER[4] = { 'G', 'I', 'N', 'P' };
 
-		explicit ActionBinding(const std::vector<InputState*>& states) : states(states) { }
-		explicit ActionBinding(std::vector<InputState*>&& states) : states(std::move(states)) { }
-
-		[[nodiscard]] float value() override {
-			const auto state = keystate();
-			return state == Input::KeyState::Down || state == Input::KeyState::Pressed ? 1.0f : 0.0f;
-		}
-		[[nodiscard]] Input::KeyState keystate() override {
-			for (auto& state : states) {
-				if (state->changed) {
-					state->changed = false;
-					last_state = state->keystate;
-					return last_state;
-				}
-			}
-			return last_state;
-		}
-		[[nodiscard]] constexpr bool is_axis() const override {
-			return false;
-		}
+	struct ActionBinding {
+		std::vector<uint32_t> states;
 	};
-	struct AxisBinding final : public InputBinding {
-		std::vector<std::pair<InputState*, InputState*>> states;
+	struct AxisBinding {
+		std::vector<std::pair<uint32_t, uint32_t>> states;
 		float multiplier;
-
-		explicit AxisBinding(const std::vector<std::pair<InputState*, InputState*>>& states, const float multiplier = 1.0f) :
-			states(states), multiplier(multiplier) { }
-		explicit AxisBinding(std::vector<std::pair<InputState*, InputState*>>&& states, const float multiplier = 1.0f) noexcept :
-			states(std::move(states)), multiplier(multiplier) { }
-
-		[[nodiscard]] float value() override {
-			for (auto& [ negative, positive ] : states) {
-				if (negative->changed || positive->changed) {
-					negative->changed = false;
-					positive->changed = false;
-					return (positive->value - negative->value) * multiplier;
-				}
-			}
-			return 0.0f;
-		}
-		[[nodiscard]] constexpr Input::KeyState keystate() override {
-			return Input::KeyState::Invalid;
-		}
-		[[nodiscard]] constexpr bool is_axis() const override {
-			return true;
-		}
+	};
+	struct BindingEntry {
+		bool is_axis;
+		uint32_t index;
 	};
 
-	static std::unordered_map<std::string, InputState> s_input_map;
-	static std::unordered_map<std::string, InputBinding*> s_input_binds;
+	CVar in_sample_rate("in_sample_rate", "0", CVAR_FLAG_USER_DATA, [](const CVar* self, const std::string& value) {
+		(void)self;
+		float rate;
+		return StringUtil::ParseFloat(value, rate) && rate >= 0.0f;
+	});
+	CVar in_record("in_record", "", CVAR_DEFAULT_FLAGS);
+	CVar in_replay("in_replay", "", CVAR_DEFAULT_FLAGS);
+	CVar in_replay_exit("in_replay_exit", "true", CVAR_DEFAULT_FLAGS);
+
+	static std::vector<InputState> s_input_states;
+	static std::unordered_map<std::string, uint32_t> s_input_map;
+
+	// Resolved binding results are kept in separate arrays so handle queries only touch tightly packed data
+	static std::vector<ActionBinding> s_actions;
+	static std::vector<Input::KeyState> s_action_states;
+	static std::vector<double> s_action_timestamps;
+	static std::vector<AxisBinding> s_axes;
+	static std::vector<float> s_axis_values;
+	static std::unordered_map<std::string, BindingEntry> s_input_binds;
+
+	// Written by the sampling side (GLFW callbacks and Input::Sample), read by Input::Poll
+	static RingBuffer<InputEvent, 4096> s_input_events;
+	static std::atomic<uint32_t> s_dropped_events = 0;
+	static GLFWgamepadstate s_sampled_gamepads[GLFW_JOYSTICK_LAST + 1];
+	static bool s_sampled_gamepad_present[GLFW_JOYSTICK_LAST + 1];
+	static double s_sample_rate = 0.0;
+
+	// Latest raw value of every keycode per device, only touched by Input::Poll
+	static float s_raw_values[GLFW_JOYSTICK_LAST + 1][KEYCODE_COUNT];
+	static double s_raw_timestamps[GLFW_JOYSTICK_LAST + 1][KEYCODE_COUNT];
+	static bool s_raw_tapped[GLFW_JOYSTICK_LAST + 1][KEYCODE_COUNT];
 
 	static Vector2D s_mouse;
 	static Vector2D s_mouse_prev;
-	static double s_mousewheel_x = 0, s_mousewheel_y = 0;
+
+	// Recordings store the raw table changes of every Poll, replays apply them in place of the event queue
+	static std::ofstream s_record_stream;
+	static float s_recorded_values[GLFW_JOYSTICK_LAST + 1][KEYCODE_COUNT];
+	static std::ifstream s_replay_stream;
+	static uint64_t s_replay_frame = 0;
+	static GLFWwindow* s_window = nullptr;
 
 	static int StringToKeycode(const std::string& name);
 	static std::string KeycodeToString(int key);
 	static InputType KeycodeToInputType(int key);
 
+	static void PushInputEvent(int keycode, uint8_t device_id, float value);
+	static uint32_t RegisterInputState(const std::string& key, int keycode);
 	static void UpdateKeyState(InputState& key_state_in, bool is_pressed);
+	static void UpdateAnalogState(InputState& key_state_in, float value);
+	static void WriteRecordingFrame();
+	static void ReadReplayFrame();
+	static Path ResolveRecordingPath(const std::string& value);
 
 	void Input::Initialize(const Client& client) {
+		s_sample_rate = in_sample_rate.get_float();
+		s_window = client.get_window();
+
 		glfwGetCursorPos(client.get_window(), &s_mouse.x, &s_mouse.y);
+		s_mouse_prev = s_mouse;
+		s_raw_values[0][MOUSE_MOTION_ORIGIN] = static_cast<float>(s_mouse.x);
+		s_raw_values[0][MOUSE_MOTION_ORIGIN + 1] = static_cast<float>(s_mouse.y);
+
+		glfwSetKeyCallback(client.get_window(), [](GLFWwindow* window, const int key, const int scancode, const int action, const int mods) {
+			(void)window;
+			(void)scancode;
+			(void)mods;
+			if (key != GLFW_KEY_UNKNOWN && action != GLFW_REPEAT) {
+				PushInputEvent(key, 0, action == GLFW_PRESS ? 1.0f : 0.0f);
+			}
+		});
+		glfwSetMouseButtonCallback(client.get_window(), [](GLFWwindow* window, const int button, const int action, const int mods) {
+			(void)window;
+			(void)mods;
+			PushInputEvent(MOUSE_BUTTON_ORIGIN + button, 0, action == GLFW_PRESS ? 1.0f : 0.0f);
+		});
+		glfwSetCursorPosCallback(client.get_window(), [](GLFWwindow* window, const double x, const double y) {
+			(void)window;
+			PushInputEvent(MOUSE_MOTION_ORIGIN, 0, static_cast<float>(x));
+			PushInputEvent(MOUSE_MOTION_ORIGIN + 1, 0, static_cast<float>(y));
+		});
 		glfwSetScrollCallback(client.get_window(), [](GLFWwindow* window, const double xoffset, const double yoffset) {
 			(void)window;
-			s_mousewheel_x = xoffset;
-			s_mousewheel_y = yoffset;
+			PushInputEvent(MOUSE_WHEEL_ORIGIN, 0, static_cast<float>(xoffset));
+			PushInputEvent(MOUSE_WHEEL_ORIGIN + 1, 0, static_cast<float>(yoffset));
 		});
 
 		if (Console::ConfigExists("keybinds.cfg")) {
@@ -163,111 +199,239 @@ namespace gctk {
 
 			Console::LoadConfig("keybinds.cfg");
 		}
+
+		if (const auto& replay = in_replay.get_string(); !replay.empty()) {
+			StartReplay(ResolveRecordingPath(replay));
+		}
+		if (const auto& record = in_record.get_string(); !record.empty()) {
+			StartRecording(ResolveRecordingPath(record));
+		}
+	}
+	void Input::Sample() {
+		glfwPollEvents();
+
+		for (int i = 0; i < GLFW_JOYSTICK_LAST + 1; ++i) {
+			GLFWgamepadstate state;
+			if (glfwGetGamepadState(i, &state) == GLFW_FALSE) {
+				if (s_sampled_gamepad_present[i]) {
+					state = { };
+				} else {
+					continue;
+				}
+			}
+
+			auto& previous = s_sampled_gamepads[i];
+			for (int j = 0; j <= GLFW_GAMEPAD_BUTTON_LAST; ++j) {
+				if (state.buttons[j] != previous.buttons[j]) {
+					PushInputEvent(GAMEPAD_BUTTONS_ORIGIN + j, static_cast<uint8_t>(i), state.buttons[j] != GLFW_RELEASE ? 1.0f : 0.0f);
+				}
+			}
+			for (int j = 0; j <= GLFW_GAMEPAD_AXIS_LAST; ++j) {
+				if (state.axes[j] != previous.axes[j]) {
+					PushInputEvent(GAMEPAD_AXIS_ORIGIN + j, static_cast<uint8_t>(i), state.axes[j]);
+				}
+			}
+			previous = state;
+			s_sampled_gamepad_present[i] = glfwJoystickIsGamepad(i) == GLFW_TRUE;
+		}
+	}
+	double Input::SampleRate() {
+		return s_sample_rate;
 	}
 	void Input::Poll() {
-		const auto window = Client::Instance()->get_window();
-		s_mouse_prev = s_mouse;
+		GCTK_PROFILE_SCOPE("Input::Poll");
+		if (s_sample_rate <= 0.0) {
+			Sample();
+		}
 
-		glfwGetCursorPos(Client::Instance()->get_window(), &s_mouse.x, &s_mouse.y);
-		if (s_input_map.contains("mouse_x")) {
-			auto& input = s_input_map.at("mouse_x");
-			const auto prev_value = input.value;
-			const auto value = static_cast<float>(s_mouse_prev.x - s_mouse.x);
-			const auto delta = value - prev_value;
+		if (const auto dropped = s_dropped_events.exchange(0); dropped > 0) {
+			LogWarn("Input event queue overflowed, {} events were dropped", dropped);
+		}
 
-			input.value = value;
+		InputEvent event { };
+		if (s_replay_stream.is_open()) {
+			// Live input is discarded while a recording is played back
+			while (s_input_events.try_pop(event)) { }
+			ReadReplayFrame();
+		} else {
+			s_raw_values[0][MOUSE_WHEEL_ORIGIN] = 0.0f;
+			s_raw_values[0][MOUSE_WHEEL_ORIGIN + 1] = 0.0f;
 
-			const auto pressed = input.direction == 0 ?
-									  delta != 0.0f :
-									  static_cast<int>(Math::Sign(delta)) == input.direction;
+			while (s_input_events.try_pop(event)) {
+				auto& raw = s_raw_values[event.device_id][event.keycode];
+				if (event.keycode == MOUSE_WHEEL_ORIGIN || event.keycode == MOUSE_WHEEL_ORIGIN + 1) {
+					raw += event.value;
+				} else {
+					// Remember presses that were released again before this poll, so short taps aren't lost
+					if (raw == 0.0f && event.value != 0.0f) {
+						s_raw_tapped[event.device_id][event.keycode] = true;
+					}
+					raw = event.value;
+				}
+				s_raw_timestamps[event.device_id][event.keycode] = event.timestamp;
+			}
+		}
 
-			UpdateKeyState(input, pressed);
+		if (s_record_stream.is_open()) {
+			WriteRecordingFrame();
 		}
-		if (s_input_map.contains("mouse_y")) {
-			auto& input = s_input_map.at("mouse_y");
-			const auto prev_value = input.value;
-			const auto value = static_cast<float>(s_mouse_prev.y - s_mouse.y);
-			const auto delta = value - prev_value;
 
-			input.value = value;
+		s_mouse_prev = s_mouse;
+		s_mouse.x = s_raw_values[0][MOUSE_MOTION_ORIGIN];
+		s_mouse.y = s_raw_values[0][MOUSE_MOTION_ORIGIN + 1];
+
+		for (auto& input : s_input_states) {
+			const auto raw = s_raw_values[input.device_id][input.keycode];
+			const auto previous_state = input.keystate;
+
+			switch (input.type) {
+				case InputType::Keyboard:
+				case InputType::MouseButton:
+				case InputType::GamepadButton: {
+					const auto state = raw != 0.0f || s_raw_tapped[input.device_id][input.keycode];
+					input.value = state ? 1.0f : 0.0f;
+					UpdateKeyState(input, state);
+				} break;
+				case InputType::MouseAxis: {
+					UpdateAnalogState(input, static_cast<float>(input.keycode == MOUSE_MOTION_ORIGIN ?
+						s_mouse_prev.x - s_mouse.x :
+						s_mouse_prev.y - s_mouse.y
+					));
+				} break;
+				case InputType::MouseWheel:
+				case InputType::GamepadAxis: {
+					UpdateAnalogState(input, raw);
+				} break;
+			}
 
-			const auto pressed = input.direction == 0 ?
-									  delta != 0.0f :
-									  static_cast<int>(Math::Sign(delta)) == input.direction;
+			if (input.keystate != previous_state) {
+				input.timestamp = s_raw_timestamps[input.device_id][input.keycode];
+			}
+		}
 
-			UpdateKeyState(input, pressed);
+		for (size_t i = 0; i < s_actions.size(); ++i) {
+			for (const auto state : s_actions[i].states) {
+				if (const auto& input = s_input_states[state]; input.changed) {
+					s_action_states[i] = input.keystate;
+					s_action_timestamps[i] = input.timestamp;
+					break;
+				}
+			}
 		}
 
-		if (s_input_map.contains("mwheel_x")) {
-			auto& input = s_input_map.at("mwheel_x");
-			const auto prev_value = input.value;
-			const auto value = s_mousewheel_x;
-			input.value = static_cast<float>(value);
+		for (size_t i = 0; i < s_axes.size(); ++i) {
+			float value = 0.0f;
+			for (const auto& [ negative, positive ] : s_axes[i].states) {
+				value = s_input_states[positive].value - s_input_states[negative].value;
+				if (value != 0.0f) {
+					break;
+				}
+			}
+			s_axis_values[i] = value * s_axes[i].multiplier;
+		}
 
-			const auto delta = value - prev_value;
-			const auto pressed = input.direction == 0 ?
-									  delta != 0.0f :
-									  static_cast<int>(Math::Sign(delta)) == input.direction;
-			UpdateKeyState(input, pressed);
+		for (auto& input : s_input_states) {
+			input.changed = false;
 		}
+		memset(s_raw_tapped, 0, sizeof(s_raw_tapped));
+	}
+
+	void Input::Dispose() {
+		StopRecording();
+		StopReplay();
+
+		s_actions.clear();
+		s_action_states.clear();
+		s_action_timestamps.clear();
+		s_axes.clear();
+		s_axis_values.clear();
+		s_input_binds.clear();
+		s_input_states.clear();
+		s_input_map.clear();
+	}
 
-		if (s_input_map.contains("mwheel_y")) {
-			auto& input = s_input_map.at("mwheel_y");
-			const auto prev_value = input.value;
-			const auto value = s_mousewheel_y;
-			input.value = static_cast<float>(value);
+	bool Input::StartRecording(const Path& path) {
+		StopRecording();
 
-			const auto delta = value - prev_value;
-			const auto pressed = input.direction == 0 ?
-									  delta != 0.0f :
-									  static_cast<int>(Math::Sign(delta)) == input.direction;
-			UpdateKeyState(input, pressed);
+		s_record_stream.open(path, std::ios::binary);
+		if (!s_record_stream.is_open()) {
+			LogErr("Could not record input to \"{}\": Failed to open file", path);
+			return false;
 		}
 
-		for (int i = 0; i < GLFW_KEY_LAST; ++i) {
-			if (auto str = KeycodeToString(i); s_input_map.contains(str)) {
-				auto& input = s_input_map.at(str);
-				const auto state = glfwGetKey(window, i) != GLFW_RELEASE;
-				input.value = state ? 1.0f : 0.0f;
-				UpdateKeyState(input, state);
-			}
+		constexpr uint16_t version = INPUT_RECORDING_VERSION;
+		constexpr uint16_t keycode_count = KEYCODE_COUNT;
+		s_record_stream.write(reinterpret_cast<const char*>(INPUT_RECORDING_IDENTIFIER), 4);
+		s_record_stream.write(reinterpret_cast<const char*>(&version), 2);
+		s_record_stream.write(reinterpret_cast<const char*>(&keycode_count), 2);
+		s_record_stream.write(reinterpret_cast<const char*>(&s_mouse.x), 8);
+		s_record_stream.write(reinterpret_cast<const char*>(&s_mouse.y), 8);
+
+		// The first recorded frame holds every non-zero value, so replays don't depend on earlier input
+		memset(s_recorded_values, 0, sizeof(s_recorded_values));
+		LogInfo("Recording input to \"{}\"", path);
+		return true;
+	}
+	void Input::StopRecording() {
+		if (s_record_stream.is_open()) {
+			s_record_stream.flush();
+			s_record_stream.close();
 		}
+	}
+	bool Input::StartReplay(const Path& path) {
+		StopReplay();
 
-		GLFWgamepadstate gamepad_state[GLFW_JOYSTICK_LAST + 1];
-		for (int i = 0; i < GLFW_JOYSTICK_LAST + 1; ++i) {
-			glfwGetGamepadState(i, &gamepad_state[i]);
+		s_replay_stream.open(path, std::ios::binary);
+		if (!s_replay_stream.is_open()) {
+			LogErr("Could not replay input \"{}\": Failed to open file", path);
+			return false;
 		}
 
-		for (int i = 0; i < GLFW_GAMEPAD_BUTTON_LAST; ++i) {
-			if (auto str = KeycodeToString(i + GAMEPAD_BUTTONS_ORIGIN); s_input_map.contains(str)) {
-				auto& input = s_input_map.at(str);
-				const auto state = gamepad_state[input.device_id].buttons[i] != GLFW_RELEASE;
-				input.value = state ? 1.0f : 0.0f;
-				UpdateKeyState(input, state);
-			}
+		uint8_t identifier[4];
+		s_replay_stream.read(reinterpret_cast<char*>(identifier), 4);
+		if (memcmp(identifier, INPUT_RECORDING_IDENTIFIER, 4) != 0) {
+			LogErr("Could not replay input \"{}\": Invalid identifier", path);
+			s_replay_stream.close();
+			return false;
 		}
 
-		for (int i = 0; i < GLFW_GAMEPAD_AXIS_LAST; ++i) {
-			if (auto str = KeycodeToString(i + GAMEPAD_AXIS_ORIGIN); s_input_map.contains(str)) {
-				auto& input = s_input_map.at(str);
-				const auto prev_value = input.value;
-				const auto value = gamepad_state[input.device_id].axes[i];
-				input.value = value;
+		uint16_t version, keycode_count;
+		s_replay_stream.read(reinterpret_cast<char*>(&version), 2);
+		s_replay_stream.read(reinterpret_cast<char*>(&keycode_count), 2);
+		if (version != INPUT_RECORDING_VERSION || keycode_count != KEYCODE_COUNT) {
+			LogErr("Could not replay input \"{}\": Unsupported version {}", path, version);
+			s_replay_stream.close();
+			return false;
+		}
 
-				const auto delta = value - prev_value;
-				const auto pressed = input.direction == 0 ?
-										  delta != 0.0f :
-										  static_cast<int>(Math::Sign(delta)) == input.direction;
-				UpdateKeyState(input, pressed);
-			}
+		s_replay_stream.read(reinterpret_cast<char*>(&s_mouse.x), 8);
+		s_replay_stream.read(reinterpret_cast<char*>(&s_mouse.y), 8);
+		s_mouse_prev = s_mouse;
+
+		memset(s_raw_values, 0, sizeof(s_raw_values));
+		memset(s_raw_tapped, 0, sizeof(s_raw_tapped));
+		for (auto& input : s_input_states) {
+			input.keystate = Input::KeyState::Up;
+			input.value = 0.0f;
+			input.changed = false;
 		}
-	}
+		std::fill(s_action_states.begin(), s_action_states.end(), Input::KeyState::Up);
+		std::fill(s_axis_values.begin(), s_axis_values.end(), 0.0f);
 
-	void Input::Dispose() {
-		for (const auto& binding: s_input_binds | std::views::values) {
-			delete binding;
+		s_replay_frame = 0;
+		LogInfo("Replaying input from \"{}\"", path);
+		return true;
+	}
+	void Input::StopReplay() {
+		if (s_replay_stream.is_open()) {
+			s_replay_stream.close();
 		}
-		s_input_binds.clear();
+	}
+	bool Input::IsRecording() {
+		return s_record_stream.is_open();
+	}
+	bool Input::IsReplaying() {
+		return s_replay_stream.is_open();
 	}
 
 	bool Input::CreateAxis(const std::string& name, const std::initializer_list<std::pair<std::string, std::string>>& pairs) {
@@ -282,9 +446,9 @@ namespace gctk {
 			return false;
 		}
 
-		std::vector<std::pair<InputState*, InputState*>> states;
+		std::vector<std::pair<uint32_t, uint32_t>> states;
 
-		for (auto [ negative, positive ] : pairs) {
+		for (const auto& [ negative, positive ] : pairs) {
 			const auto pos = StringToKeycode(positive);
 			if (pos == GLFW_KEY_UNKNOWN) {
 				LogErr("Unknown key \"{}\"", positive);
@@ -297,37 +461,14 @@ namespace gctk {
 				return false;
 			}
 
-			if (!s_input_map.contains(positive)) {
-				s_input_map.emplace(positive, InputState {
-					KeycodeToInputType(pos),
-					0,
-					Input::Modifiers::None,
-					Input::KeyState::Up,
-					pos,
-					0.0f,
-					positive.starts_with('+') ? 1 :
-					(positive.starts_with('-') ? -1 : 0)
-				});
-			}
-			if (!s_input_map.contains(negative)) {
-				s_input_map.emplace(negative, InputState {
-					KeycodeToInputType(neg),
-					0,
-					Input::Modifiers::None,
-					Input::KeyState::Up,
-					neg,
-					0.0f,
-					negative.starts_with('+') ? 1 :
-					(negative.starts_with('-') ? -1 : 0)
-				});
-			}
-
-			states.emplace_back(&s_input_map.at(positive), &s_input_map.at(negative));
+			states.emplace_back(RegisterInputState(negative, neg), RegisterInputState(positive, pos));
 		}
 
-		s_input_binds.emplace(name, new AxisBinding { std::move(states) }); // NOLINT: Cleaned up by Input::Dispose
+		s_input_binds.emplace(name, BindingEntry { true, static_cast<uint32_t>(s_axes.size()) });
+		s_axes.push_back(AxisBinding { std::move(states), 1.0f });
+		s_axis_values.push_back(0.0f);
 
-		return true; // NOLINT: Cleaned up by Input::Dispose
+		return true;
 	}
 	bool Input::CreateAction(const std::string& name, const std::initializer_list<std::string>& keys) {
 		std::vector<std::string> keys_vec;
@@ -342,7 +483,7 @@ namespace gctk {
 			return false;
 		}
 
-		std::vector<InputState*> states;
+		std::vector<uint32_t> states;
 
 		for (const auto& key : keys) {
 			const auto code = StringToKeycode(key);
@@ -351,63 +492,109 @@ namespace gctk {
 				return false;
 			}
 
-			if (!s_input_map.contains(key)) {
-				s_input_map.emplace(key, InputState {
-					KeycodeToInputType(code),
-					0,
-					Input::Modifiers::None,
-					Input::KeyState::Up,
-					code,
-					0.0f,
-					key.starts_with('+') ? 1 :
-					(key.starts_with('-') ? -1 : 0)
-				});
-			}
-
-			states.emplace_back(&s_input_map.at(key));
+			states.emplace_back(RegisterInputState(key, code));
 		}
 
-		s_input_binds.emplace(name, new ActionBinding { std::move(states) }); // NOLINT: Cleaned up by Input::Dispose
+		s_input_binds.emplace(name, BindingEntry { false, static_cast<uint32_t>(s_actions.size()) });
+		s_actions.push_back(ActionBinding { std::move(states) });
+		s_action_states.push_back(Input::KeyState::Up);
+		s_action_timestamps.push_back(0.0);
 
-		return true; // NOLINT: Cleaned up by Input::Dispose
+		return true;
+	}
+	bool Input::SetAxisMultiplier(const std::string& name, const float multiplier) {
+		const auto axis = FindAxis(name);
+		if (!axis) {
+			return false;
+		}
+		s_axes[axis.index].multiplier = multiplier;
+		return true;
 	}
 
-	Input::KeyState Input::ActionState(const std::string& name) {
-		if (s_input_binds.contains(name)) {
-			return s_input_binds.at(name)->keystate();
+	Input::ActionHandle Input::FindAction(const std::string& name) {
+		if (const auto it = s_input_binds.find(name); it != s_input_binds.end() && !it->second.is_axis) {
+			return ActionHandle { it->second.index };
 		}
-		return Input::KeyState::Invalid;
+		return ActionHandle { };
 	}
-	bool Input::ActionPressed(const std::string& name) {
-		return ActionState(name) == Input::KeyState::Pressed;
+	Input::AxisHandle Input::FindAxis(const std::string& name) {
+		if (const auto it = s_input_binds.find(name); it != s_input_binds.end() && it->second.is_axis) {
+			return AxisHandle { it->second.index };
+		}
+		return AxisHandle { };
 	}
 
-	bool Input::ActionPressedOrDown(const std::string& name) {
-		const auto state = ActionState(name);
+	Input::KeyState Input::ActionState(const ActionHandle action) {
+		if (action.index < s_action_states.size()) {
+			return s_action_states[action.index];
+		}
+		return Input::KeyState::Invalid;
+	}
+	bool Input::ActionPressed(const ActionHandle action) {
+		return ActionState(action) == Input::KeyState::Pressed;
+	}
+	bool Input::ActionPressedOrDown(const ActionHandle action) {
+		const auto state = ActionState(action);
 		return state == Input::KeyState::Pressed || state == Input::KeyState::Down;
 	}
+	bool Input::ActionDown(const ActionHandle action) {
+		return ActionState(action) == Input::KeyState::Down;
+	}
+	bool Input::ActionReleased(const ActionHandle action) {
+		return ActionState(action) == Input::KeyState::Released;
+	}
+	bool Input::ActionReleasedOrUp(const ActionHandle action) {
+		const auto state = ActionState(action);
+		return state == Input::KeyState::Released || state == Input::KeyState::Up;
+	}
+	bool Input::ActionUp(const ActionHandle action) {
+		return ActionState(action) == Input::KeyState::Up;
+	}
+	double Input::ActionTimestamp(const ActionHandle action) {
+		if (action.index < s_action_timestamps.size()) {
+			return s_action_timestamps[action.index];
+		}
+		return 0.0;
+	}
+	float Input::AxisValue(const AxisHandle axis) {
+		if (axis.index < s_axis_values.size()) {
+			return s_axis_values[axis.index];
+		}
+		return 0.0f;
+	}
+	Vector2 Input::Vector2Value(const AxisHandle axis_x, const AxisHandle axis_y) {
+		return Vector2 { AxisValue(axis_x), AxisValue(axis_y) };
+	}
+	Vector3 Input::Vector3Value(const AxisHandle axis_x, const AxisHandle axis_y, const AxisHandle axis_z) {
+		return Vector3 { AxisValue(axis_x), AxisValue(axis_y), AxisValue(axis_z) };
+	}
 
+	Input::KeyState Input::ActionState(const std::string& name) {
+		return ActionState(FindAction(name));
+	}
+	bool Input::ActionPressed(const std::string& name) {
+		return ActionPressed(FindAction(name));
+	}
+	bool Input::ActionPressedOrDown(const std::string& name) {
+		return ActionPressedOrDown(FindAction(name));
+	}
 	bool Input::ActionDown(const std::string& name) {
-		return ActionState(name) == Input::KeyState::Down;
+		return ActionDown(FindAction(name));
 	}
 	bool Input::ActionReleased(const std::string& name) {
-		return ActionState(name) == Input::KeyState::Released;
+		return ActionReleased(FindAction(name));
 	}
-
 	bool Input::ActionReleasedOrUp(const std::string& name) {
-		const auto state = ActionState(name);
-		return state == Input::KeyState::Released || state == Input::KeyState::Up;
+		return ActionReleasedOrUp(FindAction(name));
 	}
-
 	bool Input::ActionUp(const std::string& name) {
-		return ActionState(name) == Input::KeyState::Up;
-		
+		return ActionUp(FindAction(name));
+	}
+	double Input::ActionTimestamp(const std::string& name) {
+		return ActionTimestamp(FindAction(name));
 	}
 	float Input::AxisValue(const std::string& name) {
-		if (s_input_binds.contains(name)) {
-			return s_input_binds.at(name)->value();
-		}
-		return 0.0f;
+		return AxisValue(FindAxis(name));
 	}
 	Vector2 Input::Vector2Value(const std::string& name_x, const std::string& name_y) {
 		return Vector2 { AxisValue(name_x), AxisValue(name_y) };
@@ -422,25 +609,23 @@ namespace gctk {
 		ofs << "#keymap_version " << KEYMAP_VERSION << std::endl;
 
 		for (const auto& [ name, binding ] : s_input_binds) {
-			if (binding->is_axis()) {
-				auto axis = dynamic_cast<const AxisBinding*>(binding);
-				AssertThrow(axis != nullptr, "Failed to get axis binding data!");
+			if (binding.is_axis) {
+				const auto& axis = s_axes.at(binding.index);
 				ofs << "bind_axis " << name;
-				for (const auto& [ neg, pos ] : axis->states) {
-					ofs << " " << KeycodeToString(neg->keycode) << " " << KeycodeToString(pos->keycode);
+				for (const auto& [ neg, pos ] : axis.states) {
+					ofs << " " << KeycodeToString(s_input_states[neg].keycode) << " " << KeycodeToString(s_input_states[pos].keycode);
 				}
 
 				ofs << std::endl;
 
-				if (axis->multiplier != 1.0f) {
-					ofs << "bindmult " << name << " " << axis->multiplier << std::endl;
+				if (axis.multiplier != 1.0f) {
+					ofs << "bind_mult " << name << " " << axis.multiplier << std::endl;
 				}
 			} else {
-				auto action = dynamic_cast<const ActionBinding*>(binding);
-				AssertThrow(action != nullptr, "Failed to get action binding data!");
+				const auto& action = s_actions.at(binding.index);
 				ofs << "bind " << name;
-				for (const auto& key : action->states) {
-					ofs << " " << KeycodeToString(key->keycode);
+				for (const auto& key : action.states) {
+					ofs << " " << KeycodeToString(s_input_states[key].keycode);
 				}
 				ofs << std::endl;
 			}
@@ -887,6 +1072,124 @@ namespace gctk {
 		}
 	}
 
+	static void PushInputEvent(const int keycode, const uint8_t device_id, const float value) {
+		if (keycode < 0 || keycode >= KEYCODE_COUNT) {
+			return;
+		}
+		if (!s_input_events.try_push(InputEvent { Time::CurrentTime(), keycode, device_id, value })) {
+			s_dropped_events.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	static uint32_t RegisterInputState(const std::string& key, const int keycode) {
+		if (const auto it = s_input_map.find(key); it != s_input_map.end()) {
+			return it->second;
+		}
+
+		const auto index = static_cast<uint32_t>(s_input_states.size());
+		s_input_states.push_back(InputState {
+			KeycodeToInputType(keycode),
+			0,
+			Input::Modifiers::None,
+			Input::KeyState::Up,
+			keycode,
+			0.0f,
+			key.starts_with('+') ? 1 :
+			(key.starts_with('-') ? -1 : 0),
+			false,
+			0.0
+		});
+		s_input_map.emplace(key, index);
+		return index;
+	}
+
+	static void UpdateAnalogState(InputState& key_state_in, const float value) {
+		const auto delta = value - key_state_in.value;
+		key_state_in.value = value;
+
+		const auto pressed = key_state_in.direction == 0 ?
+								  delta != 0.0f :
+								  static_cast<int>(Math::Sign(delta)) == key_state_in.direction;
+		UpdateKeyState(key_state_in, pressed);
+	}
+
+	static void WriteRecordingFrame() {
+		struct RecordedChange {
+			uint16_t keycode;
+			uint8_t device_id;
+			float value;
+		};
+		static std::vector<RecordedChange> changes;
+		changes.clear();
+
+		for (int device = 0; device <= GLFW_JOYSTICK_LAST; ++device) {
+			for (int keycode = 0; keycode < KEYCODE_COUNT; ++keycode) {
+				const auto value = s_raw_values[device][keycode];
+				const auto tapped = s_raw_tapped[device][keycode];
+				if (value != s_recorded_values[device][keycode] || tapped) {
+					changes.push_back(RecordedChange {
+						static_cast<uint16_t>(keycode),
+						static_cast<uint8_t>(device | (tapped ? INPUT_RECORDING_TAPPED_BIT : 0)),
+						value
+					});
+					s_recorded_values[device][keycode] = value;
+				}
+			}
+		}
+
+		const auto count = static_cast<uint16_t>(changes.size());
+		s_record_stream.write(reinterpret_cast<const char*>(&count), 2);
+		for (const auto& change : changes) {
+			s_record_stream.write(reinterpret_cast<const char*>(&change.keycode), 2);
+			s_record_stream.write(reinterpret_cast<const char*>(&change.device_id), 1);
+			s_record_stream.write(reinterpret_cast<const char*>(&change.value), 4);
+		}
+
+		if (!s_record_stream) {
+			LogErr("Failed to write input recording, recording stopped");
+			Input::StopRecording();
+		}
+	}
+	static void ReadReplayFrame() {
+		uint16_t count;
+		if (!s_replay_stream.read(reinterpret_cast<char*>(&count), 2)) {
+			LogInfo("Input replay finished after {} frames", s_replay_frame);
+			Input::StopReplay();
+			if (in_replay_exit.get_boolean() && s_window != nullptr) {
+				glfwSetWindowShouldClose(s_window, GLFW_TRUE);
+			}
+			return;
+		}
+
+		const auto timestamp = Time::CurrentTime();
+		for (uint16_t i = 0; i < count; ++i) {
+			uint16_t keycode;
+			uint8_t device_id;
+			float value;
+			s_replay_stream.read(reinterpret_cast<char*>(&keycode), 2);
+			s_replay_stream.read(reinterpret_cast<char*>(&device_id), 1);
+			s_replay_stream.read(reinterpret_cast<char*>(&value), 4);
+
+			const auto device = device_id & ~INPUT_RECORDING_TAPPED_BIT;
+			if (!s_replay_stream || keycode >= KEYCODE_COUNT || device > GLFW_JOYSTICK_LAST) {
+				LogErr("Input replay is corrupted at frame {}, replay stopped", s_replay_frame);
+				Input::StopReplay();
+				return;
+			}
+
+			s_raw_values[device][keycode] = value;
+			s_raw_tapped[device][keycode] = (device_id & INPUT_RECORDING_TAPPED_BIT) != 0;
+			s_raw_timestamps[device][keycode] = timestamp;
+		}
+		++s_replay_frame;
+	}
+	static Path ResolveRecordingPath(const std::string& value) {
+		if (const Path path = value; path.is_absolute()) {
+			return path;
+		}
+		return Paths::UserDataPath() / value;
+	}
+
 	void _cmd_bind_mult(const std::vector<std::string>& args) {
 		AssertThrow(args.size() >= 2, "Expected 2 or more arguments, got {}", args.size());
 		const auto& name = args.at(0);
@@ -902,10 +1205,7 @@ namespace gctk {
 			return;
 		}
 
-		if (s_input_binds.at(name)->is_axis()) {
-			const auto axis = dynamic_cast<AxisBinding*>(s_input_binds.at(name));
-			axis->multiplier = value;
-		} else {
+		if (!Input::SetAxisMultiplier(name, value)) {
 			LogWarn("Cannot set multiplier of action \"{}\"", name);
 		}
 	}
@@ -32,16 +32,64 @@ namespace gctk::Input {
 		};
 	}
 
+	struct ActionHandle {
+		uint32_t index = InvalidIndex;
+
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		[[nodiscard]] constexpr bool is_valid() const noexcept { return index != InvalidIndex; }
+		[[nodiscard]] constexpr explicit operator bool() const noexcept { return index != InvalidIndex; }
+		[[nodiscard]] constexpr bool operator== (const ActionHandle& other) const { return index == other.index; }
+	};
+	struct AxisHandle {
+		uint32_t index = InvalidIndex;
+
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		[[nodiscard]] constexpr bool is_valid() const noexcept { return index != InvalidIndex; }
+		[[nodiscard]] constexpr explicit operator bool() const noexcept { return index != InvalidIndex; }
+		[[nodiscard]] constexpr bool operator== (const AxisHandle& other) const { return index == other.index; }
+	};
+
 	void Initialize(const Client& client);
 	void Poll();
 	void Dispose();
 
+	// Pumps window events and samples gamepads into the timestamped input event queue, main thread only.
+	// With in_sample_rate set to 0 this is done by Poll, otherwise the launcher calls it at that rate.
+	void Sample();
+	double SampleRate();
+
+	// Recordings hold the per-frame raw input changes, while replaying Poll reads them instead of live input
+	bool StartRecording(const Path& path);
+	void StopRecording();
+	bool StartReplay(const Path& path);
+	void StopReplay();
+	bool IsRecording();
+	bool IsReplaying();
+
 	bool CreateAxis(const std::string& name, const std::initializer_list<std::pair<std::string, std::string>>& pairs);
 	bool CreateAxis(const std::string& name, std::vector<std::pair<std::string, std::string>>&& pairs);
 	bool CreateAction(const std::string& name, const std::initializer_list<std::string>& keys);
 	bool CreateAction(const std::string& name, std::vector<std::string>&& keys);
 	bool SetAxisMultiplier(const std::string& name, float multiplier);
 
+	// Handles are resolved once and stay valid until Input::Dispose, querying them is a plain array lookup
+	ActionHandle FindAction(const std::string& name);
+	AxisHandle FindAxis(const std::string& name);
+
+	KeyState ActionState(ActionHandle action);
+	bool ActionPressed(ActionHandle action);
+	bool ActionPressedOrDown(ActionHandle action);
+	bool ActionDown(ActionHandle action);
+	bool ActionReleased(ActionHandle action);
+	bool ActionReleasedOrUp(ActionHandle action);
+	bool ActionUp(ActionHandle action);
+	double ActionTimestamp(ActionHandle action);
+	float AxisValue(AxisHandle axis);
+	Vector2 Vector2Value(AxisHandle axis_x, AxisHandle axis_y);
+	Vector3 Vector3Value(AxisHandle axis_x, AxisHandle axis_y, AxisHandle axis_z);
+
 	KeyState ActionState(const std::string& name);
 	bool ActionPressed(const std::string& name);
 	bool ActionPressedOrDown(const std::string& name);
@@ -49,6 +97,7 @@ namespace gctk::Input {
 	bool ActionReleased(const std::string& name);
 	bool ActionReleasedOrUp(const std::string& name);
 	bool ActionUp(const std::string& name);
+	double ActionTimestamp(const std::string& name);
 	float AxisValue(const std::string& name);
 	Vector2 Vector2Value(const std::string& name_x, const std::string& name_y);
 	Vector3 Vector3Value(const std::string& name_x, const std::string& name_y, const std::string& name_z);
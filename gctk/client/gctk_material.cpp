@@ -0,0 +1,498 @@
+#include "gctk_material.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include "gctk_asset.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_gl_state.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static constexpr uint32_t INITIAL_MATERIAL_BUFFER_SIZE = 64 * 1024;
+
+	static constexpr uint32_t SORT_QUEUE_SHIFT = 62;
+	static constexpr uint32_t SORT_SHADER_SHIFT = 46;
+	static constexpr uint32_t SORT_TEXTURE_SHIFT = 22;
+	static constexpr uint64_t SORT_SHADER_MASK = 0xFFFF;
+	static constexpr uint64_t SORT_TEXTURE_MASK = 0xFFFFFF;
+	static constexpr uint64_t SORT_ID_MASK = 0x3FFFFF;
+
+	// Every material owns a range of one uniform buffer, so switching materials only rebinds a range
+	static struct {
+		GLuint buffer;
+		uint32_t capacity;
+		uint32_t alignment;
+		std::vector<std::pair<uint32_t, uint32_t>> free_ranges;
+	} s_material_buffer = { 0, 0, 0, { } };
+
+	static std::atomic<uint32_t> s_next_material_id = 1;
+	static std::unordered_map<std::string, std::weak_ptr<Material>> s_materials;
+	static std::unordered_map<std::string, std::weak_ptr<Texture>> s_textures;
+
+	static uint32_t AlignUp(const uint32_t value, const uint32_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static void GrowMaterialBuffer(const uint32_t required) {
+		if (s_material_buffer.alignment == 0) {
+			GLint alignment = 256;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			s_material_buffer.alignment = static_cast<uint32_t>(std::max(alignment, 16));
+		}
+
+		uint32_t capacity = std::max(s_material_buffer.capacity * 2, INITIAL_MATERIAL_BUFFER_SIZE);
+		while (capacity < s_material_buffer.capacity + required) {
+			capacity *= 2;
+		}
+
+		GLuint buffer;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		if (s_material_buffer.buffer != 0) {
+			glCopyNamedBufferSubData(s_material_buffer.buffer, buffer, 0, 0, s_material_buffer.capacity);
+			GLState::ForgetBuffer(s_material_buffer.buffer);
+			glDeleteBuffers(1, &s_material_buffer.buffer);
+		}
+
+		auto& ranges = s_material_buffer.free_ranges;
+		if (!ranges.empty() && ranges.back().first + ranges.back().second == s_material_buffer.capacity) {
+			ranges.back().second += capacity - s_material_buffer.capacity;
+		} else {
+			ranges.emplace_back(s_material_buffer.capacity, capacity - s_material_buffer.capacity);
+		}
+		s_material_buffer.buffer = buffer;
+		s_material_buffer.capacity = capacity;
+	}
+	static uint32_t AllocateBlock(const uint32_t size) {
+		const uint32_t aligned_size = AlignUp(size, std::max(s_material_buffer.alignment, 16u));
+		for (int attempt = 0; attempt < 2; ++attempt) {
+			auto& ranges = s_material_buffer.free_ranges;
+			for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+				if (it->second >= aligned_size) {
+					const uint32_t offset = it->first;
+					it->first += aligned_size;
+					it->second -= aligned_size;
+					if (it->second == 0) {
+						ranges.erase(it);
+					}
+					return offset;
+				}
+			}
+			GrowMaterialBuffer(aligned_size);
+		}
+		FatalError("Failed to allocate {} bytes in the material buffer", size);
+		return 0;
+	}
+	static void FreeBlock(const uint32_t offset, const uint32_t size) {
+		const uint32_t aligned_size = AlignUp(size, std::max(s_material_buffer.alignment, 16u));
+		auto& ranges = s_material_buffer.free_ranges;
+		auto it = std::ranges::lower_bound(ranges, offset, { }, &std::pair<uint32_t, uint32_t>::first);
+		it = ranges.emplace(it, offset, aligned_size);
+
+		// Merge with the neighbours
+		if (auto next = it + 1; next != ranges.end() && it->first + it->second == next->first) {
+			it->second += next->second;
+			ranges.erase(next);
+		}
+		if (it != ranges.begin()) {
+			if (auto prev = it - 1; prev->first + prev->second == it->first) {
+				prev->second += it->second;
+				ranges.erase(it);
+			}
+		}
+	}
+
+	// std140 base alignment and size
+	static std::pair<uint32_t, uint32_t> Std140Layout(const MaterialParameterType type) {
+		switch (type) {
+			case MaterialParameterType::Float:
+			case MaterialParameterType::Int:
+			case MaterialParameterType::Bool: return { 4, 4 };
+			case MaterialParameterType::Vector2: return { 8, 8 };
+			case MaterialParameterType::Vector3: return { 16, 12 };
+			case MaterialParameterType::Vector4:
+			case MaterialParameterType::Color: return { 16, 16 };
+			case MaterialParameterType::Matrix4: return { 16, 64 };
+		}
+		return { 4, 4 };
+	}
+	static bool ParseParameterType(const std::string& name, MaterialParameterType& out) {
+		static const std::unordered_map<std::string, MaterialParameterType> types = {
+			{ "float", MaterialParameterType::Float },
+			{ "int", MaterialParameterType::Int },
+			{ "bool", MaterialParameterType::Bool },
+			{ "vec2", MaterialParameterType::Vector2 },
+			{ "vec3", MaterialParameterType::Vector3 },
+			{ "vec4", MaterialParameterType::Vector4 },
+			{ "color", MaterialParameterType::Color },
+			{ "mat4", MaterialParameterType::Matrix4 }
+		};
+		const auto it = types.find(StringUtil::ToLower(name));
+		if (it == types.end()) {
+			return false;
+		}
+		out = it->second;
+		return true;
+	}
+	static bool ParseTextureTarget(const std::string& name, GLenum& out) {
+		static const std::unordered_map<std::string, GLenum> targets = {
+			{ "1d", GL_TEXTURE_1D },
+			{ "1d_array", GL_TEXTURE_1D_ARRAY },
+			{ "2d", GL_TEXTURE_2D },
+			{ "2d_array", GL_TEXTURE_2D_ARRAY },
+			{ "3d", GL_TEXTURE_3D },
+			{ "cube", GL_TEXTURE_CUBE_MAP },
+			{ "cube_array", GL_TEXTURE_CUBE_MAP_ARRAY }
+		};
+		const auto it = targets.find(StringUtil::ToLower(name));
+		if (it == targets.end()) {
+			return false;
+		}
+		out = it->second;
+		return true;
+	}
+
+	static TextureRef LoadTexture(const GLenum target, const std::string& path) {
+		if (const auto it = s_textures.find(path); it != s_textures.end()) {
+			if (auto texture = it->second.lock(); texture != nullptr && texture->target() == target) {
+				return texture;
+			}
+		}
+
+		TextureRef texture;
+		switch (target) {
+			case GL_TEXTURE_1D: texture = MakePooled<Texture1D>(); break;
+			case GL_TEXTURE_1D_ARRAY: texture = MakePooled<Texture1DArray>(); break;
+			case GL_TEXTURE_2D_ARRAY: texture = MakePooled<Texture2DArray>(); break;
+			case GL_TEXTURE_3D: texture = MakePooled<Texture3D>(); break;
+			case GL_TEXTURE_CUBE_MAP: texture = MakePooled<TextureCubeMap>(); break;
+			case GL_TEXTURE_CUBE_MAP_ARRAY: texture = MakePooled<TextureCubeMapArray>(); break;
+			default: texture = MakePooled<Texture2D>(); break;
+		}
+		if (!texture->load(path)) {
+			return nullptr;
+		}
+		s_textures[path] = texture;
+		return texture;
+	}
+
+	Material::Material() :
+		m_uBlockOffset(0), m_uBlockSize(0), m_uId(s_next_material_id++ & SORT_ID_MASK), m_uSortKey(0),
+		m_eQueue(MaterialQueue::Opaque) {
+	}
+	Material::~Material() {
+		release_block();
+	}
+
+	void Material::release_block() {
+		if (m_uBlockSize > 0) {
+			GLContext::Post([offset = m_uBlockOffset, size = m_uBlockSize]() { FreeBlock(offset, size); });
+			m_uBlockSize = 0;
+		}
+	}
+
+	bool Material::load(const std::string& path) {
+		const auto asset = Asset::Load(path);
+		if (asset == nullptr) {
+			LogErr("Could not load material \"{}\": Asset not found", path);
+			return false;
+		}
+		if (asset->type() != AssetType::Material) {
+			LogErr("Could not load material \"{}\": Asset is not a material", path);
+			return false;
+		}
+
+		ShaderRef shader;
+		std::vector<std::pair<std::string, TextureRef>> textures;
+		std::vector<std::pair<MaterialParameter, std::string>> parameters;
+		auto queue = MaterialQueue::Opaque;
+
+		const std::string source(static_cast<const char*>(asset->data()), asset->size());
+		std::string group;
+		size_t line_number = 0;
+		for (const auto& line : StringUtil::SplitLines(source)) {
+			++line_number;
+			const auto trimmed = StringUtil::Trim(line);
+			if (trimmed.empty() || trimmed.starts_with(';') || trimmed.starts_with('#')) {
+				continue;
+			}
+			if (trimmed.starts_with('[') && trimmed.ends_with(']')) {
+				group = StringUtil::ToLower(StringUtil::Trim(trimmed.substr(1, trimmed.size() - 2)));
+				continue;
+			}
+
+			const auto separator = trimmed.find('=');
+			if (separator == std::string::npos) {
+				LogErr("Could not load material \"{}\": Expected \"key = value\" at line {}", path, line_number);
+				return false;
+			}
+			const auto key = StringUtil::Trim(trimmed.substr(0, separator));
+			const auto value = StringUtil::Trim(trimmed.substr(separator + 1));
+
+			if (group == "material") {
+				if (key == "shader") {
+					shader = Shader::Load(value);
+					if (shader == nullptr) {
+						LogErr("Could not load material \"{}\": Failed to load shader \"{}\"", path, value);
+						return false;
+					}
+				} else if (key == "queue") {
+					const auto name = StringUtil::ToLower(value);
+					if (name == "opaque") {
+						queue = MaterialQueue::Opaque;
+					} else if (name == "alpha_test") {
+						queue = MaterialQueue::AlphaTest;
+					} else if (name == "transparent") {
+						queue = MaterialQueue::Transparent;
+					} else if (name == "overlay") {
+						queue = MaterialQueue::Overlay;
+					} else {
+						LogErr("Could not load material \"{}\": Unknown queue \"{}\" at line {}", path, value, line_number);
+						return false;
+					}
+				} else {
+					LogWarn("Material \"{}\": Unknown key \"{}\" at line {}", path, key, line_number);
+				}
+			} else if (group == "textures") {
+				std::istringstream ss(value);
+				std::string first, second;
+				ss >> first >> second;
+				GLenum target = GL_TEXTURE_2D;
+				std::string texture_path = first;
+				if (!second.empty()) {
+					if (!ParseTextureTarget(first, target)) {
+						LogErr("Could not load material \"{}\": Unknown texture type \"{}\" at line {}", path, first, line_number);
+						return false;
+					}
+					texture_path = second;
+				}
+				auto texture = LoadTexture(target, texture_path);
+				if (texture == nullptr) {
+					LogErr("Could not load material \"{}\": Failed to load texture \"{}\"", path, texture_path);
+					return false;
+				}
+				textures.emplace_back(key, std::move(texture));
+			} else if (group == "parameters") {
+				const auto type_end = value.find_first_of(" \t");
+				MaterialParameter parameter { key, MaterialParameterType::Float, 0 };
+				if (!ParseParameterType(value.substr(0, type_end), parameter.type)) {
+					LogErr("Could not load material \"{}\": Unknown parameter type at line {}", path, line_number);
+					return false;
+				}
+				parameters.emplace_back(parameter, type_end == std::string::npos ? "" : StringUtil::Trim(value.substr(type_end)));
+			} else {
+				LogWarn("Material \"{}\": Value outside of a known group at line {}", path, line_number);
+			}
+		}
+
+		if (shader == nullptr) {
+			LogErr("Could not load material \"{}\": No shader specified", path);
+			return false;
+		}
+
+		// Lay the parameters out by the std140 rules, in declaration order
+		uint32_t block_size = 0;
+		for (auto& [ parameter, _ ] : parameters) {
+			const auto [ alignment, size ] = Std140Layout(parameter.type);
+			parameter.offset = AlignUp(block_size, alignment);
+			block_size = parameter.offset + size;
+		}
+		block_size = AlignUp(block_size, 16);
+
+		const GLuint program = shader->id();
+		GLContext::Run([&]() {
+			if (const GLuint block = glGetUniformBlockIndex(program, "Material"); block != GL_INVALID_INDEX) {
+				GLint shader_size = 0;
+				glGetActiveUniformBlockiv(program, block, GL_UNIFORM_BLOCK_DATA_SIZE, &shader_size);
+				if (static_cast<uint32_t>(shader_size) != block_size) {
+					LogWarn("Material \"{}\": Parameters take {} bytes, but the Material block of \"{}\" has {}",
+						path, block_size, shader->name(), shader_size
+					);
+				}
+				glUniformBlockBinding(program, block, BlockBinding);
+			}
+			for (size_t i = 0; i < textures.size(); ++i) {
+				if (const auto location = shader->uniform_location(textures[i].first); location >= 0) {
+					glProgramUniform1i(program, location, static_cast<GLint>(i));
+				}
+			}
+		});
+
+		release_block();
+		m_pShader = std::move(shader);
+		m_eQueue = queue;
+		m_textures.clear();
+		for (auto& [ _, texture ] : textures) {
+			m_textures.push_back(std::move(texture));
+		}
+		m_parameters.clear();
+		m_data.assign(block_size, 0);
+
+		for (const auto& [ parameter, text ] : parameters) {
+			m_parameters.push_back(parameter);
+			bool parsed = true;
+			switch (parameter.type) {
+				case MaterialParameterType::Float: {
+					float value;
+					parsed = StringUtil::ParseFloat(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Int: {
+					int32_t value;
+					parsed = StringUtil::ParseInt(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Bool: {
+					bool value;
+					parsed = StringUtil::ParseBool(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Vector2: {
+					Vector2 value;
+					parsed = StringUtil::ParseVector2(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Vector3: {
+					Vector3 value;
+					parsed = StringUtil::ParseVector3(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Vector4: {
+					Vector4 value;
+					parsed = StringUtil::ParseVector4(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Color: {
+					Color value;
+					parsed = StringUtil::ParseColor(text, value) && set(parameter.name, value);
+				} break;
+				case MaterialParameterType::Matrix4: {
+					Matrix4 value;
+					parsed = StringUtil::ParseMatrix4(text, value) && set(parameter.name, value);
+				} break;
+			}
+			if (!parsed) {
+				LogWarn("Material \"{}\": Failed to parse value of parameter \"{}\", using zero", path, parameter.name);
+			}
+		}
+		// The parameters are uploaded as a whole once they are parsed, set only uploads after that
+		m_uBlockSize = block_size;
+		if (block_size > 0) {
+			// The buffer may have to grow, and the free ranges are only touched on the GL thread
+			GLContext::Run([&]() {
+				m_uBlockOffset = AllocateBlock(block_size);
+				glNamedBufferSubData(s_material_buffer.buffer, m_uBlockOffset, m_uBlockSize, m_data.data());
+			});
+		}
+
+		update_sort_key();
+		return true;
+	}
+
+	bool Material::write_parameter(const std::string& name, const MaterialParameterType type, const void* value, const uint32_t size) {
+		for (const auto& parameter : m_parameters) {
+			if (parameter.name == name) {
+				if (parameter.type != type) {
+					LogErr("Material parameter \"{}\" has a different type", name);
+					return false;
+				}
+				memcpy(m_data.data() + parameter.offset, value, size);
+				if (m_uBlockSize > 0) {
+					// apply() runs on the GL thread, so it gets a copy of the value instead of reading m_data
+					std::vector<uint8_t> bytes(static_cast<const uint8_t*>(value), static_cast<const uint8_t*>(value) + size);
+					GLContext::Post([offset = m_uBlockOffset + parameter.offset, bytes = std::move(bytes)]() {
+						glNamedBufferSubData(s_material_buffer.buffer, offset, static_cast<GLsizeiptr>(bytes.size()), bytes.data());
+					});
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Material::set(const std::string& name, const float value) {
+		return write_parameter(name, MaterialParameterType::Float, &value, sizeof(value));
+	}
+	bool Material::set(const std::string& name, const int32_t value) {
+		return write_parameter(name, MaterialParameterType::Int, &value, sizeof(value));
+	}
+	bool Material::set(const std::string& name, const bool value) {
+		const uint32_t word = value ? 1 : 0;
+		return write_parameter(name, MaterialParameterType::Bool, &word, sizeof(word));
+	}
+	bool Material::set(const std::string& name, const Vector2& value) {
+		const float items[2] = { value.x, value.y };
+		return write_parameter(name, MaterialParameterType::Vector2, items, sizeof(items));
+	}
+	bool Material::set(const std::string& name, const Vector3& value) {
+		const float items[3] = { value.x, value.y, value.z };
+		return write_parameter(name, MaterialParameterType::Vector3, items, sizeof(items));
+	}
+	bool Material::set(const std::string& name, const Vector4& value) {
+		const float items[4] = { value.x, value.y, value.z, value.w };
+		return write_parameter(name, MaterialParameterType::Vector4, items, sizeof(items));
+	}
+	bool Material::set(const std::string& name, const Color& value) {
+		const float items[4] = { value.r, value.g, value.b, value.a };
+		return write_parameter(name, MaterialParameterType::Color, items, sizeof(items));
+	}
+	bool Material::set(const std::string& name, const Matrix4& value) {
+		// GLSL matrices are column major, Matrix4 stores rows
+		float items[16];
+		for (size_t i = 0; i < 16; ++i) {
+			items[i] = value.item((i % 4) * 4 + i / 4);
+		}
+		return write_parameter(name, MaterialParameterType::Matrix4, items, sizeof(items));
+	}
+
+	void Material::apply() {
+		if (m_pShader == nullptr) {
+			return;
+		}
+		m_pShader->apply();
+		for (size_t i = 0; i < m_textures.size(); ++i) {
+			GLState::BindTextureUnit(static_cast<GLuint>(i), m_textures[i]->id());
+		}
+		if (m_uBlockSize > 0) {
+			GLState::BindBufferRange(GL_UNIFORM_BUFFER, BlockBinding, s_material_buffer.buffer, m_uBlockOffset, m_uBlockSize);
+		}
+	}
+
+	void Material::update_sort_key() {
+		uint64_t texture_hash = 14695981039346656037ull;
+		for (const auto& texture : m_textures) {
+			const GLuint id = texture->id();
+			texture_hash = StringUtil::Hash(std::string_view(reinterpret_cast<const char*>(&id), sizeof(id)), texture_hash);
+		}
+		m_uSortKey = static_cast<uint64_t>(m_eQueue) << SORT_QUEUE_SHIFT |
+			(static_cast<uint64_t>(m_pShader->id()) & SORT_SHADER_MASK) << SORT_SHADER_SHIFT |
+			(m_textures.empty() ? 0 : texture_hash & SORT_TEXTURE_MASK) << SORT_TEXTURE_SHIFT |
+			(m_uId & SORT_ID_MASK);
+	}
+	uint64_t Material::sort_key(const float view_depth) const {
+		if (m_eQueue != MaterialQueue::Transparent) {
+			return m_uSortKey;
+		}
+		// Positive floats order like their bits, invert them for back to front
+		uint32_t depth_bits;
+		const float depth = std::max(view_depth, 0.0f);
+		memcpy(&depth_bits, &depth, sizeof(depth_bits));
+		return static_cast<uint64_t>(m_eQueue) << SORT_QUEUE_SHIFT |
+			static_cast<uint64_t>(~depth_bits) << SORT_TEXTURE_SHIFT |
+			(m_uId & SORT_ID_MASK);
+	}
+
+	MaterialRef Material::Load(const std::string& path) {
+		if (const auto it = s_materials.find(path); it != s_materials.end()) {
+			if (auto material = it->second.lock(); material != nullptr) {
+				return material;
+			}
+		}
+
+		auto material = MakePooled<Material>();
+		if (!material->load(path)) {
+			return nullptr;
+		}
+		s_materials[path] = material;
+		return material;
+	}
+}
\ No newline at end of file
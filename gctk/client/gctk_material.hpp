@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gctk_math.hpp"
+#include "gctk_shader.hpp"
+#include "gctk_texture.hpp"
+
+namespace gctk {
+	enum class MaterialQueue : uint8_t {
+		Opaque,
+		AlphaTest,
+		Transparent,
+		Overlay
+	};
+	enum class MaterialParameterType : uint8_t {
+		Float,
+		Int,
+		Bool,
+		Vector2,
+		Vector3,
+		Vector4,
+		Color,
+		Matrix4
+	};
+
+	struct MaterialParameter {
+		std::string name;
+		MaterialParameterType type;
+		uint32_t offset;
+	};
+
+	class Material;
+	using MaterialRef = std::shared_ptr<Material>;
+
+	class Material {
+		ShaderRef m_pShader;
+		std::vector<TextureRef> m_textures;
+		std::vector<MaterialParameter> m_parameters;
+		std::vector<uint8_t> m_data;
+		uint32_t m_uBlockOffset;
+		uint32_t m_uBlockSize;
+		uint32_t m_uId;
+		uint64_t m_uSortKey;
+		MaterialQueue m_eQueue;
+
+		void release_block();
+		void update_sort_key();
+		bool write_parameter(const std::string& name, MaterialParameterType type, const void* value, uint32_t size);
+	public:
+		// Uniform block binding point of the "Material" block, declared in the shader as
+		// layout(std140, binding = 1) uniform Material { ... } with the parameters in .gmat order
+		static constexpr GLuint BlockBinding = 1;
+
+		Material();
+		~Material();
+		Material(const Material&) = delete;
+		Material& operator=(const Material&) = delete;
+
+		// Loads a .gmat asset: a [Material] group with shader and queue, [Textures] bound to units in
+		// declaration order and [Parameters] given as "name = <type> <value>"
+		[[nodiscard]] bool load(const std::string& path);
+
+		// Safe to call from the game thread, the new value is uploaded on the GL thread before the next frame's commands run
+		bool set(const std::string& name, float value);
+		bool set(const std::string& name, int32_t value);
+		bool set(const std::string& name, bool value);
+		bool set(const std::string& name, const Vector2& value);
+		bool set(const std::string& name, const Vector3& value);
+		bool set(const std::string& name, const Vector4& value);
+		bool set(const std::string& name, const Color& value);
+		bool set(const std::string& name, const Matrix4& value);
+
+		// Binds the shader, textures and the material's range of the shared uniform buffer
+		void apply();
+
+		[[nodiscard]] constexpr const ShaderRef& shader() const { return m_pShader; }
+		[[nodiscard]] constexpr MaterialQueue queue() const { return m_eQueue; }
+		[[nodiscard]] constexpr const std::vector<MaterialParameter>& parameters() const { return m_parameters; }
+		// Queue, shader, texture set and material in descending significance, so sorted draws switch state as rarely as possible
+		[[nodiscard]] constexpr uint64_t sort_key() const { return m_uSortKey; }
+		// Transparent materials are ordered back to front instead
+		[[nodiscard]] uint64_t sort_key(float view_depth) const;
+
+		// Loaded materials are shared by asset path
+		static MaterialRef Load(const std::string& path);
+	};
+}
\ No newline at end of file
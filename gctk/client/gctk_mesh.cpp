@@ -0,0 +1,134 @@
+#include "gctk_mesh.hpp"
+
+#include <cstring>
+
+#include "gctk_asset.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_gl_state.hpp"
+
+namespace gctk {
+	Mesh::Mesh() :
+		m_uVertexArray(0), m_uVertexBuffer(0), m_uIndexBuffer(0), m_eIndexType(GL_UNSIGNED_SHORT),
+		m_uVertexCount(0), m_uIndexCount(0) {
+	}
+	Mesh::~Mesh() {
+		release();
+	}
+
+	bool Mesh::load(const std::string& path) {
+		const auto asset = Asset::Load(path);
+		if (asset == nullptr) {
+			LogErr("Could not load mesh \"{}\": Asset not found", path);
+			return false;
+		}
+		if (asset->type() != AssetType::Mesh || asset->size() < sizeof(MeshFormat::Header)) {
+			LogErr("Could not load mesh \"{}\": Asset is not a mesh", path);
+			return false;
+		}
+
+		const auto* bytes = static_cast<const uint8_t*>(asset->data());
+		MeshFormat::Header header;
+		memcpy(&header, bytes, sizeof(header));
+		if (memcmp(header.identifier, MeshFormat::Identifier, 4) != 0) {
+			LogErr("Could not load mesh \"{}\": Invalid identifier", path);
+			return false;
+		}
+		if (header.version != MeshFormat::Version || header.vertex_stride != sizeof(MeshFormat::Vertex)) {
+			LogErr("Could not load mesh \"{}\": Unsupported version {}", path, header.version);
+			return false;
+		}
+		// GL rejects zero-sized buffer storage
+		if (header.vertex_count == 0 || header.index_count == 0) {
+			LogErr("Could not load mesh \"{}\": Mesh is empty", path);
+			return false;
+		}
+
+		const size_t index_size = header.flags & MeshFormat::FlagIndices32Bit ? 4 : 2;
+		const size_t vertex_data_size = static_cast<size_t>(header.vertex_count) * header.vertex_stride;
+		const size_t index_data_size = static_cast<size_t>(header.index_count) * index_size;
+		const size_t meshlet_data_size = static_cast<size_t>(header.meshlet_count) * sizeof(MeshFormat::Meshlet);
+		if (header.vertex_data_offset + vertex_data_size > asset->size() ||
+			header.index_data_offset + index_data_size > asset->size() ||
+			header.meshlet_data_offset + meshlet_data_size > asset->size()) {
+			LogErr("Could not load mesh \"{}\": Data blocks are out of range", path);
+			return false;
+		}
+
+		release();
+
+		GLContext::Run([&]() {
+			glCreateBuffers(1, &m_uVertexBuffer);
+			glNamedBufferStorage(m_uVertexBuffer, static_cast<GLsizeiptr>(vertex_data_size), bytes + header.vertex_data_offset, 0);
+			glCreateBuffers(1, &m_uIndexBuffer);
+			glNamedBufferStorage(m_uIndexBuffer, static_cast<GLsizeiptr>(index_data_size), bytes + header.index_data_offset, 0);
+
+			glCreateVertexArrays(1, &m_uVertexArray);
+			glVertexArrayVertexBuffer(m_uVertexArray, 0, m_uVertexBuffer, 0, static_cast<GLsizei>(header.vertex_stride));
+			glVertexArrayElementBuffer(m_uVertexArray, m_uIndexBuffer);
+
+			glEnableVertexArrayAttrib(m_uVertexArray, 0);
+			glVertexArrayAttribFormat(m_uVertexArray, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(MeshFormat::Vertex, position));
+			glVertexArrayAttribBinding(m_uVertexArray, 0, 0);
+			glEnableVertexArrayAttrib(m_uVertexArray, 1);
+			glVertexArrayAttribFormat(m_uVertexArray, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(MeshFormat::Vertex, normal));
+			glVertexArrayAttribBinding(m_uVertexArray, 1, 0);
+			glEnableVertexArrayAttrib(m_uVertexArray, 2);
+			glVertexArrayAttribFormat(m_uVertexArray, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(MeshFormat::Vertex, uv));
+			glVertexArrayAttribBinding(m_uVertexArray, 2, 0);
+		});
+
+		m_eIndexType = index_size == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+		m_uVertexCount = header.vertex_count;
+		m_uIndexCount = header.index_count;
+		m_positionOffset = Vector3 { header.position_offset[0], header.position_offset[1], header.position_offset[2] };
+		m_positionScale = Vector3 { header.position_scale[0], header.position_scale[1], header.position_scale[2] };
+		m_boundsMin = Vector3 { header.bounds_min[0], header.bounds_min[1], header.bounds_min[2] };
+		m_boundsMax = Vector3 { header.bounds_max[0], header.bounds_max[1], header.bounds_max[2] };
+		m_boundingSphere = Vector4 {
+			header.bounding_sphere[0], header.bounding_sphere[1], header.bounding_sphere[2], header.bounding_sphere[3]
+		};
+
+		m_meshlets.resize(header.meshlet_count);
+		if (meshlet_data_size > 0) {
+			memcpy(m_meshlets.data(), bytes + header.meshlet_data_offset, meshlet_data_size);
+		}
+		return true;
+	}
+
+	void Mesh::draw() const {
+		GLState::BindVertexArray(m_uVertexArray);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_uIndexCount), m_eIndexType, nullptr);
+	}
+	void Mesh::draw_meshlet(const size_t index) const {
+		const auto& meshlet = m_meshlets.at(index);
+		const size_t index_size = m_eIndexType == GL_UNSIGNED_INT ? 4 : 2;
+		GLState::BindVertexArray(m_uVertexArray);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(meshlet.index_count), m_eIndexType,
+			reinterpret_cast<const void*>(meshlet.index_offset * index_size)
+		);
+	}
+
+	void Mesh::release() {
+		if (m_uVertexArray != 0 || m_uVertexBuffer != 0 || m_uIndexBuffer != 0) {
+			// The mesh may be gone by the time this runs, so the names are copied
+			GLContext::Post([vertex_array = m_uVertexArray, vertex_buffer = m_uVertexBuffer, index_buffer = m_uIndexBuffer]() {
+				if (vertex_array != 0) {
+					GLState::ForgetVertexArray(vertex_array);
+					glDeleteVertexArrays(1, &vertex_array);
+				}
+				if (vertex_buffer != 0) {
+					GLState::ForgetBuffer(vertex_buffer);
+					glDeleteBuffers(1, &vertex_buffer);
+				}
+				if (index_buffer != 0) {
+					GLState::ForgetBuffer(index_buffer);
+					glDeleteBuffers(1, &index_buffer);
+				}
+			});
+			m_uVertexArray = 0;
+			m_uVertexBuffer = 0;
+			m_uIndexBuffer = 0;
+		}
+		m_meshlets.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gctk_math.hpp"
+#include "gctk_mesh_format.hpp"
+
+namespace gctk {
+	class Mesh {
+		GLuint m_uVertexArray;
+		GLuint m_uVertexBuffer;
+		GLuint m_uIndexBuffer;
+		GLenum m_eIndexType;
+		uint32_t m_uVertexCount;
+		uint32_t m_uIndexCount;
+		Vector3 m_positionOffset;
+		Vector3 m_positionScale;
+		Vector3 m_boundsMin;
+		Vector3 m_boundsMax;
+		Vector4 m_boundingSphere;
+		std::vector<MeshFormat::Meshlet> m_meshlets;
+
+		void release();
+	public:
+		Mesh();
+		~Mesh();
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
+
+		// Loads a .gmdl asset, the vertex and index blocks are uploaded straight from the asset memory
+		[[nodiscard]] bool load(const std::string& path);
+
+		void draw() const;
+		void draw_meshlet(size_t index) const;
+
+		[[nodiscard]] constexpr GLuint vertex_array() const { return m_uVertexArray; }
+		[[nodiscard]] constexpr uint32_t vertex_count() const { return m_uVertexCount; }
+		[[nodiscard]] constexpr uint32_t index_count() const { return m_uIndexCount; }
+		// Vertex shaders have to apply these to the quantized positions
+		[[nodiscard]] constexpr const Vector3& position_offset() const { return m_positionOffset; }
+		[[nodiscard]] constexpr const Vector3& position_scale() const { return m_positionScale; }
+		[[nodiscard]] constexpr const Vector3& bounds_min() const { return m_boundsMin; }
+		[[nodiscard]] constexpr const Vector3& bounds_max() const { return m_boundsMax; }
+		[[nodiscard]] constexpr const Vector4& bounding_sphere() const { return m_boundingSphere; }
+		[[nodiscard]] constexpr const std::vector<MeshFormat::Meshlet>& meshlets() const { return m_meshlets; }
+	};
+}
\ No newline at end of file
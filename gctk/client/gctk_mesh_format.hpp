@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of .gmdl files, shared by the mesh loader and the gmdl cooker tool.
+// All blocks start at 16 byte aligned offsets and are uploaded to GL buffers as they are.
+namespace gctk::MeshFormat {
+	static constexpr uint8_t Identifier[4] = { 'G', 'M', 'D', 'L' };
+	static constexpr uint16_t Version = 1;
+
+	static constexpr uint32_t MaxMeshletVertices = 64;
+	static constexpr uint32_t MaxMeshletTriangles = 124;
+
+	enum Flags : uint16_t {
+		FlagNone         = 0x00,
+		FlagIndices32Bit = 0x01
+	};
+
+	struct Header {
+		uint8_t identifier[4];
+		uint16_t version;
+		uint16_t flags;
+		uint32_t vertex_count;
+		uint32_t index_count;
+		uint32_t meshlet_count;
+		uint32_t vertex_stride;
+
+		// Positions are stored as unorm16 inside the bounding box: position = position_offset + value * position_scale
+		float position_offset[3];
+		float position_scale[3];
+		float bounds_min[3];
+		float bounds_max[3];
+		float bounding_sphere[4];
+
+		uint32_t vertex_data_offset;
+		uint32_t index_data_offset;
+		uint32_t meshlet_data_offset;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Header) == 104);
+
+	// Interleaved, 16 bytes per vertex
+	struct Vertex {
+		uint16_t position[4];  // unorm16 x, y, z, unused
+		uint32_t normal;       // snorm 2_10_10_10_REV
+		uint16_t uv[2];        // half float
+	};
+	static_assert(sizeof(Vertex) == 16);
+
+	// Range of the index buffer with its own bounds, for culling parts of a mesh
+	struct Meshlet {
+		uint32_t index_offset;
+		uint32_t index_count;
+		uint32_t vertex_count;
+		uint32_t reserved;
+		float bounding_sphere[4];
+	};
+	static_assert(sizeof(Meshlet) == 32);
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "gctk_shader.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "gctk_asset.hpp"
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_filesys.hpp"
+#include "gctk_gl_state.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static constexpr uint8_t SHADER_CACHE_IDENTIFIER[4] = { 'G', 'S', 'P', 'B' };
+
+	CVar vid_shader_cache("vid_shader_cache", "true", CVAR_FLAG_USER_DATA);
+
+	static std::unordered_map<std::string, std::weak_ptr<Shader>> s_shaders;
+
+	static bool ParseShaderSource(const std::string& path, const std::string& source, std::vector<ShaderStage>& stages);
+	static GLuint CompileStage(const std::string& name, const ShaderStage& stage);
+	static Path ShaderCachePath(const std::vector<ShaderStage>& stages);
+	static GLuint LoadCachedProgram(const Path& path);
+	static void StoreCachedProgram(const Path& path, GLuint program);
+	static const char* StageName(GLenum type);
+
+	Shader::~Shader() {
+		if (m_uProgram != 0) {
+			GLContext::Post([program = m_uProgram]() {
+				GLState::ForgetProgram(program);
+				glDeleteProgram(program);
+			});
+			m_uProgram = 0;
+		}
+	}
+
+	bool Shader::load(const std::string& path) {
+		const auto asset = Asset::Load(path);
+		if (asset == nullptr) {
+			LogErr("Could not load shader \"{}\": Asset not found", path);
+			return false;
+		}
+		if (asset->type() != AssetType::Shader && asset->type() != AssetType::PlainText) {
+			LogErr("Could not load shader \"{}\": Asset is not a shader", path);
+			return false;
+		}
+
+		std::vector<ShaderStage> stages;
+		if (!ParseShaderSource(path, std::string(static_cast<const char*>(asset->data()), asset->size()), stages)) {
+			return false;
+		}
+		return compile(path, stages);
+	}
+
+	bool Shader::compile(const std::string& name, const std::vector<ShaderStage>& stages) {
+		bool result = false;
+		GLContext::Run([&]() { result = compile_program(name, stages); });
+		return result;
+	}
+	bool Shader::compile_program(const std::string& name, const std::vector<ShaderStage>& stages) {
+		if (m_uProgram != 0) {
+			GLState::ForgetProgram(m_uProgram);
+			glDeleteProgram(m_uProgram);
+			m_uProgram = 0;
+		}
+		m_sName = name;
+
+		GLint binary_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+		const bool use_cache = binary_formats > 0 && vid_shader_cache.get_boolean();
+
+		const auto cache_path = use_cache ? ShaderCachePath(stages) : Path();
+		if (use_cache) {
+			if (const auto program = LoadCachedProgram(cache_path); program != 0) {
+				m_uProgram = program;
+				return true;
+			}
+		}
+
+		std::vector<GLuint> shaders;
+		shaders.reserve(stages.size());
+		for (const auto& stage : stages) {
+			const auto shader = CompileStage(name, stage);
+			if (shader == 0) {
+				for (const auto compiled : shaders) {
+					glDeleteShader(compiled);
+				}
+				return false;
+			}
+			shaders.push_back(shader);
+		}
+
+		const GLuint program = glCreateProgram();
+		if (use_cache) {
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		for (const auto shader : shaders) {
+			glAttachShader(program, shader);
+		}
+		glLinkProgram(program);
+		for (const auto shader : shaders) {
+			glDetachShader(program, shader);
+			glDeleteShader(shader);
+		}
+
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE) {
+			char log[1024];
+			glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+			LogErr("Failed to link shader \"{}\": {}", name, log);
+			glDeleteProgram(program);
+			return false;
+		}
+
+		if (use_cache) {
+			StoreCachedProgram(cache_path, program);
+		}
+		m_uProgram = program;
+		return true;
+	}
+
+	GLint Shader::uniform_location(const std::string& name) const {
+		GLint location = -1;
+		GLContext::Run([&]() { location = glGetUniformLocation(m_uProgram, name.c_str()); });
+		return location;
+	}
+	void Shader::apply() const {
+		GLState::UseProgram(m_uProgram);
+	}
+
+	ShaderRef Shader::Load(const std::string& path) {
+		if (const auto it = s_shaders.find(path); it != s_shaders.end()) {
+			if (auto shader = it->second.lock(); shader != nullptr) {
+				return shader;
+			}
+		}
+
+		auto shader = MakePooled<Shader>();
+		if (!shader->load(path)) {
+			return nullptr;
+		}
+		s_shaders[path] = shader;
+		return shader;
+	}
+
+	static bool ParseShaderSource(const std::string& path, const std::string& source, std::vector<ShaderStage>& stages) {
+		std::string prelude;
+		ShaderStage* current = nullptr;
+		size_t line_number = 0;
+
+		for (const auto& line : StringUtil::SplitLines(source)) {
+			++line_number;
+			const auto trimmed = StringUtil::Trim(line);
+			if (!trimmed.starts_with("#shader")) {
+				auto& target = current != nullptr ? current->source : prelude;
+				target.append(line);
+				target.push_back('\n');
+				// Compile errors should point at lines of the file, #version itself has to stay the first statement
+				if (current == nullptr && trimmed.starts_with("#version")) {
+					target.append(std::format("#line {}\n", line_number + 1));
+				}
+				continue;
+			}
+
+			const auto stage_name = StringUtil::ToLower(StringUtil::Trim(trimmed.substr(strlen("#shader"))));
+			GLenum type;
+			if (stage_name == "vertex") {
+				type = GL_VERTEX_SHADER;
+			} else if (stage_name == "fragment" || stage_name == "pixel") {
+				type = GL_FRAGMENT_SHADER;
+			} else if (stage_name == "geometry") {
+				type = GL_GEOMETRY_SHADER;
+			} else if (stage_name == "tess_control") {
+				type = GL_TESS_CONTROL_SHADER;
+			} else if (stage_name == "tess_evaluation") {
+				type = GL_TESS_EVALUATION_SHADER;
+			} else if (stage_name == "compute") {
+				type = GL_COMPUTE_SHADER;
+			} else {
+				LogErr("Could not load shader \"{}\": Unknown stage \"{}\"", path, stage_name);
+				return false;
+			}
+
+			current = &stages.emplace_back(ShaderStage { type, prelude });
+			current->source.append(std::format("#line {}\n", line_number + 1));
+		}
+
+		if (stages.empty()) {
+			LogErr("Could not load shader \"{}\": No \"#shader\" stages found", path);
+			return false;
+		}
+		return true;
+	}
+
+	static GLuint CompileStage(const std::string& name, const ShaderStage& stage) {
+		const GLuint shader = glCreateShader(stage.type);
+		const char* source = stage.source.c_str();
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint status;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			char log[1024];
+			glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+			LogErr("Failed to compile {} stage of shader \"{}\": {}", StageName(stage.type), name, log);
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+
+	static Path ShaderCachePath(const std::vector<ShaderStage>& stages) {
+		// Binaries are only valid for the driver that produced them, so it is part of the key
+		uint64_t hash = StringUtil::Hash(reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+		hash = StringUtil::Hash(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+		hash = StringUtil::Hash(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+		for (const auto& stage : stages) {
+			hash = StringUtil::Hash(StageName(stage.type), hash);
+			hash = StringUtil::Hash(stage.source, hash);
+		}
+		return Paths::UserDataPath() / "shader_cache" / std::format("{:016x}.bin", hash);
+	}
+
+	static GLuint LoadCachedProgram(const Path& path) {
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs.is_open()) {
+			return 0;
+		}
+
+		uint8_t identifier[4];
+		GLenum format;
+		uint32_t length;
+		ifs.read(reinterpret_cast<char*>(identifier), 4);
+		ifs.read(reinterpret_cast<char*>(&format), 4);
+		ifs.read(reinterpret_cast<char*>(&length), 4);
+		if (!ifs || memcmp(identifier, SHADER_CACHE_IDENTIFIER, 4) != 0 || length == 0) {
+			LogWarn("Ignoring invalid shader cache entry \"{}\"", path);
+			return 0;
+		}
+
+		std::vector<char> binary(length);
+		ifs.read(binary.data(), length);
+		if (!ifs) {
+			LogWarn("Ignoring truncated shader cache entry \"{}\"", path);
+			return 0;
+		}
+
+		const GLuint program = glCreateProgram();
+		glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+
+		// Drivers may still reject a binary after an update, the caller then compiles from source and replaces it
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE) {
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	static void StoreCachedProgram(const Path& path, const GLuint program) {
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return;
+		}
+
+		std::vector<char> binary(length);
+		GLenum format;
+		glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+		std::error_code error;
+		Paths::create_directories(path.parent_path(), error);
+
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs.is_open()) {
+			LogWarn("Failed to write shader cache entry \"{}\"", path);
+			return;
+		}
+
+		const auto size = static_cast<uint32_t>(length);
+		ofs.write(reinterpret_cast<const char*>(SHADER_CACHE_IDENTIFIER), 4);
+		ofs.write(reinterpret_cast<const char*>(&format), 4);
+		ofs.write(reinterpret_cast<const char*>(&size), 4);
+		ofs.write(binary.data(), length);
+	}
+
+	static const char* StageName(const GLenum type) {
+		switch (type) {
+			case GL_VERTEX_SHADER: return "vertex";
+			case GL_FRAGMENT_SHADER: return "fragment";
+			case GL_GEOMETRY_SHADER: return "geometry";
+			case GL_TESS_CONTROL_SHADER: return "tess_control";
+			case GL_TESS_EVALUATION_SHADER: return "tess_evaluation";
+			case GL_COMPUTE_SHADER: return "compute";
+			default: return "unknown";
+		}
+	}
+}
\ No newline at end of file
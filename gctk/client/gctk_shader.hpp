@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace gctk {
+	struct ShaderStage {
+		GLenum type;
+		std::string source;
+	};
+
+	class Shader;
+	using ShaderRef = std::shared_ptr<Shader>;
+
+	class Shader {
+		GLuint m_uProgram;
+		std::string m_sName;
+
+		bool compile_program(const std::string& name, const std::vector<ShaderStage>& stages);
+	public:
+		Shader() : m_uProgram(0) { }
+		~Shader();
+		Shader(const Shader&) = delete;
+		Shader& operator=(const Shader&) = delete;
+
+		// Loads a .gshd or .glsl asset, its stages are separated by "#shader <stage>" lines and
+		// everything before the first one (like the #version line) is prepended to every stage
+		[[nodiscard]] bool load(const std::string& path);
+		// Links the stages, reusing a program binary from the shader cache when the sources and driver match
+		[[nodiscard]] bool compile(const std::string& name, const std::vector<ShaderStage>& stages);
+
+		[[nodiscard]] constexpr GLuint id() const { return m_uProgram; }
+		[[nodiscard]] constexpr const std::string& name() const { return m_sName; }
+		[[nodiscard]] constexpr bool is_valid() const { return m_uProgram != 0; }
+		[[nodiscard]] GLint uniform_location(const std::string& name) const;
+
+		void apply() const;
+
+		// Loaded shaders are shared by asset path
+		static ShaderRef Load(const std::string& path);
+	};
+}
\ No newline at end of file
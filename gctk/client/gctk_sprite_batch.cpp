@@ -0,0 +1,281 @@
+#include <GL/glew.h>
+
+#include "gctk_sprite_batch.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "gctk_debug.hpp"
+#include "gctk_gl_state.hpp"
+#include "gctk_shader.hpp"
+
+namespace gctk {
+	struct SpriteInstance {
+		float rect[4];
+		float uv[4];
+		uint8_t color[4];
+		float layer;
+	};
+
+	static constexpr auto SPRITE_VERTEX_SHADER = R"(#version 460 core
+layout(location = 0) in vec4 a_rect;
+layout(location = 1) in vec4 a_uv;
+layout(location = 2) in vec4 a_color;
+layout(location = 3) in float a_layer;
+
+uniform vec2 u_viewport;
+
+out vec3 v_uv;
+out vec4 v_color;
+
+void main() {
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 position = (a_rect.xy + corner * a_rect.zw) / u_viewport * 2.0 - 1.0;
+	gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+	v_uv = vec3(mix(a_uv.xy, a_uv.zw, corner), a_layer);
+	v_color = a_color;
+}
+)";
+	static constexpr auto SPRITE_FRAGMENT_SHADER_2D = R"(#version 460 core
+in vec3 v_uv;
+in vec4 v_color;
+
+uniform sampler2D u_texture;
+
+out vec4 o_color;
+
+void main() {
+	o_color = texture(u_texture, v_uv.xy) * v_color;
+}
+)";
+	static constexpr auto SPRITE_FRAGMENT_SHADER_ARRAY = R"(#version 460 core
+in vec3 v_uv;
+in vec4 v_color;
+
+uniform sampler2DArray u_texture;
+
+out vec4 o_color;
+
+void main() {
+	o_color = texture(u_texture, v_uv) * v_color;
+}
+)";
+
+	// Sort key layout: order (16 bits) | array texture flag (1 bit) | texture name (24 bits) | sprite index (23 bits)
+	static constexpr uint64_t SPRITE_INDEX_BITS = 23;
+	static constexpr uint64_t SPRITE_TEXTURE_BITS = 24;
+	static constexpr uint64_t SPRITE_INDEX_MASK = (1ull << SPRITE_INDEX_BITS) - 1;
+	static constexpr uint64_t SPRITE_BATCH_SHIFT = SPRITE_INDEX_BITS;
+
+	static void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& buffer, uint32_t first_bit);
+
+	SpriteBatch::SpriteBatch(const uint32_t sprites_per_region) :
+		m_pShader2D(std::make_unique<Shader>()), m_pShaderArray(std::make_unique<Shader>()), m_iViewport2D(-1), m_iViewportArray(-1),
+		m_uVertexArray(0), m_uInstanceBuffer(0), m_uWhiteTexture(0), m_pMappedBuffer(nullptr),
+		m_pRegionFences { }, m_uRegion(0), m_uRegionCapacity(sprites_per_region), m_uDrawCalls(0) {
+		const bool compiled_2d = m_pShader2D->compile("sprite_2d", {
+			ShaderStage { GL_VERTEX_SHADER, SPRITE_VERTEX_SHADER },
+			ShaderStage { GL_FRAGMENT_SHADER, SPRITE_FRAGMENT_SHADER_2D }
+		});
+		const bool compiled_array = m_pShaderArray->compile("sprite_array", {
+			ShaderStage { GL_VERTEX_SHADER, SPRITE_VERTEX_SHADER },
+			ShaderStage { GL_FRAGMENT_SHADER, SPRITE_FRAGMENT_SHADER_ARRAY }
+		});
+		if (!compiled_2d || !compiled_array) {
+			return;
+		}
+		m_iViewport2D = m_pShader2D->uniform_location("u_viewport");
+		m_iViewportArray = m_pShaderArray->uniform_location("u_viewport");
+
+		constexpr uint8_t white[4] = { 255, 255, 255, 255 };
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_uWhiteTexture);
+		glTextureStorage2D(m_uWhiteTexture, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(m_uWhiteTexture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+
+		// One persistently mapped buffer split into regions, so the CPU fills one while the GPU still reads the others
+		const auto buffer_size = static_cast<GLsizeiptr>(sizeof(SpriteInstance)) * m_uRegionCapacity * RegionCount;
+		constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_uInstanceBuffer);
+		glNamedBufferStorage(m_uInstanceBuffer, buffer_size, nullptr, map_flags);
+		m_pMappedBuffer = static_cast<uint8_t*>(glMapNamedBufferRange(m_uInstanceBuffer, 0, buffer_size, map_flags));
+		if (m_pMappedBuffer == nullptr) {
+			LogErr("Failed to map sprite instance buffer ({} bytes)", buffer_size);
+			return;
+		}
+
+		glCreateVertexArrays(1, &m_uVertexArray);
+		glVertexArrayVertexBuffer(m_uVertexArray, 0, m_uInstanceBuffer, 0, sizeof(SpriteInstance));
+		glVertexArrayBindingDivisor(m_uVertexArray, 0, 1);
+
+		glEnableVertexArrayAttrib(m_uVertexArray, 0);
+		glVertexArrayAttribFormat(m_uVertexArray, 0, 4, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, rect));
+		glVertexArrayAttribBinding(m_uVertexArray, 0, 0);
+		glEnableVertexArrayAttrib(m_uVertexArray, 1);
+		glVertexArrayAttribFormat(m_uVertexArray, 1, 4, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, uv));
+		glVertexArrayAttribBinding(m_uVertexArray, 1, 0);
+		glEnableVertexArrayAttrib(m_uVertexArray, 2);
+		glVertexArrayAttribFormat(m_uVertexArray, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SpriteInstance, color));
+		glVertexArrayAttribBinding(m_uVertexArray, 2, 0);
+		glEnableVertexArrayAttrib(m_uVertexArray, 3);
+		glVertexArrayAttribFormat(m_uVertexArray, 3, 1, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, layer));
+		glVertexArrayAttribBinding(m_uVertexArray, 3, 0);
+	}
+	SpriteBatch::~SpriteBatch() {
+		for (auto& fence : m_pRegionFences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		if (m_pMappedBuffer != nullptr) {
+			glUnmapNamedBuffer(m_uInstanceBuffer);
+		}
+		GLState::ForgetVertexArray(m_uVertexArray);
+		GLState::ForgetBuffer(m_uInstanceBuffer);
+		GLState::ForgetTexture(m_uWhiteTexture);
+		glDeleteVertexArrays(1, &m_uVertexArray);
+		glDeleteBuffers(1, &m_uInstanceBuffer);
+		glDeleteTextures(1, &m_uWhiteTexture);
+	}
+
+	void SpriteBatch::draw(const std::vector<Sprite>& sprites) {
+		m_uDrawCalls = 0;
+		if (sprites.empty() || !is_valid()) {
+			return;
+		}
+		if (sprites.size() > SPRITE_INDEX_MASK) {
+			LogErr("Too many sprites in one batch ({}, max {})", sprites.size(), SPRITE_INDEX_MASK);
+			return;
+		}
+
+		m_keys.resize(sprites.size());
+		for (size_t i = 0; i < sprites.size(); ++i) {
+			const auto& sprite = sprites[i];
+			const uint64_t order = static_cast<uint16_t>(sprite.order ^ INT16_MIN);
+			const uint64_t is_array = sprite.target == GL_TEXTURE_2D_ARRAY ? 1 : 0;
+			const uint64_t texture = sprite.texture & ((1ull << SPRITE_TEXTURE_BITS) - 1);
+			m_keys[i] = order << (SPRITE_INDEX_BITS + SPRITE_TEXTURE_BITS + 1) |
+				is_array << (SPRITE_INDEX_BITS + SPRITE_TEXTURE_BITS) |
+				texture << SPRITE_INDEX_BITS |
+				i;
+		}
+		// Keys are generated in index order, so the stable sort only has to look at the batch bits
+		RadixSort(m_keys, m_sortBuffer, SPRITE_BATCH_SHIFT);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		GLState::SetEnabled(GL_DEPTH_TEST, false);
+		GLState::SetEnabled(GL_BLEND, true);
+		GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLState::BindVertexArray(m_uVertexArray);
+
+		GLuint viewport_program = 0;
+		uint64_t bound_batch = UINT64_MAX;
+		size_t next = 0;
+		while (next < m_keys.size()) {
+			const auto count = std::min<size_t>(m_keys.size() - next, m_uRegionCapacity);
+
+			if (auto& fence = m_pRegionFences[m_uRegion]; fence != nullptr) {
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) { }
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+
+			const auto region_base = m_uRegion * m_uRegionCapacity;
+			auto* instances = reinterpret_cast<SpriteInstance*>(m_pMappedBuffer) + region_base;
+			for (size_t i = 0; i < count; ++i) {
+				const auto& sprite = sprites[m_keys[next + i] & SPRITE_INDEX_MASK];
+				auto& instance = instances[i];
+				instance.rect[0] = sprite.position.x;
+				instance.rect[1] = sprite.position.y;
+				instance.rect[2] = sprite.size.x;
+				instance.rect[3] = sprite.size.y;
+				instance.uv[0] = sprite.uv.x;
+				instance.uv[1] = sprite.uv.y;
+				instance.uv[2] = sprite.uv.z;
+				instance.uv[3] = sprite.uv.w;
+				instance.color[0] = static_cast<uint8_t>(std::clamp(sprite.color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+				instance.color[1] = static_cast<uint8_t>(std::clamp(sprite.color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+				instance.color[2] = static_cast<uint8_t>(std::clamp(sprite.color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+				instance.color[3] = static_cast<uint8_t>(std::clamp(sprite.color.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+				instance.layer = sprite.layer;
+			}
+
+			// Every run of sprites sharing order and texture becomes one instanced draw
+			size_t run_start = 0;
+			while (run_start < count) {
+				const auto batch = m_keys[next + run_start] >> SPRITE_BATCH_SHIFT;
+				size_t run_end = run_start + 1;
+				while (run_end < count && m_keys[next + run_end] >> SPRITE_BATCH_SHIFT == batch) {
+					++run_end;
+				}
+
+				if (batch != bound_batch) {
+					const auto& sprite = sprites[m_keys[next + run_start] & SPRITE_INDEX_MASK];
+					const bool is_array = sprite.target == GL_TEXTURE_2D_ARRAY && sprite.texture != 0;
+					const auto program = is_array ? m_pShaderArray->id() : m_pShader2D->id();
+					GLState::UseProgram(program);
+					if (program != viewport_program) {
+						glUniform2f(is_array ? m_iViewportArray : m_iViewport2D,
+							static_cast<float>(viewport[2]), static_cast<float>(viewport[3])
+						);
+						viewport_program = program;
+					}
+					GLState::BindTextureUnit(0, sprite.texture != 0 ? sprite.texture : m_uWhiteTexture);
+					bound_batch = batch;
+				}
+
+				glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4,
+					static_cast<GLsizei>(run_end - run_start),
+					static_cast<GLuint>(region_base + run_start)
+				);
+				++m_uDrawCalls;
+				run_start = run_end;
+			}
+
+			m_pRegionFences[m_uRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			m_uRegion = (m_uRegion + 1) % RegionCount;
+			next += count;
+		}
+
+		GLState::BindVertexArray(0);
+	}
+
+	static void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& buffer, const uint32_t first_bit) {
+		buffer.resize(keys.size());
+
+		// Least significant digit first, passes where every key shares the same byte are skipped
+		uint64_t same_bits = ~0ull;
+		for (const auto key : keys) {
+			same_bits &= ~(key ^ keys[0]);
+		}
+
+		auto* source = keys.data();
+		auto* target = buffer.data();
+		for (uint32_t shift = first_bit; shift < 64; shift += 8) {
+			if (((same_bits >> shift) & 0xFF) == 0xFF) {
+				continue;
+			}
+
+			size_t offsets[256] = { };
+			for (size_t i = 0; i < keys.size(); ++i) {
+				++offsets[(source[i] >> shift) & 0xFF];
+			}
+			size_t total = 0;
+			for (auto& offset : offsets) {
+				const auto count = offset;
+				offset = total;
+				total += count;
+			}
+			for (size_t i = 0; i < keys.size(); ++i) {
+				target[offsets[(source[i] >> shift) & 0xFF]++] = source[i];
+			}
+			std::swap(source, target);
+		}
+
+		if (source != keys.data()) {
+			keys.swap(buffer);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gctk_math.hpp"
+
+struct __GLsync;
+
+namespace gctk {
+	class Shader;
+
+	struct Sprite {
+		Vector2 position;
+		Vector2 size;
+		Vector4 uv = Vector4 { 0.0f, 0.0f, 1.0f, 1.0f };
+		Color color = Color { 1.0f, 1.0f, 1.0f, 1.0f };
+		// Texture name and target, 0 draws the sprite untextured
+		uint32_t texture = 0;
+		uint32_t target = 0;
+		// Layer of an array texture
+		float layer = 0.0f;
+		// Sprites are drawn in ascending order, equal orders are grouped by texture
+		int16_t order = 0;
+	};
+
+	class SpriteBatch {
+		static constexpr uint32_t RegionCount = 3;
+
+		std::unique_ptr<Shader> m_pShader2D;
+		std::unique_ptr<Shader> m_pShaderArray;
+		int32_t m_iViewport2D;
+		int32_t m_iViewportArray;
+		uint32_t m_uVertexArray;
+		uint32_t m_uInstanceBuffer;
+		uint32_t m_uWhiteTexture;
+		uint8_t* m_pMappedBuffer;
+		__GLsync* m_pRegionFences[RegionCount];
+		uint32_t m_uRegion;
+		uint32_t m_uRegionCapacity;
+		std::vector<uint64_t> m_keys;
+		std::vector<uint64_t> m_sortBuffer;
+		uint32_t m_uDrawCalls;
+	public:
+		explicit SpriteBatch(uint32_t sprites_per_region = 131072);
+		~SpriteBatch();
+		SpriteBatch(const SpriteBatch&) = delete;
+		SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+		// Needs a current GL context, sprite positions are in framebuffer pixels from the top left corner
+		void draw(const std::vector<Sprite>& sprites);
+
+		[[nodiscard]] constexpr bool is_valid() const { return m_pMappedBuffer != nullptr; }
+		[[nodiscard]] constexpr uint32_t draw_calls() const { return m_uDrawCalls; }
+	};
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <fstream>
 
 #include "gctk_debug.hpp"
+#include "gctk_gl_state.hpp"
 
 namespace gctk {
 	static constexpr uint8_t TEXTURE_IDENTIFIER[4] = { 'G', 'T', 'E', 'X' };
@@ -56,36 +57,37 @@ namespace gctk {
 
 	Texture::~Texture() {
 		if (!m_bIsCopy && m_uId != 0) {
-			glDeleteTextures(1, &m_uId);
+			GLContext::Post([id = m_uId]() {
+				GLState::ForgetTexture(id);
+				glDeleteTextures(1, &id);
+			});
 			m_uId = 0;
 		}
 	}
 
 	GLuint Texture::width() const {
 		GLuint value;
-		glGetTextureParameterIuiv(m_uId, GL_TEXTURE_WIDTH, &value);
+		GLContext::Run([&]() { glGetTextureParameterIuiv(m_uId, GL_TEXTURE_WIDTH, &value); });
 		return value;
 	}
 	GLuint Texture::height() const {
 		GLuint value;
-		glGetTextureParameterIuiv(m_uId, GL_TEXTURE_HEIGHT, &value);
+		GLContext::Run([&]() { glGetTextureParameterIuiv(m_uId, GL_TEXTURE_HEIGHT, &value); });
 		return value;
 	}
 	GLuint Texture::depth() const {
 		GLuint value;
-		glGetTextureParameterIuiv(m_uId, GL_TEXTURE_DEPTH, &value);
+		GLContext::Run([&]() { glGetTextureParameterIuiv(m_uId, GL_TEXTURE_DEPTH, &value); });
 		return value;
 	}
 	void Texture::apply() const {
-		glBindTexture(m_uTarget, m_uId);
+		GLState::BindTexture(m_uTarget, m_uId);
 	}
 
 	bool Texture::load(const std::string& path) {
 		std::ifstream ifs(path, std::ios::binary); // TODO: Load file from an asset pack instead
 		if (!ifs.is_open()) {
 			LogErr("Could not load texture \"{}\": Failed to open file", path);
-			glDeleteTextures(1, &m_uId);
-			m_uId = 0;
 			return false;
 		}
 
@@ -93,8 +95,6 @@ namespace gctk {
 		ifs.read(reinterpret_cast<char*>(identifier), 4);
 		if (memcmp(identifier, TEXTURE_IDENTIFIER, 4) != 0) {
 			LogErr("Could not load texture \"{}\": Invalid identifier", path);
-			glDeleteTextures(1, &m_uId);
-			m_uId = 0;
 			return false;
 		}
 
@@ -125,16 +125,12 @@ namespace gctk {
 			case TextureTarget::TextureCubeMapArray: target = GL_TEXTURE_CUBE_MAP_ARRAY; break;
 			default: {
 				LogErr("Could not load texture \"{}\": Invalid texture target", path);
-				glDeleteTextures(1, &m_uId);
-				m_uId = 0;
 				return false;
 			}
 		}
 
 		if (target != m_uTarget) {
 			LogErr("Could not load texture \"{}\": Unexpected target", path);
-			glDeleteTextures(1, &m_uId);
-			m_uId = 0;
 			return false;
 		}
 
@@ -229,64 +225,67 @@ namespace gctk {
 
 			default: {
 				LogErr("Could not load texture \"{}\": Invalid texture format", path);
-				glDeleteTextures(1, &m_uId);
-				m_uId = 0;
 				return false;
 			}
 		}
 
-		glBindTexture(m_uTarget, m_uId);
-
-		glTextureParameteri(m_uId, GL_TEXTURE_MAG_FILTER, flags.filter ? GL_LINEAR : GL_NEAREST);
-		glTextureParameteri(m_uId, GL_TEXTURE_MIN_FILTER,
-			flags.mipmaps ?
-			(flags.filter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR) :
-			(flags.filter ? GL_LINEAR : GL_NEAREST)
-		);
-
-		glTextureParameteri(m_uId, GL_TEXTURE_WRAP_R, flags.clamp_r ? GL_CLAMP : GL_REPEAT);
-		glTextureParameteri(m_uId, GL_TEXTURE_WRAP_S, flags.clamp_s ? GL_CLAMP : GL_REPEAT);
-		glTextureParameteri(m_uId, GL_TEXTURE_WRAP_T, flags.clamp_t ? GL_CLAMP : GL_REPEAT);
-
 		uint8_t* data = new uint8_t[data_size];
 		ifs.read(reinterpret_cast<char*>(data), data_size);
 
-		switch (m_uTarget) {
-			case GL_TEXTURE_1D: {
-				glTexImage1D(m_uTarget, 0, gl_internal_format, width, 0, gl_format, GL_UNSIGNED_BYTE, data);
-			} break;
-			case GL_TEXTURE_1D_ARRAY:
-			case GL_TEXTURE_2D: {
-				glTexImage2D(m_uTarget, 0, gl_internal_format, width, height, 0, gl_format, GL_UNSIGNED_BYTE, data);
-			} break;
-			case GL_TEXTURE_2D_ARRAY:
-			case GL_TEXTURE_3D: {
-				glTexImage3D(m_uTarget, 0, gl_internal_format, width, height, depth, 0, gl_format, GL_UNSIGNED_BYTE, data);
-			} break;
-			case GL_TEXTURE_CUBE_MAP: {
-				glTexStorage2D(m_uTarget, 0, gl_internal_format, width, height);
-				for (int i = 0; i < 6; i++) {
-					glTexSubImage2D(m_uTarget, 0, height * i, 0, width, height, gl_format, GL_UNSIGNED_BYTE, data);
-				}
-			} break;
-			case GL_TEXTURE_CUBE_MAP_ARRAY: {
-				glTexStorage3D(m_uTarget, 0, gl_internal_format, width, height, depth);
-				for (int j = 0; j < depth; j++) {
+		GLContext::Run([&]() {
+			if (m_uId == 0) {
+				glCreateTextures(m_uTarget, 1, &m_uId);
+			}
+			GLState::BindTexture(m_uTarget, m_uId);
+
+			glTextureParameteri(m_uId, GL_TEXTURE_MAG_FILTER, flags.filter ? GL_LINEAR : GL_NEAREST);
+			glTextureParameteri(m_uId, GL_TEXTURE_MIN_FILTER,
+				flags.mipmaps ?
+				(flags.filter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR) :
+				(flags.filter ? GL_LINEAR : GL_NEAREST)
+			);
+
+			glTextureParameteri(m_uId, GL_TEXTURE_WRAP_R, flags.clamp_r ? GL_CLAMP : GL_REPEAT);
+			glTextureParameteri(m_uId, GL_TEXTURE_WRAP_S, flags.clamp_s ? GL_CLAMP : GL_REPEAT);
+			glTextureParameteri(m_uId, GL_TEXTURE_WRAP_T, flags.clamp_t ? GL_CLAMP : GL_REPEAT);
+
+			switch (m_uTarget) {
+				case GL_TEXTURE_1D: {
+					glTexImage1D(m_uTarget, 0, gl_internal_format, width, 0, gl_format, GL_UNSIGNED_BYTE, data);
+				} break;
+				case GL_TEXTURE_1D_ARRAY:
+				case GL_TEXTURE_2D: {
+					glTexImage2D(m_uTarget, 0, gl_internal_format, width, height, 0, gl_format, GL_UNSIGNED_BYTE, data);
+				} break;
+				case GL_TEXTURE_2D_ARRAY:
+				case GL_TEXTURE_3D: {
+					glTexImage3D(m_uTarget, 0, gl_internal_format, width, height, depth, 0, gl_format, GL_UNSIGNED_BYTE, data);
+				} break;
+				case GL_TEXTURE_CUBE_MAP: {
+					glTexStorage2D(m_uTarget, 0, gl_internal_format, width, height);
 					for (int i = 0; i < 6; i++) {
-						glTexSubImage3D(m_uTarget, 0, height * i, 0, j * 6, width, height, 1, gl_format, GL_UNSIGNED_BYTE, data);
+						glTexSubImage2D(m_uTarget, 0, height * i, 0, width, height, gl_format, GL_UNSIGNED_BYTE, data);
 					}
-				}
-			} break;
-			default: /* Should never reach this case */ break;
-		}
+				} break;
+				case GL_TEXTURE_CUBE_MAP_ARRAY: {
+					glTexStorage3D(m_uTarget, 0, gl_internal_format, width, height, depth);
+					for (int j = 0; j < depth; j++) {
+						for (int i = 0; i < 6; i++) {
+							glTexSubImage3D(m_uTarget, 0, height * i, 0, j * 6, width, height, 1, gl_format, GL_UNSIGNED_BYTE, data);
+						}
+					}
+				} break;
+				default: /* Should never reach this case */ break;
+			}
 
-		if (flags.mipmaps) {
-			glGenerateTextureMipmap(m_uId);
-		}
+			if (flags.mipmaps) {
+				glGenerateTextureMipmap(m_uId);
+			}
 
-		delete[] data;
+			GLState::BindTexture(m_uTarget, 0);
+		});
 
-		glBindTexture(m_uTarget, 0);
+		delete[] data;
 
 		return true;
 	}
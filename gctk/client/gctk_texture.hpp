@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include <GL/glew.h>
@@ -12,10 +13,9 @@ namespace gctk {
 		bool m_bIsCopy;
 	public:
 		constexpr Texture(const GLuint id, const GLuint target, const bool is_copy) :
-			m_uTarget(id), m_uId(target), m_bIsCopy(is_copy) { }
-		explicit constexpr Texture(const GLuint target = GL_TEXTURE_2D) : Texture(0, target, false) {
-			glGenTextures(1, &m_uId);
-		}
+			m_uTarget(target), m_uId(id), m_bIsCopy(is_copy) { }
+		// The texture object is created by load
+		explicit constexpr Texture(const GLuint target = GL_TEXTURE_2D) : Texture(0, target, false) { }
 		virtual ~Texture();
 
 		[[nodiscard]] virtual bool load(const std::string& path);
@@ -29,6 +29,8 @@ namespace gctk {
 		void apply() const;
 	};
 
+	using TextureRef = std::shared_ptr<Texture>;
+
 	class Texture1D final : public Texture {
 	public:
 		Texture1D() : Texture(GL_TEXTURE_1D) { }
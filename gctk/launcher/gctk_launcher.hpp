@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <thread>
+
 #include "gctk.hpp"
 #include "gctk_dll.hpp"
 
@@ -60,7 +66,15 @@ inline int GctkLauncherMain(int argc, char** argv) {
 	const auto client_start = client_dll.get_symbol<void(*)(int argc, char** argv)>("ClientStartup");
 	const auto client_update = client_dll.get_symbol<bool(*)()>("ClientUpdate");
 	const auto client_render = client_dll.get_symbol<void(*)()>("ClientRender");
+	const auto client_begin_frame = client_dll.get_symbol<void(*)()>("ClientBeginFrame", false);
 	const auto client_shutdown = client_dll.get_symbol<void(*)()>("ClientShutdown");
+	const auto client_input_rate = client_dll.get_symbol<double(*)()>("ClientInputRate", false);
+	const auto client_input_sample = client_dll.get_symbol<void(*)()>("ClientInputSample", false);
+	const auto client_frame_timing = client_dll.get_symbol<void(*)(gctk::FrameTiming*)>("ClientFrameTiming", false);
+	const auto client_interpolate = client_dll.get_symbol<void(*)(double)>("ClientInterpolate", false);
+	const auto client_attach_local = client_dll.get_symbol<void(*)(gctk::LocalChannel*)>("ClientAttachLocal", false);
+	const auto client_attach_profiler = client_dll.get_symbol<void(*)(gctk::ProfilerState*)>("ClientAttachProfiler", false);
+	const auto client_attach_jobs = client_dll.get_symbol<void(*)(gctk::JobScheduler*)>("ClientAttachJobs", false);
 
 #ifdef GCTK_SINGLEPLAYER
 	const gctk::DLL server_dll(gctk::Paths::GameBinaryPath() / SERVER_DLL_NAME);
@@ -79,6 +93,10 @@ inline int GctkLauncherMain(int argc, char** argv) {
 	const auto server_start = server_dll.get_symbol<void(*)(int argc, char** argv)>("ServerStartup");
 	const auto server_heartbeat = server_dll.get_symbol<void(*)()>("ServerHeartbeat");
 	const auto server_shutdown = server_dll.get_symbol<void(*)()>("ServerShutdown");
+	const auto server_frame_timing = server_dll.get_symbol<void(*)(gctk::FrameTiming*)>("ServerFrameTiming", false);
+	const auto server_attach_local = server_dll.get_symbol<void(*)(gctk::LocalChannel*)>("ServerAttachLocal", false);
+	const auto server_attach_profiler = server_dll.get_symbol<void(*)(gctk::ProfilerState*)>("ServerAttachProfiler", false);
+	const auto server_attach_jobs = server_dll.get_symbol<void(*)(gctk::JobScheduler*)>("ServerAttachJobs", false);
 #endif
 
 	if (client_start == nullptr) {
@@ -101,21 +119,161 @@ inline int GctkLauncherMain(int argc, char** argv) {
 #endif
 
 	try {
+		// Zones of the launcher and both modules end up in the same capture
+		gctk::Profiler::SetThreadName("Main");
+		if (client_attach_profiler != nullptr) {
+			client_attach_profiler(gctk::Profiler::State());
+		}
+#ifdef GCTK_SINGLEPLAYER
+		if (server_attach_profiler != nullptr) {
+			server_attach_profiler(gctk::Profiler::State());
+		}
+#endif
+		// One set of job workers for both modules instead of one per module
+		if (client_attach_jobs != nullptr) {
+			client_attach_jobs(gctk::Jobs::Scheduler());
+		}
+#ifdef GCTK_SINGLEPLAYER
+		if (server_attach_jobs != nullptr) {
+			server_attach_jobs(gctk::Jobs::Scheduler());
+		}
+#endif
+
 		client_start(argc, argv);
 #ifdef GCTK_SINGLEPLAYER
 		server_start(argc, argv);
+
+		// Both modules link their own copy of gctk, so the channel between them lives in the launcher
+		const auto local_channel = std::make_unique<gctk::LocalChannel>();
+		if (client_attach_local != nullptr && server_attach_local != nullptr) {
+			client_attach_local(local_channel.get());
+			server_attach_local(local_channel.get());
+		}
 #endif
 
 		if (client_update != nullptr) {
-			bool running = true;
-			while (running) {
+			// Without timing settings from the game every rendered frame runs exactly one uncapped tick
+			gctk::FrameTiming timing { 0.0, 0.0, 1 };
+			if (client_frame_timing != nullptr) {
+				client_frame_timing(&timing);
+			}
+			gctk::FrameScheduler scheduler(timing);
+
+			std::atomic_bool running = true;
+			std::exception_ptr game_exception = nullptr;
+			std::exception_ptr input_exception = nullptr;
+
 #ifdef GCTK_SINGLEPLAYER
-				server_heartbeat();
+			gctk::FrameTiming server_timing { 60.0, 0.0, 1 };
+			if (server_frame_timing != nullptr) {
+				server_frame_timing(&server_timing);
+			}
+			if (server_timing.tick_rate <= 0.0) {
+				server_timing.tick_rate = 60.0;
+			}
+			// Nothing is rendered on the server thread, so it only wakes up when the next tick is due
+			server_timing.max_frame_rate = server_timing.tick_rate;
+
+			std::exception_ptr server_exception = nullptr;
+			std::thread server_thread([&]() {
+				gctk::Profiler::SetThreadName("Server");
+				try {
+					gctk::FrameScheduler server_scheduler(server_timing);
+					while (running) {
+						for (auto ticks = server_scheduler.begin_frame(); ticks > 0 && running; --ticks) {
+							GCTK_PROFILE_SCOPE("ServerHeartbeat");
+							server_heartbeat();
+						}
+						server_scheduler.end_frame();
+					}
+				} catch (...) {
+					server_exception = std::current_exception();
+					running = false;
+				}
+			});
 #endif
-				running = client_update();
+
+			const auto run_frame = [&]() {
+				GCTK_PROFILE_SCOPE("Frame");
+				const auto ticks = scheduler.begin_frame();
+				if (client_begin_frame != nullptr) {
+					client_begin_frame();
+				}
+				for (uint32_t i = 0; i < ticks && running; ++i) {
+					GCTK_PROFILE_SCOPE("ClientUpdate");
+					if (!client_update()) {
+						running = false;
+					}
+				}
+				if (client_interpolate != nullptr) {
+					client_interpolate(scheduler.alpha());
+				}
 				if (client_render != nullptr) {
+					GCTK_PROFILE_SCOPE("ClientRender");
 					client_render();
 				}
+				scheduler.end_frame();
+			};
+
+			const double input_rate = client_input_rate != nullptr && client_input_sample != nullptr ? client_input_rate() : 0.0;
+			if (input_rate > 0.0) {
+				// GLFW only allows event and gamepad polling on the main thread, so the game loop moves to its own thread
+				std::thread game_thread([&]() {
+					gctk::Profiler::SetThreadName("Game");
+					try {
+						while (running) {
+							run_frame();
+						}
+					} catch (...) {
+						game_exception = std::current_exception();
+						running = false;
+					}
+				});
+
+				const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(1.0 / input_rate)
+				);
+				auto next_sample = std::chrono::steady_clock::now();
+				try {
+					while (running) {
+						{
+							GCTK_PROFILE_SCOPE("ClientInputSample");
+							client_input_sample();
+						}
+						next_sample += interval;
+						if (const auto now = std::chrono::steady_clock::now(); next_sample < now) {
+							next_sample = now;
+						}
+						std::this_thread::sleep_until(next_sample);
+					}
+				} catch (...) {
+					input_exception = std::current_exception();
+					running = false;
+				}
+
+				game_thread.join();
+			} else {
+				try {
+					while (running) {
+						run_frame();
+					}
+				} catch (...) {
+					game_exception = std::current_exception();
+					running = false;
+				}
+			}
+
+#ifdef GCTK_SINGLEPLAYER
+			server_thread.join();
+			if (server_exception != nullptr) {
+				std::rethrow_exception(server_exception);
+			}
+#endif
+			if (game_exception != nullptr) {
+				std::rethrow_exception(game_exception);
+			}
+			if (input_exception != nullptr) {
+				std::rethrow_exception(input_exception);
 			}
 		}
 #ifdef GCTK_SINGLEPLAYER
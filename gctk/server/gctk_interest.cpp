@@ -0,0 +1,120 @@
+#include "gctk_interest.hpp"
+
+#include <algorithm>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static bool ValidatePositive(const CVar* self, const std::string& value);
+	static bool ValidatePositiveOrZero(const CVar* self, const std::string& value);
+
+	CVar sv_interest_radius("sv_interest_radius", "64.0", CVAR_FLAG_USER_DATA, &ValidatePositive);
+	CVar sv_interest_hysteresis("sv_interest_hysteresis", "8.0", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+
+	// Calls fn for every element of the sorted range a that is missing from the sorted range b
+	template<typename Fn>
+	static void ForEachMissing(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, Fn&& fn) {
+		auto it = b.begin();
+		for (const uint64_t id : a) {
+			while (it != b.end() && *it < id) {
+				++it;
+			}
+			if (it == b.end() || *it != id) {
+				fn(id);
+			}
+		}
+	}
+
+	InterestManager::InterestManager(const AABB& world_bounds, const float cell_size) : m_grid(world_bounds, cell_size) { }
+	InterestManager::InterestManager(const Map& map) : InterestManager(AABB {
+		{ static_cast<float>(map.min_chunk().x) * map.chunk_size(), 0.0f, static_cast<float>(map.min_chunk().z) * map.chunk_size() },
+		{ static_cast<float>(map.max_chunk().x + 1) * map.chunk_size(), 0.0f, static_cast<float>(map.max_chunk().z + 1) * map.chunk_size() }
+	}, map.chunk_size()) { }
+
+	void InterestManager::add_entity(const uint64_t id, const AABB& bounds) {
+		if (m_entities.contains(id)) {
+			LogWarn("Entity {} is already tracked for interest management", id);
+			move_entity(id, bounds);
+			return;
+		}
+		m_entities.emplace(id, m_grid.insert(bounds, id));
+	}
+	void InterestManager::move_entity(const uint64_t id, const AABB& bounds) {
+		if (const auto it = m_entities.find(id); it != m_entities.end()) {
+			m_grid.move(it->second, bounds);
+		}
+	}
+	void InterestManager::remove_entity(const uint64_t id) {
+		if (const auto it = m_entities.find(id); it != m_entities.end()) {
+			m_grid.remove(it->second);
+			m_entities.erase(it);
+		}
+	}
+
+	InterestManager::ObserverHandle InterestManager::add_observer(const Vector3& position) {
+		return m_observers.create(Observer { position, { } });
+	}
+	void InterestManager::move_observer(const ObserverHandle observer, const Vector3& position) {
+		Observer* o = m_observers.get(observer);
+		Assert(o != nullptr, "Invalid interest observer {}", observer.index);
+		if (o != nullptr) {
+			o->position = position;
+		}
+	}
+	void InterestManager::remove_observer(const ObserverHandle observer) {
+		const Observer* o = m_observers.get(observer);
+		Assert(o != nullptr, "Invalid interest observer {}", observer.index);
+		if (o == nullptr) {
+			return;
+		}
+		if (m_fnOnLeave) {
+			for (const uint64_t id : o->visible) {
+				m_fnOnLeave(observer, id);
+			}
+		}
+		m_observers.destroy(observer);
+	}
+
+	void InterestManager::update() {
+		const float radius = std::max(sv_interest_radius.get_float(), 0.0f);
+		const float keep_radius = radius + std::max(sv_interest_hysteresis.get_float(), 0.0f);
+
+		m_observers.for_each([&](const ObserverHandle handle, Observer& observer) {
+			// Entities already in the set only need to stay within the wider radius
+			m_scratch.clear();
+			m_grid.query(observer.position, keep_radius, [&](const int32_t proxy) {
+				const uint64_t id = m_grid.user_data(proxy);
+				if (m_grid.bounds(proxy).overlaps(observer.position, radius) || std::ranges::binary_search(observer.visible, id)) {
+					m_scratch.push_back(id);
+				}
+				return true;
+			});
+			std::ranges::sort(m_scratch);
+
+			if (m_fnOnLeave) {
+				ForEachMissing(observer.visible, m_scratch, [&](const uint64_t id) { m_fnOnLeave(handle, id); });
+			}
+			if (m_fnOnEnter) {
+				ForEachMissing(m_scratch, observer.visible, [&](const uint64_t id) { m_fnOnEnter(handle, id); });
+			}
+			std::swap(observer.visible, m_scratch);
+		});
+	}
+
+	const std::vector<uint64_t>& InterestManager::visible(const ObserverHandle observer) const {
+		static const std::vector<uint64_t> none;
+		const Observer* o = m_observers.get(observer);
+		return o != nullptr ? o->visible : none;
+	}
+
+	static bool ValidatePositive(const CVar*, const std::string& value) {
+		float number;
+		return StringUtil::ParseFloat(value, number) && number > 0.0f;
+	}
+	static bool ValidatePositiveOrZero(const CVar*, const std::string& value) {
+		float number;
+		return StringUtil::ParseFloat(value, number) && number >= 0.0f;
+	}
+}
\ No newline at end of file
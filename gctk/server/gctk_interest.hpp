@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "gctk_map.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_spatial.hpp"
+
+namespace gctk {
+	// Decides which entities each observer (usually a connected player) is told about.
+	// Entities within sv_interest_radius of an observer enter its set and leave it again once they are
+	// sv_interest_hysteresis further away, so entities on the border do not flicker in and out.
+	class InterestManager {
+		struct Observer {
+			Vector3 position;
+			std::vector<uint64_t> visible; // Sorted
+		};
+	public:
+		// Stops resolving once the observer is removed, so a stale one never reaches the player that reused its slot
+		using ObserverHandle = Handle<Observer>;
+		using Callback = std::function<void(ObserverHandle observer, uint64_t entity)>;
+	private:
+		LooseGrid m_grid;
+		std::unordered_map<uint64_t, int32_t> m_entities;
+		ObjectPool<Observer> m_observers;
+		std::vector<uint64_t> m_scratch;
+		Callback m_fnOnEnter;
+		Callback m_fnOnLeave;
+	public:
+		InterestManager(const AABB& world_bounds, float cell_size);
+		// Covers the chunks of the map with one grid cell per chunk
+		explicit InterestManager(const Map& map);
+
+		InterestManager(const InterestManager&) = delete;
+		InterestManager& operator=(const InterestManager&) = delete;
+
+		void add_entity(uint64_t id, const AABB& bounds);
+		void move_entity(uint64_t id, const AABB& bounds);
+		// The entity leaves the observers that see it on the next update
+		void remove_entity(uint64_t id);
+
+		ObserverHandle add_observer(const Vector3& position);
+		void move_observer(ObserverHandle observer, const Vector3& position);
+		// Reports every entity the observer sees as leaving
+		void remove_observer(ObserverHandle observer);
+
+		// Recomputes the visible sets and reports what entered and left them
+		void update();
+
+		// Empty for removed observers
+		[[nodiscard]] const std::vector<uint64_t>& visible(ObserverHandle observer) const;
+		[[nodiscard]] inline size_t entity_count() const { return m_entities.size(); }
+		[[nodiscard]] inline size_t observer_count() const { return m_observers.size(); }
+
+		inline void set_on_enter(Callback callback) { m_fnOnEnter = std::move(callback); }
+		inline void set_on_leave(Callback callback) { m_fnOnLeave = std::move(callback); }
+	};
+}
\ No newline at end of file
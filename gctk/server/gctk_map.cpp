@@ -0,0 +1,212 @@
+#include "gctk_map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ranges>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_pool.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static bool ValidatePositiveOrZero(const CVar* self, const std::string& value);
+	static bool ValidatePositive(const CVar* self, const std::string& value);
+
+	CVar map_stream_radius("map_stream_radius", "2", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+	CVar map_unload_radius("map_unload_radius", "3", CVAR_FLAG_USER_DATA, &ValidatePositive);
+	CVar map_max_pending("map_max_pending", "16", CVAR_FLAG_USER_DATA, &ValidatePositive);
+
+	static std::unordered_map<std::string, std::weak_ptr<Map>> s_maps;
+
+	bool Map::load(const std::string& path) {
+		const auto size = Asset::EntrySize(path);
+		if (size == 0) {
+			LogErr("Could not load map \"{}\": Asset not found", path);
+			return false;
+		}
+		if (size < sizeof(MapFormat::Header) || !Asset::ReadRange(path, 0, sizeof(MapFormat::Header), &m_header)) {
+			LogErr("Could not load map \"{}\": Failed to read header", path);
+			return false;
+		}
+		if (memcmp(m_header.identifier, MapFormat::Identifier, 4) != 0) {
+			LogErr("Could not load map \"{}\": Invalid identifier", path);
+			return false;
+		}
+		if (m_header.version == 0 || m_header.version > MapFormat::Version) {
+			LogErr("Could not load map \"{}\": Unsupported version {}", path, m_header.version);
+			return false;
+		}
+		if (m_header.chunk_size <= 0.0f) {
+			LogErr("Could not load map \"{}\": Invalid chunk size {}", path, m_header.chunk_size);
+			return false;
+		}
+
+		if (static_cast<uint64_t>(m_header.index_offset) + static_cast<uint64_t>(m_header.chunk_count) * sizeof(MapFormat::ChunkRecord) > size) {
+			LogErr("Could not load map \"{}\": Chunk index is out of range", path);
+			return false;
+		}
+
+		m_index.resize(m_header.chunk_count);
+		if (!Asset::ReadRange(path, m_header.index_offset, m_index.size() * sizeof(MapFormat::ChunkRecord), m_index.data())) {
+			LogErr("Could not load map \"{}\": Failed to read chunk index", path);
+			m_index.clear();
+			return false;
+		}
+		for (const auto& record : m_index) {
+			if (static_cast<size_t>(record.offset) + record.size > size) {
+				LogErr("Could not load map \"{}\": Chunk {}, {} is out of range", path, record.x, record.z);
+				m_index.clear();
+				return false;
+			}
+		}
+		// find_chunk does a binary search over the index
+		const auto unordered = std::ranges::adjacent_find(m_index, [](const MapFormat::ChunkRecord& a, const MapFormat::ChunkRecord& b) {
+			return MapFormat::ChunkKey(a.x, a.z) >= MapFormat::ChunkKey(b.x, b.z);
+		});
+		if (unordered != m_index.end()) {
+			LogErr("Could not load map \"{}\": Chunk index is not sorted at {}, {}", path, unordered->x, unordered->z);
+			m_index.clear();
+			return false;
+		}
+
+		m_sPath = path;
+		return true;
+	}
+
+	const MapFormat::ChunkRecord* Map::find_chunk(const ChunkCoord coord) const {
+		const auto key = coord.key();
+		const auto it = std::ranges::lower_bound(m_index, key, { }, [](const MapFormat::ChunkRecord& record) {
+			return MapFormat::ChunkKey(record.x, record.z);
+		});
+		if (it == m_index.end() || it->x != coord.x || it->z != coord.z) {
+			return nullptr;
+		}
+		return &*it;
+	}
+
+	ChunkCoord Map::chunk_at(const Vector3& position) const {
+		return {
+			static_cast<int32_t>(std::floor(position.x / m_header.chunk_size)),
+			static_cast<int32_t>(std::floor(position.z / m_header.chunk_size))
+		};
+	}
+
+	std::future<std::vector<uint8_t>> Map::read_chunk_async(const MapFormat::ChunkRecord& record) const {
+		return Asset::ReadRangeAsync(m_sPath, record.offset, record.size);
+	}
+
+	MapRef Map::Load(const std::string& path) {
+		if (const auto it = s_maps.find(path); it != s_maps.end()) {
+			if (auto map = it->second.lock(); map != nullptr) {
+				return map;
+			}
+		}
+
+		auto map = MakePooled<Map>();
+		if (!map->load(path)) {
+			return nullptr;
+		}
+		s_maps[path] = map;
+		return map;
+	}
+
+	void MapStreamer::update(const std::span<const Vector3> focus_points) {
+		using namespace std::chrono_literals;
+
+		for (auto it = m_pending.begin(); it != m_pending.end();) {
+			if (it->second.wait_for(0s) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+
+			const ChunkCoord coord = { static_cast<int32_t>(it->first & 0xFFFFFFFF), static_cast<int32_t>(it->first >> 32) };
+			auto data = it->second.get();
+			if (data.empty()) {
+				// Kept as an empty chunk, so a broken entry is not requested again every update
+				LogWarn("Failed to stream chunk {}, {} of map \"{}\"", coord.x, coord.z, m_pMap->path());
+			}
+
+			auto& chunk = m_chunks[it->first];
+			chunk = MapChunk { coord, std::move(data) };
+			it = m_pending.erase(it);
+			if (m_fnOnLoaded) {
+				m_fnOnLoaded(chunk);
+			}
+		}
+
+		std::vector<ChunkCoord> centers;
+		centers.reserve(focus_points.size());
+		for (const auto& point : focus_points) {
+			centers.emplace_back(m_pMap->chunk_at(point));
+		}
+
+		const int32_t radius = std::max(map_stream_radius.get_integer(), 0);
+		const int32_t unload_radius = std::max(map_unload_radius.get_integer(), radius);
+		const size_t max_pending = std::max<int32_t>(map_max_pending.get_integer(), 1);
+
+		// Request ring by ring, so the chunks closest to the focus points are read first
+		for (int32_t ring = 0; ring <= radius && m_pending.size() < max_pending; ring++) {
+			for (const auto& center : centers) {
+				for (int32_t dz = -ring; dz <= ring && m_pending.size() < max_pending; dz++) {
+					for (int32_t dx = -ring; dx <= ring && m_pending.size() < max_pending; dx++) {
+						if (std::max(std::abs(dx), std::abs(dz)) != ring) {
+							continue;
+						}
+
+						const ChunkCoord coord = { center.x + dx, center.z + dz };
+						const auto key = coord.key();
+						if (m_chunks.contains(key) || m_pending.contains(key)) {
+							continue;
+						}
+						if (const auto* record = m_pMap->find_chunk(coord); record != nullptr) {
+							m_pending.emplace(key, m_pMap->read_chunk_async(*record));
+						}
+					}
+				}
+			}
+		}
+
+		for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+			const auto& coord = it->second.coord;
+			const bool in_range = std::ranges::any_of(centers, [&](const ChunkCoord& center) {
+				return std::max(std::abs(coord.x - center.x), std::abs(coord.z - center.z)) <= unload_radius;
+			});
+			if (in_range) {
+				++it;
+				continue;
+			}
+
+			if (m_fnOnUnloaded) {
+				m_fnOnUnloaded(it->second);
+			}
+			it = m_chunks.erase(it);
+		}
+	}
+
+	void MapStreamer::clear() {
+		if (m_fnOnUnloaded) {
+			for (const auto& chunk : m_chunks | std::views::values) {
+				m_fnOnUnloaded(chunk);
+			}
+		}
+		m_chunks.clear();
+		m_pending.clear();
+	}
+
+	const MapChunk* MapStreamer::chunk(const ChunkCoord coord) const {
+		const auto it = m_chunks.find(coord.key());
+		return it != m_chunks.end() ? &it->second : nullptr;
+	}
+
+	static bool ValidatePositiveOrZero(const CVar*, const std::string& value) {
+		int32_t number;
+		return StringUtil::ParseInt(value, number) && number >= 0;
+	}
+	static bool ValidatePositive(const CVar*, const std::string& value) {
+		int32_t number;
+		return StringUtil::ParseInt(value, number) && number > 0;
+	}
+}
\ No newline at end of file
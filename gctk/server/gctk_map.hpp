@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gctk_asset.hpp"
+#include "gctk_map_format.hpp"
+#include "gctk_math.hpp"
+
+namespace gctk {
+	struct ChunkCoord {
+		int32_t x, z;
+
+		constexpr bool operator==(const ChunkCoord& other) const = default;
+		[[nodiscard]] constexpr uint64_t key() const { return MapFormat::ChunkKey(x, z); }
+	};
+
+	struct MapChunk {
+		ChunkCoord coord;
+		std::vector<uint8_t> data;
+	};
+
+	class Map;
+	using MapRef = std::shared_ptr<Map>;
+
+	// A .gmap asset, only the header and the chunk index stay resident, chunk payloads are read through MapStreamer
+	class Map {
+		std::string m_sPath;
+		MapFormat::Header m_header;
+		std::vector<MapFormat::ChunkRecord> m_index;
+	public:
+		Map() : m_header() { }
+
+		[[nodiscard]] bool load(const std::string& path);
+
+		[[nodiscard]] const MapFormat::ChunkRecord* find_chunk(ChunkCoord coord) const;
+		[[nodiscard]] ChunkCoord chunk_at(const Vector3& position) const;
+		[[nodiscard]] std::future<std::vector<uint8_t>> read_chunk_async(const MapFormat::ChunkRecord& record) const;
+
+		[[nodiscard]] constexpr const std::string& path() const { return m_sPath; }
+		[[nodiscard]] constexpr float chunk_size() const { return m_header.chunk_size; }
+		[[nodiscard]] constexpr size_t chunk_count() const { return m_index.size(); }
+		[[nodiscard]] constexpr ChunkCoord min_chunk() const { return { m_header.min_x, m_header.min_z }; }
+		[[nodiscard]] constexpr ChunkCoord max_chunk() const { return { m_header.max_x, m_header.max_z }; }
+
+		// Loaded maps are shared by asset path
+		static MapRef Load(const std::string& path);
+	};
+
+	// Keeps the chunks around a set of focus points (usually the active players) loaded.
+	// Chunks within map_stream_radius are requested from the asset IO thread, chunks beyond map_unload_radius are dropped.
+	class MapStreamer {
+	public:
+		using ChunkCallback = std::function<void(const MapChunk&)>;
+	private:
+		MapRef m_pMap;
+		std::unordered_map<uint64_t, MapChunk> m_chunks;
+		std::unordered_map<uint64_t, std::future<std::vector<uint8_t>>> m_pending;
+		ChunkCallback m_fnOnLoaded;
+		ChunkCallback m_fnOnUnloaded;
+	public:
+		explicit MapStreamer(MapRef map) : m_pMap(std::move(map)) { }
+
+		MapStreamer(const MapStreamer&) = delete;
+		MapStreamer& operator=(const MapStreamer&) = delete;
+
+		// Collects finished reads, then requests and evicts chunks for the current focus points
+		void update(std::span<const Vector3> focus_points);
+		// Unloads every chunk and forgets the pending reads
+		void clear();
+
+		[[nodiscard]] const MapChunk* chunk(ChunkCoord coord) const;
+		[[nodiscard]] inline bool is_loaded(const ChunkCoord coord) const { return m_chunks.contains(coord.key()); }
+		[[nodiscard]] inline size_t loaded_count() const { return m_chunks.size(); }
+		[[nodiscard]] inline size_t pending_count() const { return m_pending.size(); }
+		[[nodiscard]] constexpr const MapRef& map() const { return m_pMap; }
+
+		inline void set_on_loaded(ChunkCallback callback) { m_fnOnLoaded = std::move(callback); }
+		inline void set_on_unloaded(ChunkCallback callback) { m_fnOnUnloaded = std::move(callback); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of .gmap files, shared by the map streamer and the gmap cooker tool.
+// The world is split into square chunks on the XZ plane. The header and the chunk index are read once when a map is opened,
+// chunk payloads are read on demand, so only the chunks around active players need to stay in memory.
+namespace gctk::MapFormat {
+	static constexpr uint8_t Identifier[4] = { 'G', 'M', 'A', 'P' };
+	static constexpr uint16_t Version = 1;
+
+	struct Header {
+		uint8_t identifier[4];
+		uint16_t version;
+		uint16_t flags;
+		float chunk_size;
+		uint32_t chunk_count;
+
+		// Inclusive range of chunk coordinates present in the map
+		int32_t min_x, min_z;
+		int32_t max_x, max_z;
+
+		uint32_t index_offset;
+		uint32_t data_offset;
+	};
+	static_assert(sizeof(Header) == 40);
+
+	// Index entries are sorted by ChunkKey, so a chunk can be found with a binary search
+	struct ChunkRecord {
+		int32_t x, z;
+		uint32_t offset;  // Relative to the start of the file
+		uint32_t size;
+	};
+	static_assert(sizeof(ChunkRecord) == 16);
+
+	constexpr uint64_t ChunkKey(const int32_t x, const int32_t z) {
+		return static_cast<uint64_t>(static_cast<uint32_t>(z)) << 32 | static_cast<uint32_t>(x);
+	}
+}
\ No newline at end of file
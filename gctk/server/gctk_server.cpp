@@ -1,5 +1,8 @@
 #include "gctk.hpp"
 
 namespace gctk {
-
+	void Server::BeginTick() {
+		Profiler::Collect();
+		Memory::BeginFrame();
+	}
 }
\ No newline at end of file
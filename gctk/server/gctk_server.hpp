@@ -1 +1,12 @@
 #pragma once
+
+#include "gctk_map.hpp"
+#include "gctk_interest.hpp"
+
+namespace gctk {
+	namespace Server {
+		// Call at the start of every tick, e.g. first thing in ServerHeartbeat.
+		// Recycles the frame arenas and moves recorded profiler zones out of the per-thread buffers.
+		void BeginTick();
+	}
+}
@@ -3,11 +3,18 @@
 #include <gctk_api.hpp>
 #include <gctk_version.hpp>
 #include <gctk_math.hpp>
+#include <gctk_math_batch.hpp>
+#include <gctk_spatial.hpp>
 #include <gctk_cvar.hpp>
 #include <gctk_debug.hpp>
 #include <gctk_filesys.hpp>
 #include <gctk_str.hpp>
 #include <gctk_time.hpp>
+#include <gctk_memory.hpp>
+#include <gctk_pool.hpp>
+#include <gctk_jobs.hpp>
+#include <gctk_profiler.hpp>
+#include <gctk_local_channel.hpp>
 #include <gctk_asset.hpp>
 
 #ifdef GCTK_CLIENT
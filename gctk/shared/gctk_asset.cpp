@@ -1,11 +1,17 @@
 #include "gctk_asset.hpp"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <mutex>
 #include <ranges>
+#include <thread>
 #include <vector>
 #include <cstring>
 
+#include "gctk_pool.hpp"
+#include "gctk_profiler.hpp"
 #include "gctk_str.hpp"
 
 namespace gctk {
@@ -13,6 +19,71 @@ namespace gctk {
 	static std::vector<AssetPackRef> s_asset_packs;
 	static std::optional<Path> s_mod_path;
 	static bool s_assets_initialized = false;
+	// Guards the pack list and the FILE every pack shares, so the IO thread and the main thread are serialized
+	static std::mutex s_pack_mutex;
+
+	class AssetIOThread {
+		struct Request {
+			std::string path;
+			size_t offset, size;
+			std::promise<std::vector<uint8_t>> promise;
+		};
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_cvWake;
+		std::deque<Request> m_queue;
+		bool m_bRunning = false;
+	public:
+		~AssetIOThread() {
+			{
+				std::lock_guard lock(m_mutex);
+				m_bRunning = false;
+			}
+			m_cvWake.notify_one();
+			if (m_thread.joinable()) {
+				m_thread.join();
+			}
+		}
+
+		std::future<std::vector<uint8_t>> push(const std::string& path, const size_t offset, const size_t size) {
+			Request request { path, offset, size, { } };
+			auto future = request.promise.get_future();
+			{
+				std::lock_guard lock(m_mutex);
+				if (!m_thread.joinable()) {
+					m_bRunning = true;
+					m_thread = std::thread(&AssetIOThread::run, this);
+				}
+				m_queue.emplace_back(std::move(request));
+			}
+			m_cvWake.notify_one();
+			return future;
+		}
+	private:
+		void run() {
+			while (true) {
+				Request request;
+				{
+					std::unique_lock lock(m_mutex);
+					m_cvWake.wait(lock, [this] { return !m_bRunning || !m_queue.empty(); });
+					if (!m_bRunning) {
+						break;
+					}
+					request = std::move(m_queue.front());
+					m_queue.pop_front();
+				}
+
+				std::vector<uint8_t> data(request.size);
+				if (!Asset::ReadRange(request.path, request.offset, request.size, data.data())) {
+					data.clear();
+				}
+				request.promise.set_value(std::move(data));
+			}
+		}
+	};
+	// Declared after the pack list so the thread is joined before the packs are closed
+	static AssetIOThread s_io_thread;
 
 	static constexpr uint8_t s_pack_identifier[4] = { 'G', 'P', 'K', 'G' };
 	static constexpr uint8_t s_pack_identifier_mirrored[4] = { 'G', 'K', 'P', 'G' };
@@ -24,12 +95,14 @@ namespace gctk {
 	}
 
 	AssetRef Asset::Load(const std::string& path) {
+		GCTK_PROFILE_SCOPE("Asset::Load");
 		if (s_assets.contains(path)) {
 			return s_assets.at(path);
 		}
 
 		const auto trimmed_path = StringUtil::Trim(path);
 
+		std::lock_guard lock(s_pack_mutex);
 		for (auto& pack : std::ranges::reverse_view(s_asset_packs)) {
 			if (pack->contains_entry(trimmed_path)) {
 				auto ext = StringUtil::ToLower(Path(trimmed_path).extension().string());
@@ -69,13 +142,12 @@ namespace gctk {
 				}
 
 				const auto& [origin, size] = pack->m_entries.at(path);
-				fseek(pack->m_pStream, static_cast<long>(origin), SEEK_SET);
-
 				void* p = malloc(size);
+				fseek(pack->m_pStream, static_cast<long>(pack->m_uDataOrigin + origin), SEEK_SET);
 				fread(p, 1, size, pack->m_pStream);
 				fseek(pack->m_pStream, pack->m_uDataOrigin, SEEK_SET);
 
-				auto asset = std::make_shared<Asset>();
+				auto asset = MakePooled<Asset>();
 				asset->m_pData = p;
 				asset->m_uSize = size;
 				asset->m_eType = type;
@@ -87,6 +159,43 @@ namespace gctk {
 		return nullptr;
 	}
 
+	bool Asset::ReadRange(const std::string& path, const size_t offset, const size_t size, void* out) {
+		const auto trimmed_path = StringUtil::Trim(path);
+
+		std::lock_guard lock(s_pack_mutex);
+		for (auto& pack : std::ranges::reverse_view(s_asset_packs)) {
+			if (!pack->contains_entry(trimmed_path)) {
+				continue;
+			}
+
+			const auto& [origin, entry_size] = pack->m_entries.at(trimmed_path);
+			if (offset + size > entry_size) {
+				LogErr("Cannot read asset \"{}\": Range {}..{} is out of bounds", path, offset, offset + size);
+				return false;
+			}
+
+			fseek(pack->m_pStream, static_cast<long>(pack->m_uDataOrigin + origin + offset), SEEK_SET);
+			return fread(out, 1, size, pack->m_pStream) == size;
+		}
+		return false;
+	}
+
+	std::future<std::vector<uint8_t>> Asset::ReadRangeAsync(const std::string& path, const size_t offset, const size_t size) {
+		return s_io_thread.push(path, offset, size);
+	}
+
+	size_t Asset::EntrySize(const std::string& path) {
+		const auto trimmed_path = StringUtil::Trim(path);
+
+		std::lock_guard lock(s_pack_mutex);
+		for (auto& pack : std::ranges::reverse_view(s_asset_packs)) {
+			if (pack->contains_entry(trimmed_path)) {
+				return pack->m_entries.at(trimmed_path).size;
+			}
+		}
+		return 0;
+	}
+
 	AssetReader::AssetReader(Asset& asset) : std::istream(&m_buffer), m_buffer(asset) {
 		rdbuf(&m_buffer);
 	}
@@ -227,7 +336,7 @@ namespace gctk {
 			fread(name.data(), sizeof(char), name_length, f);
 
 			fread(&entry_origin, sizeof(uint32_t), 1, f);
-			fread(&entry_size, sizeof(uint16_t), 1, f);
+			fread(&entry_size, sizeof(uint32_t), 1, f);
 			entries.emplace(name, EntryInfo { entry_origin, entry_size });
 		}
 
@@ -255,6 +364,7 @@ namespace gctk {
 		for (const auto& pack : asset_packs) {
 			const auto path = Paths::GameBasePath() / pack;
 			if (auto asset_pack = AssetPack::Open(path); asset_pack != nullptr) {
+				std::lock_guard lock(s_pack_mutex);
 				s_asset_packs.emplace_back(asset_pack);
 			} else {
 				FatalError("Failed to initialize asset pack \"{}\"", path);
@@ -272,6 +382,7 @@ namespace gctk {
 					continue;
 				}
 				if (auto asset_pack = AssetPack::Open(path); asset_pack != nullptr) {
+					std::lock_guard lock(s_pack_mutex);
 					s_asset_packs.emplace_back(asset_pack);
 				}
 			}
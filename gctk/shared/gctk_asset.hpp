@@ -1,7 +1,9 @@
 #pragma once
 
+#include <future>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "gctk_filesys.hpp"
 #include "gctk_debug.hpp"
@@ -48,6 +50,13 @@ namespace gctk {
 		[[nodiscard]] constexpr AssetType type() const { return m_eType; }
 
 		static AssetRef Load(const std::string& path);
+
+		// Reads part of a packed asset without loading the whole entry, thread safe
+		static bool ReadRange(const std::string& path, size_t offset, size_t size, void* out);
+		// Queues a ranged read on the asset IO thread, the future is empty if the read failed
+		static std::future<std::vector<uint8_t>> ReadRangeAsync(const std::string& path, size_t offset, size_t size);
+		static size_t EntrySize(const std::string& path);
+
 		template<typename T>
 		static const T* Load(const std::string& path) {
 			const auto asset = Load(path);
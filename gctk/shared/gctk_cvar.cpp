@@ -1,7 +1,10 @@
 #include "gctk_cvar.hpp"
 #include "gctk_str.hpp"
 #include "gctk_filesys.hpp"
+#include "gctk_memory.hpp"
+#include "gctk_profiler.hpp"
 
+#include <charconv>
 #include <memory>
 #include <fstream>
 #include <unordered_map>
@@ -21,7 +24,7 @@ namespace gctk {
 
 	CVar* CVar::s_cvars = nullptr;
 
-	CVar* CVar::FindCVar(const std::string& name) {
+	CVar* CVar::FindCVar(const std::string_view name) {
 		CVar* current = s_cvars;
 		while (current != nullptr) {
 			if (current->name() == name) {
@@ -182,15 +185,29 @@ namespace gctk {
 		return true;
 	}
 
+	// Same as std::stof / std::stoul on a token, without copying it into a string first
+	template<typename T>
+	static T ParseToken(std::string_view token) {
+		token.remove_prefix(std::min(token.find_first_not_of(" \t\n\r"), token.size()));
+		T value;
+		const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+		if (error == std::errc::result_out_of_range) {
+			throw std::out_of_range("CVar: value out of range");
+		}
+		if (error != std::errc() || end == token.data()) {
+			throw std::invalid_argument("CVar: invalid number");
+		}
+		return value;
+	}
+
 	bool CVar::get_boolean() const {
-		const auto lowercase = StringUtil::ToLower(m_sValue);
-		if (lowercase == "true") {
+		if (StringUtil::EqualsNoCase(m_sValue, "true")) {
 			return true;
 		}
-		if (lowercase == "false") {
+		if (StringUtil::EqualsNoCase(m_sValue, "false")) {
 			return false;
 		}
-		return std::stoul(lowercase) != 0;
+		return std::stoul(m_sValue) != 0;
 	}
 	int CVar::get_integer() const {
 		return std::stoi(m_sValue);
@@ -199,34 +216,40 @@ namespace gctk {
 		return std::stof(m_sValue);
 	}
 	Vector2 CVar::get_vector2() const {
-		const auto tokens = StringUtil::Split(m_sValue, ' ');
+		const ScratchScope scratch;
+		const auto tokens = StringUtil::Split(m_sValue, ' ', scratch.resource());
 		if (tokens.size() != 2) {
 			throw std::runtime_error("CVar::get_vector2: invalid number of tokens");
 		}
-		return Vector2 { std::stof(tokens[0]), std::stof(tokens[1]) };
+		return Vector2 { ParseToken<float>(tokens[0]), ParseToken<float>(tokens[1]) };
 	}
 	Vector3 CVar::get_vector3() const {
-		const auto tokens = StringUtil::Split(m_sValue, ' ');
+		const ScratchScope scratch;
+		const auto tokens = StringUtil::Split(m_sValue, ' ', scratch.resource());
 		if (tokens.size() != 3) {
 			throw std::runtime_error("CVar::get_vector3: invalid number of tokens");
 		}
-		return Vector3 { std::stof(tokens[0]), std::stof(tokens[1]), std::stof(tokens[2]) };
+		return Vector3 { ParseToken<float>(tokens[0]), ParseToken<float>(tokens[1]), ParseToken<float>(tokens[2]) };
 	}
 	Vector4 CVar::get_vector4() const {
-		const auto tokens = StringUtil::Split(m_sValue, ' ');
+		const ScratchScope scratch;
+		const auto tokens = StringUtil::Split(m_sValue, ' ', scratch.resource());
 		if (tokens.size() != 4) {
 			throw std::runtime_error("CVar::get_vector4: invalid number of tokens");
 		}
-		return Vector4 { std::stof(tokens[0]), std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]) };
+		return Vector4 {
+			ParseToken<float>(tokens[0]), ParseToken<float>(tokens[1]), ParseToken<float>(tokens[2]), ParseToken<float>(tokens[3])
+		};
 	}
 	Color CVar::get_color() const {
-		const auto tokens = StringUtil::Split(m_sValue, ' ');
+		const ScratchScope scratch;
+		const auto tokens = StringUtil::Split(m_sValue, ' ', scratch.resource());
 		if (tokens.size() == 3 || tokens.size() == 4) {
 			return Color::FromRgba(
-				std::stoul(tokens[0]),
-				std::stoul(tokens[1]),
-				std::stoul(tokens[2]),
-				tokens.size() == 4 ? std::stoul(tokens[3]) : 0xFF
+				ParseToken<unsigned long>(tokens[0]),
+				ParseToken<unsigned long>(tokens[1]),
+				ParseToken<unsigned long>(tokens[2]),
+				tokens.size() == 4 ? ParseToken<unsigned long>(tokens[3]) : 0xFF
 			);
 		}
 		throw std::runtime_error("CVar::get_color: invalid number of tokens");
@@ -282,8 +305,10 @@ namespace gctk {
 		return true;
 	}
 	bool Console::ExecuteCommand(const std::string& command) {
-		std::string name, temp;
-		std::vector<std::string> args;
+		GCTK_PROFILE_SCOPE("Console::ExecuteCommand");
+		const ScratchScope scratch;
+		std::pmr::string name(scratch.resource()), temp(scratch.resource());
+		std::pmr::vector<std::pmr::string> args(scratch.resource());
 		char quote = 0;
 		bool escape = false;
 		for (const auto& c : command) {
@@ -342,20 +367,28 @@ namespace gctk {
 			temp.clear();
 		}
 
-		if (CVar::FindCVar(name) == nullptr) {
+		CVar* cvar = CVar::FindCVar(name);
+		if (cvar == nullptr) {
 			return false;
 		}
 
-		const auto& cvar = CVar::FindCVar(name);
 		if (cvar->is_callable()) {
 			try {
-				return cvar->call(args);
+				return cvar->call(std::vector<std::string>(args.begin(), args.end()));
 			} catch (const EngineErrorException& error) {
 				Log(error.what(), MessageLevel::Error, error.caller_filename(), error.caller_line());
 				return false;
 			}
 		}
-		return cvar->set_value(StringUtil::Join(args, ' '));
+
+		std::pmr::string value(scratch.resource());
+		for (const auto& arg : args) {
+			if (!value.empty()) {
+				value.push_back(' ');
+			}
+			value += arg;
+		}
+		return cvar->set_value(std::string(value));
 	}
 
 #ifdef GCTK_CLIENT
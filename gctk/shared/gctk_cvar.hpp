@@ -34,7 +34,7 @@ namespace gctk {
 		CVar* m_pNext;
 		static CVar* s_cvars;
 
-		static CVar* FindCVar(const std::string& name);
+		static CVar* FindCVar(std::string_view name);
 		static CVar* GetLastCvar();
 	public:
 		CVar(const std::string& name, const std::string& defaultValue, int flags);
@@ -1,11 +1,20 @@
 #include "gctk_debug.hpp"
 
+#include <atomic>
 #include <fstream>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 #include <print>
+#include <thread>
+#include <unordered_map>
 
+#include "gctk_cvar.hpp"
 #include "gctk_version.hpp"
 #include "gctk_filesys.hpp"
+#include "gctk_ring_buffer.hpp"
+#include "gctk_str.hpp"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -18,46 +27,394 @@ static constexpr std::string_view s_loglevel_names[] = {
 };
 
 namespace gctk {
+	static bool UpdateLogLevel(const CVar* self, const std::string& value);
+	static bool UpdateLogOverflow(const CVar* self, const std::string& value);
+	static bool UpdateLogBinary(const CVar* self, const std::string& value);
+
+	CVar log_level("log_level", "info", CVAR_FLAG_USER_DATA, &UpdateLogLevel);
+	CVar log_overflow("log_overflow", "drop", CVAR_FLAG_USER_DATA, &UpdateLogOverflow);
+	CVar log_binary("log_binary", "false", CVAR_FLAG_USER_DATA, &UpdateLogBinary);
+
 	static std::ofstream s_logfile;
 	static bool s_no_filelog = false;
+	// Mirrors of the CVars, Log must not depend on their construction order
+	static std::atomic<int> s_min_log_level = static_cast<int>(MessageLevel::Info);
+	static std::atomic<bool> s_block_on_overflow = false;
+	static std::atomic<bool> s_binary_log = false;
+	// Serializes writing between the writer thread and the synchronous fallback
+	static std::recursive_mutex s_write_mutex;
 
 	static std::ofstream& GetLogFile();
 
-	void Log(const std::string& message, MessageLevel level, const char* file, long line) {
-		const auto formatted_msg = std::format(
-			"{} - {:%Y.%m.%d %H:%M:%S} [{}] \"{}\":{} {}",
+	struct LogRecord {
+		std::chrono::system_clock::time_point time;
+		// Packed arguments of format when it is set, the finished text otherwise
+		std::string message;
+		const char* file;
+		long line;
+		MessageLevel level;
+		const char* format = nullptr;
+	};
+
+	// Writes records in the .glog layout of gctk_log_format.hpp, every session starts a new file since site indices
+	// are only valid within one file. Callers hold s_write_mutex.
+	class BinaryLogWriter {
+		// Format used for records that were logged as finished text
+		static constexpr const char* TextFormat = "{}";
+
+		struct Site {
+			const char* format;
+			const char* file;
+			long line;
+			MessageLevel level;
+
+			bool operator==(const Site&) const = default;
+		};
+		struct SiteHash {
+			size_t operator()(const Site& site) const {
+				size_t hash = std::hash<const void*>()(site.format);
+				hash = hash * 31 + std::hash<const void*>()(site.file);
+				return hash * 31 + static_cast<size_t>(site.line) * 4 + static_cast<size_t>(site.level);
+			}
+		};
+
+		std::ofstream m_file;
+		std::unordered_map<Site, uint32_t, SiteHash> m_sites;
+		int64_t m_iLastTime = 0;
+		bool m_bFailed = false;
+	public:
+		// Does nothing when the file could not be opened
+		void append(std::string& out, const LogRecord& record) {
+			if (!open()) {
+				return;
+			}
+
+			const Site site { record.format != nullptr ? record.format : TextFormat, record.file, record.line, record.level };
+			auto [it, inserted] = m_sites.try_emplace(site, static_cast<uint32_t>(m_sites.size()));
+			if (inserted) {
+				out.push_back(static_cast<char>(BinaryLog::RecordType::Site));
+				BinaryLog::WriteVarint(out, it->second);
+				out.push_back(static_cast<char>(site.level));
+				BinaryLog::WriteVarint(out, static_cast<uint64_t>(site.line));
+				BinaryLog::WriteString(out, site.file);
+				BinaryLog::WriteString(out, site.format);
+			}
+
+			const int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+			out.push_back(static_cast<char>(BinaryLog::RecordType::Message));
+			BinaryLog::WriteVarint(out, it->second);
+			BinaryLog::WriteVarint(out, BinaryLog::ZigZag(time - m_iLastTime));
+			m_iLastTime = time;
+			if (record.format != nullptr) {
+				out += record.message;
+			} else {
+				BinaryLog::PackArgs(out, site.format, record.message);
+			}
+		}
+		void write(const std::string& data) {
+			if (m_file.is_open()) {
+				m_file.write(data.data(), static_cast<std::streamsize>(data.size()));
+				m_file.flush();
+			}
+		}
+		void close() {
+			if (m_file.is_open()) {
+				m_file.close();
+			}
+			m_sites.clear();
+		}
+	private:
+		bool open() {
+			if (m_file.is_open() || m_bFailed) {
+				return m_file.is_open();
+			}
+
+			const auto now = std::chrono::system_clock::now();
+			auto path = Paths::GameBasePath() / "logs";
+			if (!Paths::exists(path)) {
+				Paths::create_directories(path);
+			}
+			path /= std::format("log_{:%Y_%m_%d_%H%M%S}.glog", std::chrono::floor<std::chrono::seconds>(now));
+			m_file = std::ofstream(path, std::ios::out | std::ios::binary);
+			if (!m_file.is_open()) {
+				m_bFailed = true;
+				LogWarn("Failed to open binary log file \"{}\"", path);
+				return false;
+			}
+
+			BinaryLog::Header header { };
+			std::memcpy(header.identifier, BinaryLog::Identifier, sizeof(header.identifier));
+			header.version = BinaryLog::Version;
+#ifdef GCTK_SERVER
+			header.flags = BinaryLog::FlagServer;
+#endif
+			m_iLastTime = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+			header.start_time = m_iLastTime;
+			m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			m_sites.clear();
+			LogInfo("Opened binary log file \"{}\"", path);
+			return true;
+		}
+	};
+	static BinaryLogWriter s_binary_logfile;
+
+	// Bounded queue for any number of producers and a single consumer. Every cell holds the queue position it expects
+	// next, so producers claim a cell with one CAS and the consumer never touches the producer side.
+	class LogQueue {
+		static constexpr size_t Capacity = 4096;
+
+		struct Cell {
+			std::atomic<size_t> sequence;
+			LogRecord record;
+		};
+
+		alignas(CacheLineSize) std::atomic<size_t> m_uEnqueue;
+		alignas(CacheLineSize) size_t m_uDequeue;
+		std::unique_ptr<Cell[]> m_cells;
+	public:
+		LogQueue() : m_uEnqueue(0), m_uDequeue(0), m_cells(std::make_unique<Cell[]>(Capacity)) {
+			for (size_t i = 0; i < Capacity; i++) {
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// Leaves record untouched when the queue is full
+		bool try_push(LogRecord& record) {
+			size_t position = m_uEnqueue.load(std::memory_order_relaxed);
+			while (true) {
+				Cell& cell = m_cells[position & (Capacity - 1)];
+				const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				if (sequence == position) {
+					if (m_uEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						cell.record = std::move(record);
+						cell.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (sequence < position) {
+					return false;
+				} else {
+					position = m_uEnqueue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		bool try_pop(LogRecord& out) {
+			Cell& cell = m_cells[m_uDequeue & (Capacity - 1)];
+			if (cell.sequence.load(std::memory_order_acquire) != m_uDequeue + 1) {
+				return false;
+			}
+			out = std::move(cell.record);
+			cell.sequence.store(m_uDequeue + Capacity, std::memory_order_release);
+			m_uDequeue++;
+			return true;
+		}
+
+		[[nodiscard]] size_t pushed() const { return m_uEnqueue.load(std::memory_order_acquire); }
+	};
+
+	static void AppendTextRecord(std::string& out, const LogRecord& record) {
+		std::format_to(std::back_inserter(out),
+			"{} - {:%Y.%m.%d %H:%M:%S} [{}] \"{}\":{} {}\n",
 #ifdef GCTK_CLIENT
 			"CLIENT",
 #else
 			"SERVER",
 #endif
-			std::chrono::system_clock::now(),
-			s_loglevel_names[static_cast<int>(level)],
-			file, line,
-			message
+			record.time,
+			s_loglevel_names[static_cast<int>(record.level)],
+			record.file, record.line,
+			record.message
 		);
-
-		if (!s_no_filelog) {
-			if (auto& log_file = GetLogFile(); log_file.is_open()) {
-				log_file << formatted_msg << std::endl;
-			}
-		}
-#ifdef _WIN32
-#else
-		switch (level) {
-			case MessageLevel::Warning: std::print("\x1B[33;1m"); break;
-			case MessageLevel::Error: std::print("\x1B[31;1m"); break;
+	}
+	static void AppendConsoleRecord(std::string& out, const LogRecord& record) {
+#ifndef _WIN32
+		switch (record.level) {
+			case MessageLevel::Warning: out += "\x1B[33;1m"; break;
+			case MessageLevel::Error: out += "\x1B[31;1m"; break;
 			default: /* Nothing to do */ break;
 		}
 #endif
-		std::println("{}", formatted_msg);
-#ifdef _WIN32
-#else
-		if (level != MessageLevel::Info) {
-			std::print("\x1B[0m");
+		AppendTextRecord(out, record);
+#ifndef _WIN32
+		if (record.level != MessageLevel::Info) {
+			out += "\x1B[0m";
 		}
 #endif
 	}
+	// The console always gets text, the file gets the binary encoding instead when binary is set
+	static void AppendRecord(std::string& file_out, std::string& console_out, LogRecord& record, const bool binary) {
+		if (binary) {
+			std::lock_guard lock(s_write_mutex);
+			s_binary_logfile.append(file_out, record);
+		}
+		if (record.format != nullptr) {
+			record.message = BinaryLog::FormatPacked(record.format, record.message);
+			record.format = nullptr;
+		}
+		if (!binary) {
+			AppendTextRecord(file_out, record);
+		}
+		AppendConsoleRecord(console_out, record);
+	}
+	static void WriteBatch(const std::string& file_text, const std::string& console_text, const bool binary) {
+		std::lock_guard lock(s_write_mutex);
+		if (binary) {
+			s_binary_logfile.write(file_text);
+		} else if (!s_no_filelog) {
+			if (auto& log_file = GetLogFile(); log_file.is_open()) {
+				log_file.write(file_text.data(), static_cast<std::streamsize>(file_text.size()));
+				log_file.flush();
+			}
+		}
+		std::fwrite(console_text.data(), 1, console_text.size(), stdout);
+		std::fflush(stdout);
+	}
+
+	// Callers only move their record into the queue, a background thread formats and writes them in batches
+	class AsyncLogger {
+		static constexpr size_t MaxBatch = 256;
+
+		LogQueue m_queue;
+		std::thread m_thread;
+		std::once_flag m_started;
+		std::atomic<bool> m_bRunning = false;
+		// Bumped on every push, the writer thread waits on it while the queue is empty
+		std::atomic<uint32_t> m_uSignal = 0;
+		std::atomic<uint64_t> m_uWritten = 0;
+		std::atomic<uint64_t> m_uDropped = 0;
+	public:
+		~AsyncLogger() {
+			stop();
+		}
+
+		// Returns false once the writer was stopped, the caller writes the record itself then
+		bool push(LogRecord& record) {
+			std::call_once(m_started, [this] {
+				m_bRunning = true;
+				m_thread = std::thread(&AsyncLogger::run, this);
+			});
+			if (!m_bRunning.load(std::memory_order_acquire)) {
+				return false;
+			}
+
+			// The writer thread logging itself (e.g. failing to open the file) must not wait for its own queue
+			const bool block = s_block_on_overflow.load(std::memory_order_relaxed) && std::this_thread::get_id() != m_thread.get_id();
+			while (!m_queue.try_push(record)) {
+				if (!block) {
+					m_uDropped.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+				wake();
+				std::this_thread::yield();
+			}
+			wake();
+			return true;
+		}
+
+		// Waits until everything queued before the call was written
+		void flush() {
+			if (!m_bRunning.load(std::memory_order_acquire) || std::this_thread::get_id() == m_thread.get_id()) {
+				return;
+			}
+			const uint64_t target = m_queue.pushed();
+			for (uint64_t written = m_uWritten.load(std::memory_order_acquire); written < target; written = m_uWritten.load(std::memory_order_acquire)) {
+				wake();
+				m_uWritten.wait(written, std::memory_order_acquire);
+			}
+		}
+		// Writes what is still queued and joins the writer thread
+		void stop() {
+			if (m_bRunning.exchange(false) && m_thread.joinable()) {
+				wake();
+				if (std::this_thread::get_id() != m_thread.get_id()) {
+					m_thread.join();
+				} else {
+					m_thread.detach();
+				}
+			}
+		}
+	private:
+		void wake() {
+			m_uSignal.fetch_add(1, std::memory_order_release);
+			m_uSignal.notify_one();
+		}
+
+		void run() {
+			std::string file_text, console_text;
+			LogRecord record;
+			while (true) {
+				const uint32_t signal = m_uSignal.load(std::memory_order_acquire);
+
+				size_t count = 0;
+				file_text.clear();
+				console_text.clear();
+				const bool binary = s_binary_log.load(std::memory_order_relaxed);
+				const uint64_t dropped = m_uDropped.exchange(0, std::memory_order_relaxed);
+				if (dropped > 0) {
+					LogRecord notice {
+						std::chrono::system_clock::now(), std::format("{} log messages were dropped, the queue was full", dropped),
+						__FILE__, __LINE__, MessageLevel::Warning
+					};
+					AppendRecord(file_text, console_text, notice, binary);
+				}
+				while (count < MaxBatch && m_queue.try_pop(record)) {
+					AppendRecord(file_text, console_text, record, binary);
+					count++;
+				}
+
+				if (count > 0 || dropped > 0) {
+					WriteBatch(file_text, console_text, binary);
+					m_uWritten.fetch_add(count, std::memory_order_release);
+					m_uWritten.notify_all();
+					continue;
+				}
+				if (!m_bRunning.load(std::memory_order_acquire)) {
+					break;
+				}
+				m_uSignal.wait(signal, std::memory_order_acquire);
+			}
+		}
+	};
+	static AsyncLogger s_logger;
+
+	static void PushRecord(LogRecord& record) {
+		if (s_logger.push(record)) {
+			return;
+		}
+
+		const bool binary = s_binary_log.load(std::memory_order_relaxed);
+		std::string file_text, console_text;
+		AppendRecord(file_text, console_text, record, binary);
+		WriteBatch(file_text, console_text, binary);
+	}
+
+	void Log(std::string&& message, MessageLevel level, const char* file, long line) {
+		if (!IsLogLevelEnabled(level)) {
+			return;
+		}
+
+		LogRecord record { std::chrono::system_clock::now(), std::move(message), file, line, level };
+		PushRecord(record);
+	}
+	void Log(const std::string& message, MessageLevel level, const char* file, long line) {
+		Log(std::string(message), level, file, line);
+	}
+	void LogPacked(const char* format, std::string&& packed, MessageLevel level, const char* file, long line) {
+		if (!IsLogLevelEnabled(level)) {
+			return;
+		}
+
+		LogRecord record { std::chrono::system_clock::now(), std::move(packed), file, line, level, format };
+		PushRecord(record);
+	}
+	bool IsLogLevelEnabled(const MessageLevel level) {
+		return static_cast<int>(level) >= s_min_log_level.load(std::memory_order_relaxed);
+	}
+	bool IsBinaryLogEnabled() {
+		return s_binary_log.load(std::memory_order_relaxed);
+	}
+	void FlushDebugLog() {
+		s_logger.flush();
+	}
 
 	void AssertLog(const std::string& expression, const std::string& failure_message, bool fatal, const char* file, long line) {
 		Log(std::format(R"(Assertion of expression "{}" failed: "{}")", expression, failure_message),
@@ -70,6 +427,8 @@ namespace gctk {
 	}
 
 	void DoCrash(const std::string& message) {
+		// Get the messages leading up to the crash into the log first
+		s_logger.stop();
 		ErrorPopup(message);
 		std::println("{:%Y.%m.%d %H:%M:%S} - Game has crashed! \"{}\"", std::chrono::system_clock::now(), message);
 		if (s_logfile.is_open()) {
@@ -93,10 +452,13 @@ namespace gctk {
 	}
 
 	void CloseDebugLog() {
+		s_logger.stop();
+		std::lock_guard lock(s_write_mutex);
 		if (s_logfile.is_open()) {
 			s_logfile.flush();
 			s_logfile.close();
 		}
+		s_binary_logfile.close();
 	}
 
 	static std::ofstream& GetLogFile() {
@@ -123,4 +485,39 @@ namespace gctk {
 		}
 		return s_logfile;
 	}
+	static bool UpdateLogLevel(const CVar* self, const std::string& value) {
+		(void)self;
+		const std::string lowercase = StringUtil::ToLower(StringUtil::Trim(value));
+		if (lowercase == "info" || lowercase == "0") {
+			s_min_log_level = static_cast<int>(MessageLevel::Info);
+		} else if (lowercase == "warn" || lowercase == "warning" || lowercase == "1") {
+			s_min_log_level = static_cast<int>(MessageLevel::Warning);
+		} else if (lowercase == "error" || lowercase == "2") {
+			s_min_log_level = static_cast<int>(MessageLevel::Error);
+		} else {
+			return false;
+		}
+		return true;
+	}
+	static bool UpdateLogOverflow(const CVar* self, const std::string& value) {
+		(void)self;
+		const std::string lowercase = StringUtil::ToLower(StringUtil::Trim(value));
+		if (lowercase != "drop" && lowercase != "block") {
+			return false;
+		}
+		s_block_on_overflow = lowercase == "block";
+		return true;
+	}
+	static bool UpdateLogBinary(const CVar* self, const std::string& value) {
+		(void)self;
+		const std::string lowercase = StringUtil::ToLower(StringUtil::Trim(value));
+		if (lowercase == "true" || lowercase == "1") {
+			s_binary_log = true;
+		} else if (lowercase == "false" || lowercase == "0") {
+			s_binary_log = false;
+		} else {
+			return false;
+		}
+		return true;
+	}
 }
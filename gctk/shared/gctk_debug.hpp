@@ -4,6 +4,17 @@
 #include <string>
 #include <format>
 
+#include "gctk_log_format.hpp"
+
+// Log calls below this level are compiled out together with their arguments: 0 info, 1 warning, 2 error
+#ifndef GCTK_LOG_MIN_LEVEL
+	#ifdef NDEBUG
+		#define GCTK_LOG_MIN_LEVEL 1
+	#else
+		#define GCTK_LOG_MIN_LEVEL 0
+	#endif
+#endif
+
 namespace gctk {
 	enum class MessageLevel {
 		Info,
@@ -11,49 +22,82 @@ namespace gctk {
 		Error
 	};
 
+	// Queues the message for the log writer thread, which adds the time stamp and writes to the console and the log file.
+	// file is kept until the message is written, so it has to be a string literal like __FILE__.
+	void Log(std::string&& message, MessageLevel level, const char* file, long line);
 	void Log(const std::string& message, MessageLevel level, const char* file, long line);
+	// Queues arguments packed with BinaryLog::PackArgs, format is only formatted on the writer thread.
+	// format has to outlive the logger as well, like a string literal.
+	void LogPacked(const char* format, std::string&& packed, MessageLevel level, const char* file, long line);
+	// Runtime filter set by the log_level CVar, checked before any formatting happens
+	bool IsLogLevelEnabled(MessageLevel level);
+	bool IsBinaryLogEnabled();
 	void AssertLog(const std::string& expression, const std::string& failure_message, bool fatal, const char* file, long line);
 	void DoCrash(const std::string& message);
+	// Waits until the writer thread wrote every message queued so far
+	void FlushDebugLog();
 	void CloseDebugLog();
 	void ErrorPopup(const std::string& message);
 
+	template<typename... Args>
+	void LogMessage(const MessageLevel level, const char* file, const long line, std::format_string<Args...> format, Args&&... args) {
+		if (IsBinaryLogEnabled()) {
+			std::string packed;
+			BinaryLog::PackArgs(packed, format.get(), args...);
+			LogPacked(format.get().data(), std::move(packed), level, file, line);
+		} else {
+			Log(std::format(format, std::forward<Args>(args)...), level, file, line);
+		}
+	}
+
 	class EngineErrorException final : public std::exception {
 		std::string m_sMessage;
-		std::string m_sCallerFileName;
+		const char* m_pCallerFileName;
 		long m_iCallerLine;
 		std::chrono::time_point<std::chrono::system_clock> m_tTimeStamp;
 	public:
 		EngineErrorException(const std::string& message, const char* caller_file, const long caller_line) :
-			m_sMessage(message), m_sCallerFileName(caller_file), m_iCallerLine(caller_line),
+			m_sMessage(message), m_pCallerFileName(caller_file), m_iCallerLine(caller_line),
 			m_tTimeStamp(std::chrono::system_clock::now()) { }
 		EngineErrorException(std::string&& message, const char* caller_file, const long caller_line) noexcept :
-		m_sMessage(std::move(message)), m_sCallerFileName(caller_file), m_iCallerLine(caller_line),
+		m_sMessage(std::move(message)), m_pCallerFileName(caller_file), m_iCallerLine(caller_line),
 		m_tTimeStamp(std::chrono::system_clock::now()) { }
 
 		[[nodiscard]] constexpr const char* what() const noexcept override { return m_sMessage.c_str(); }
-		[[nodiscard]] constexpr const char* caller_filename() const noexcept { return m_sCallerFileName.c_str(); }
+		[[nodiscard]] constexpr const char* caller_filename() const noexcept { return m_pCallerFileName; }
 		[[nodiscard]] constexpr long caller_line() const noexcept { return m_iCallerLine; }
 
 		[[nodiscard]] inline std::string message() const {
 			return std::format(
 				"{:%Y.%m.%d %H:%M:%S} [EXCEPTION] \"{}\":{} {}",
 				std::chrono::system_clock::now(),
-				m_sCallerFileName, m_iCallerLine,
+				m_pCallerFileName, m_iCallerLine,
 				m_sMessage
 			);
 		}
 	};
 }
 
-#ifndef NDEBUG
-	#define LogInfo(__message, ...) gctk::Log(std::format(__message, ##__VA_ARGS__), gctk::MessageLevel::Info,    __FILE__, __LINE__)
+#define GCTK_LOG(__level, __message, ...) \
+	(gctk::IsLogLevelEnabled(__level) ? gctk::LogMessage(__level, __FILE__, __LINE__, __message, ##__VA_ARGS__) : static_cast<void>(0))
+
+#if GCTK_LOG_MIN_LEVEL <= 0
+	#define LogInfo(__message, ...) GCTK_LOG(gctk::MessageLevel::Info,    __message, ##__VA_ARGS__)
+#else
+	#define LogInfo(__message, ...) static_cast<void>(0)
+#endif
+#if GCTK_LOG_MIN_LEVEL <= 1
+	#define LogWarn(__message, ...) GCTK_LOG(gctk::MessageLevel::Warning, __message, ##__VA_ARGS__)
+#else
+	#define LogWarn(__message, ...) static_cast<void>(0)
+#endif
+#if GCTK_LOG_MIN_LEVEL <= 2
+	#define LogErr(__message, ...) GCTK_LOG(gctk::MessageLevel::Error,   __message, ##__VA_ARGS__)
 #else
-	#define LogInfo(__message)
+	#define LogErr(__message, ...) static_cast<void>(0)
 #endif
 
-#define LogWarn(__message, ...) gctk::Log(std::format(__message, ##__VA_ARGS__), gctk::MessageLevel::Warning, __FILE__, __LINE__)
-#define LogErr(__message, ...) gctk::Log(std::format(__message, ##__VA_ARGS__), gctk::MessageLevel::Error,   __FILE__, __LINE__)
-#define LogErrAndPopup(__message, ...) gctk::Log(std::format(__message, ##__VA_ARGS__), gctk::MessageLevel::Error,   __FILE__, __LINE__); gctk::ErrorPopup(__message)
+#define LogErrAndPopup(__message, ...) LogErr(__message, ##__VA_ARGS__); gctk::ErrorPopup(__message)
 #define FatalError(__message, ...) { LogErr(__message, ##__VA_ARGS__); gctk::DoCrash(std::format(__message, ##__VA_ARGS__)); }
 #define LogErrThrow(__message, ...) { LogErr(__message, ##__VA_ARGS__); throw gctk::EngineErrorException(std::format(__message, ##__VA_ARGS__), __FILE__, __LINE__); }
 #define Assert(__expression, __failure_message, ...) \
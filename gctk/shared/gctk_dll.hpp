@@ -41,7 +41,7 @@ namespace gctk {
 		}
 
 		template<PointerType T>
-		inline T get_symbol(const std::string& name) const {
+		inline T get_symbol(const std::string& name, const bool required = true) const {
 			const char* name_cstr = name.c_str();
 			T result = nullptr;
 #ifdef _WIN32
@@ -49,7 +49,7 @@ namespace gctk {
 #else
 			result = reinterpret_cast<T>(dlsym(m_pModule, name_cstr));
 #endif
-			if (result == nullptr) {
+			if (result == nullptr && required) {
 				LogErr("Failed to load symbol \"{}\" from DLL \"{}\"", name_cstr, m_sPath);
 			}
 			return result;
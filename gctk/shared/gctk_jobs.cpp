@@ -0,0 +1,387 @@
+#include "gctk_jobs.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_profiler.hpp"
+#include "gctk_ring_buffer.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	CVar job_threads("job_threads", "0", CVAR_FLAG_USER_DATA, [](const CVar*, const std::string& value) {
+		int32_t count;
+		return StringUtil::ParseInt(value, count) && count >= 0;
+	});
+
+	// Parallel loops are split into up to this many ranges per thread, so a stalled worker's share can be stolen
+	static constexpr size_t RangesPerThread = 4;
+
+	struct Job {
+		JobFunction fn;
+		JobCounter* counter;
+	};
+
+	// Chase-Lev deque: the owning worker pushes and pops at the bottom, other threads steal from the top
+	class WorkStealingDeque {
+		static constexpr int64_t Capacity = 4096;
+
+		alignas(CacheLineSize) std::atomic<int64_t> m_iTop;
+		alignas(CacheLineSize) std::atomic<int64_t> m_iBottom;
+		std::array<std::atomic<Job*>, Capacity> m_jobs;
+	public:
+		WorkStealingDeque() : m_iTop(0), m_iBottom(0) { }
+
+		bool push(Job* job) {
+			const int64_t bottom = m_iBottom.load(std::memory_order_relaxed);
+			const int64_t top = m_iTop.load(std::memory_order_acquire);
+			if (bottom - top >= Capacity) {
+				return false;
+			}
+			m_jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_iBottom.store(bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+		Job* pop() {
+			const int64_t bottom = m_iBottom.load(std::memory_order_relaxed) - 1;
+			m_iBottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_iTop.load(std::memory_order_relaxed);
+			if (top > bottom) {
+				m_iBottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+			if (top == bottom) {
+				// Last job, race the thieves for it
+				if (!m_iTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					job = nullptr;
+				}
+				m_iBottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+		Job* steal() {
+			int64_t top = m_iTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = m_iBottom.load(std::memory_order_acquire);
+			if (top >= bottom) {
+				return nullptr;
+			}
+
+			Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+			if (!m_iTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return job;
+		}
+	};
+
+	// Cached per module, a worker of a scheduler attached from another module has to be looked up by its thread id once
+	static thread_local const JobScheduler* s_worker_scheduler = nullptr;
+	static thread_local int32_t s_worker_index = -1;
+
+	class JobScheduler {
+		struct Worker {
+			WorkStealingDeque deque;
+			std::thread thread;
+		};
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::once_flag m_started;
+		std::atomic<bool> m_bRunning = false;
+		// Set once every worker thread exists
+		std::atomic<bool> m_bStarted = false;
+
+		// Jobs submitted from threads without a deque, or while the own deque is full
+		std::mutex m_queueMutex;
+		std::deque<Job*> m_queue;
+		std::mutex m_mainMutex;
+		std::deque<Job*> m_mainQueue;
+		std::atomic<std::thread::id> m_mainThread;
+
+		// Jobs sitting in any queue but the main thread one, the workers sleep while it is zero
+		std::atomic<int64_t> m_iQueued = 0;
+		std::atomic<int32_t> m_iSleeping = 0;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_cvWake;
+	public:
+		~JobScheduler() {
+			m_bRunning = false;
+			{
+				std::lock_guard lock(m_sleepMutex);
+			}
+			m_cvWake.notify_all();
+			for (const auto& worker : m_workers) {
+				if (worker->thread.joinable()) {
+					worker->thread.join();
+				}
+			}
+
+			// Whatever was still queued never runs
+			for (const auto& worker : m_workers) {
+				while (const Job* job = worker->deque.steal()) {
+					delete job;
+				}
+			}
+			for (const Job* job : m_queue) {
+				delete job;
+			}
+			for (const Job* job : m_mainQueue) {
+				delete job;
+			}
+		}
+
+		void start() {
+			std::call_once(m_started, [this] {
+				const size_t count = job_threads.get_integer() > 0 ?
+					static_cast<size_t>(job_threads.get_integer()) : std::max(1u, std::thread::hardware_concurrency()) - 1;
+				m_bRunning = true;
+				for (size_t i = 0; i < count; i++) {
+					m_workers.emplace_back(std::make_unique<Worker>());
+				}
+				// Every deque exists before the first worker starts stealing
+				for (size_t i = 0; i < count; i++) {
+					m_workers[i]->thread = std::thread(&JobScheduler::worker_main, this, static_cast<int32_t>(i));
+				}
+				m_bStarted = true;
+			});
+		}
+
+		size_t worker_count() {
+			start();
+			return m_workers.size();
+		}
+		int32_t worker_index() {
+			if (s_worker_scheduler != this) {
+				if (!m_bStarted) {
+					return -1;
+				}
+				s_worker_scheduler = this;
+				s_worker_index = -1;
+				const auto id = std::this_thread::get_id();
+				for (size_t i = 0; i < m_workers.size(); i++) {
+					if (m_workers[i]->thread.get_id() == id) {
+						s_worker_index = static_cast<int32_t>(i);
+						break;
+					}
+				}
+			}
+			return s_worker_index;
+		}
+
+		void submit(Job* job) {
+			start();
+			if (m_workers.empty()) {
+				execute(job);
+				return;
+			}
+
+			m_iQueued.fetch_add(1);
+			if (const int32_t index = worker_index(); index < 0 || !m_workers[index]->deque.push(job)) {
+				std::lock_guard lock(m_queueMutex);
+				m_queue.push_back(job);
+			}
+			if (m_iSleeping.load() > 0) {
+				// Taking the lock orders this wake-up after a worker's last look at the queues
+				{
+					std::lock_guard lock(m_sleepMutex);
+				}
+				m_cvWake.notify_one();
+			}
+		}
+		void submit_main(Job* job) {
+			std::lock_guard lock(m_mainMutex);
+			m_mainQueue.push_back(job);
+		}
+		void submit_after(Job* job, JobCounter& dependency) {
+			{
+				std::lock_guard lock(dependency.m_mutex);
+				if (!dependency.is_done()) {
+					dependency.m_continuations.push_back(job);
+					return;
+				}
+			}
+			submit(job);
+		}
+		// The counter drops to zero under its lock, so a waiter holding the lock afterwards knows the counter is released
+		void finish(JobCounter& counter) {
+			uint32_t pending = counter.m_uPending.load(std::memory_order_relaxed);
+			while (pending > 1) {
+				if (counter.m_uPending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel)) {
+					return;
+				}
+			}
+
+			std::vector<Job*> ready;
+			{
+				std::lock_guard lock(counter.m_mutex);
+				if (counter.m_uPending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+					return;
+				}
+				ready.swap(counter.m_continuations);
+			}
+			for (Job* job : ready) {
+				submit(job);
+			}
+		}
+		void wait(const JobCounter& counter) {
+			while (!counter.is_done()) {
+				if (!run_one()) {
+					std::this_thread::yield();
+				}
+			}
+			std::lock_guard lock(counter.m_mutex);
+		}
+
+		void run_main_jobs() {
+			m_mainThread = std::this_thread::get_id();
+			// Jobs queued by these jobs wait for the next call
+			std::deque<Job*> jobs;
+			{
+				std::lock_guard lock(m_mainMutex);
+				jobs.swap(m_mainQueue);
+			}
+			for (Job* job : jobs) {
+				execute(job);
+			}
+		}
+	private:
+		void execute(Job* job) {
+			GCTK_PROFILE_SCOPE("Job");
+			try {
+				job->fn();
+			} catch (const std::exception& e) {
+				LogErr("Unhandled exception in job: {}", e.what());
+			}
+			JobCounter* counter = job->counter;
+			delete job;
+			if (counter != nullptr) {
+				finish(*counter);
+			}
+		}
+
+		Job* find_job(const int32_t index) {
+			Job* job = index >= 0 ? m_workers[index]->deque.pop() : nullptr;
+			if (job == nullptr) {
+				std::lock_guard lock(m_queueMutex);
+				if (!m_queue.empty()) {
+					job = m_queue.front();
+					m_queue.pop_front();
+				}
+			}
+			const auto count = static_cast<int32_t>(m_workers.size());
+			for (int32_t i = 1; job == nullptr && i <= count; i++) {
+				job = m_workers[(index + i + count) % count]->deque.steal();
+			}
+			if (job != nullptr) {
+				m_iQueued.fetch_sub(1);
+			}
+			return job;
+		}
+
+		bool run_one() {
+			if (Job* job = find_job(worker_index()); job != nullptr) {
+				execute(job);
+				return true;
+			}
+			if (m_mainThread.load() != std::this_thread::get_id()) {
+				return false;
+			}
+
+			Job* job = nullptr;
+			{
+				std::lock_guard lock(m_mainMutex);
+				if (!m_mainQueue.empty()) {
+					job = m_mainQueue.front();
+					m_mainQueue.pop_front();
+				}
+			}
+			if (job == nullptr) {
+				return false;
+			}
+			execute(job);
+			return true;
+		}
+
+		void worker_main(const int32_t index) {
+			s_worker_scheduler = this;
+			s_worker_index = index;
+			Profiler::SetThreadName(std::format("Job worker {}", index));
+			while (m_bRunning) {
+				if (Job* job = find_job(index); job != nullptr) {
+					execute(job);
+					continue;
+				}
+
+				std::unique_lock lock(m_sleepMutex);
+				m_iSleeping.fetch_add(1);
+				m_cvWake.wait(lock, [this] { return m_iQueued.load() > 0 || !m_bRunning; });
+				m_iSleeping.fetch_sub(1);
+			}
+		}
+	};
+	static JobScheduler s_own_scheduler;
+	static std::atomic<JobScheduler*> s_scheduler = &s_own_scheduler;
+
+	static JobScheduler& CurrentScheduler() {
+		return *s_scheduler.load(std::memory_order_acquire);
+	}
+
+	void JobCounter::finish() {
+		CurrentScheduler().finish(*this);
+	}
+
+	void Jobs::Run(JobFunction fn, JobCounter* counter) {
+		if (counter != nullptr) {
+			counter->add();
+		}
+		CurrentScheduler().submit(new Job { std::move(fn), counter });
+	}
+	void Jobs::Run(JobFunction fn, JobCounter* counter, JobCounter& dependency) {
+		if (counter != nullptr) {
+			counter->add();
+		}
+		CurrentScheduler().submit_after(new Job { std::move(fn), counter }, dependency);
+	}
+	void Jobs::RunOnMainThread(JobFunction fn, JobCounter* counter) {
+		if (counter != nullptr) {
+			counter->add();
+		}
+		CurrentScheduler().submit_main(new Job { std::move(fn), counter });
+	}
+	void Jobs::RunMainThreadJobs() {
+		CurrentScheduler().run_main_jobs();
+	}
+
+	void Jobs::Wait(const JobCounter& counter) {
+		CurrentScheduler().wait(counter);
+	}
+
+	size_t Jobs::WorkerCount() {
+		return CurrentScheduler().worker_count();
+	}
+	bool Jobs::IsWorkerThread() {
+		return CurrentScheduler().worker_index() >= 0;
+	}
+	size_t Jobs::SplitCount(const size_t count, const size_t min_batch) {
+		const size_t threads = CurrentScheduler().worker_count() + 1;
+		if (threads == 1) {
+			return 1;
+		}
+		return std::clamp<size_t>(count / std::max<size_t>(min_batch, 1), 1, threads * RangesPerThread);
+	}
+
+	JobScheduler* Jobs::Scheduler() {
+		return s_scheduler.load(std::memory_order_acquire);
+	}
+	void Jobs::Attach(JobScheduler* scheduler) {
+		s_scheduler.store(scheduler != nullptr ? scheduler : &s_own_scheduler, std::memory_order_release);
+	}
+}
\ No newline at end of file
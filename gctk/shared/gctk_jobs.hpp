@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace gctk {
+	using JobFunction = std::function<void()>;
+
+	struct Job;
+	class JobScheduler;
+
+	// Counts unfinished jobs, jobs submitted with a counter increment it and decrement it once they have run.
+	// Jobs can also be made to wait for a counter, they are queued once it drops to zero.
+	// Only destroy a counter after Jobs::Wait returned for it, is_done() alone does not mean the last job let go of it.
+	class JobCounter {
+		std::atomic<uint32_t> m_uPending;
+		mutable std::mutex m_mutex;
+		std::vector<Job*> m_continuations;
+
+		friend class JobScheduler;
+	public:
+		JobCounter() : m_uPending(0) { }
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		// For work finished outside the job system, like an IO callback
+		inline void add(const uint32_t count = 1) { m_uPending.fetch_add(count, std::memory_order_relaxed); }
+		void finish();
+
+		[[nodiscard]] inline uint32_t pending() const { return m_uPending.load(std::memory_order_acquire); }
+		[[nodiscard]] inline bool is_done() const { return pending() == 0; }
+	};
+
+	// Worker threads with one work-stealing deque each. The workers start on first use, their count is job_threads
+	// or one less than the hardware threads, since threads waiting for a counter run queued jobs meanwhile.
+	namespace Jobs {
+		void Run(JobFunction fn, JobCounter* counter = nullptr);
+		// Queued once dependency is done
+		void Run(JobFunction fn, JobCounter* counter, JobCounter& dependency);
+		// Queued for the thread calling RunMainThreadJobs, on the client that is the thread owning the GL context
+		void RunOnMainThread(JobFunction fn, JobCounter* counter = nullptr);
+		void RunMainThreadJobs();
+
+		// Runs queued jobs until the counter drops to zero
+		void Wait(const JobCounter& counter);
+
+		[[nodiscard]] size_t WorkerCount();
+		[[nodiscard]] bool IsWorkerThread();
+		// Number of ranges a parallel loop over count items should use, at least min_batch items each
+		[[nodiscard]] size_t SplitCount(size_t count, size_t min_batch);
+
+		// Every module links its own copy of the engine, the singleplayer launcher attaches its scheduler to the client
+		// and server modules so they share one set of workers. Attach before the module runs its first job.
+		JobScheduler* Scheduler();
+		void Attach(JobScheduler* scheduler);
+
+		// Runs fn(begin, end) over [0, count), the calling thread takes the first range and waits for the rest.
+		// Ranges start at multiples of 4, so SIMD kernels only get a scalar tail in the last one.
+		template<typename Fn>
+		void ParallelFor(const size_t count, const size_t min_batch, Fn&& fn) {
+			const size_t ranges = SplitCount(count, min_batch);
+			if (ranges <= 1) {
+				fn(static_cast<size_t>(0), count);
+				return;
+			}
+
+			const size_t chunk = ((count + ranges - 1) / ranges + 3) & ~static_cast<size_t>(3);
+			JobCounter counter;
+			for (size_t begin = chunk; begin < count; begin += chunk) {
+				Run([&fn, begin, end = std::min(begin + chunk, count)] { fn(begin, end); }, &counter);
+			}
+			fn(static_cast<size_t>(0), std::min(chunk, count));
+			Wait(counter);
+		}
+	}
+}
\ No newline at end of file
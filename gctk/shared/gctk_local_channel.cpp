@@ -0,0 +1,49 @@
+#include "gctk_local_channel.hpp"
+
+#include <cstring>
+
+#include "gctk_debug.hpp"
+
+namespace gctk {
+	static LocalChannel* s_local_channel = nullptr;
+
+	void LocalConnection::Attach(LocalChannel* channel) {
+		s_local_channel = channel;
+	}
+	void LocalConnection::Detach() {
+		s_local_channel = nullptr;
+	}
+	bool LocalConnection::IsAttached() {
+		return s_local_channel != nullptr;
+	}
+
+	bool LocalConnection::Send(const uint16_t type, const void* data, const size_t size) {
+		if (s_local_channel == nullptr) {
+			return false;
+		}
+		if (size > Message::MaxPayloadSize) {
+			LogErr("Message of type {} is too large ({} bytes, max {})", type, size, Message::MaxPayloadSize);
+			return false;
+		}
+
+		Message message { type, static_cast<uint16_t>(size), { } };
+		if (size > 0) {
+			memcpy(message.payload, data, size);
+		}
+#ifdef GCTK_CLIENT
+		return s_local_channel->client_to_server.try_push(message);
+#else
+		return s_local_channel->server_to_client.try_push(message);
+#endif
+	}
+	bool LocalConnection::Receive(Message& message) {
+		if (s_local_channel == nullptr) {
+			return false;
+		}
+#ifdef GCTK_CLIENT
+		return s_local_channel->server_to_client.try_pop(message);
+#else
+		return s_local_channel->client_to_server.try_pop(message);
+#endif
+	}
+}
\ No newline at end of file
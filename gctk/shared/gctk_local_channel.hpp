@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gctk_ring_buffer.hpp"
+
+namespace gctk {
+	struct Message {
+		static constexpr size_t MaxPayloadSize = 120;
+
+		uint16_t type;
+		uint16_t size;
+		uint8_t payload[MaxPayloadSize];
+	};
+
+	using MessageQueue = RingBuffer<Message, 1024>;
+
+	// Owned by the singleplayer launcher, the client and server modules only keep a pointer to it
+	struct LocalChannel {
+		MessageQueue client_to_server;
+		MessageQueue server_to_client;
+	};
+
+	namespace LocalConnection {
+		void Attach(LocalChannel* channel);
+		void Detach();
+		bool IsAttached();
+
+		// Messages go to the other side of the channel, returns false when the payload is too large or the queue is full
+		bool Send(uint16_t type, const void* data, size_t size);
+		bool Receive(Message& message);
+	}
+}
\ No newline at end of file
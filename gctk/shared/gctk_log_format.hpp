@@ -0,0 +1,293 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Layout of .glog files written when log_binary is set, shared by the logger and the glog decoder tool.
+// Format strings and source locations are written once per file as a site record, messages only carry the index of their
+// site, a time delta and their packed arguments. All values are little endian.
+namespace gctk::BinaryLog {
+	static constexpr uint8_t Identifier[4] = { 'G', 'L', 'O', 'G' };
+	static constexpr uint16_t Version = 2;
+	static constexpr uint16_t FlagServer = 0x01;
+
+	struct Header {
+		uint8_t identifier[4];
+		uint16_t version;
+		uint16_t flags;
+		int64_t start_time;  // Microseconds since the Unix epoch
+	};
+	static_assert(sizeof(Header) == 16);
+
+	enum class RecordType : uint8_t {
+		// varint index, uint8 level, varint line, string file, string format
+		Site = 1,
+		// varint site index, zigzag varint microseconds since the previous message or the start time, packed arguments
+		Message = 2
+	};
+
+	// Packed arguments are a uint8 count followed by an ArgType byte and the value for each argument
+	enum class ArgType : uint8_t {
+		Int,     // zigzag varint
+		UInt,    // varint
+		Bool,    // uint8
+		Char,    // uint8
+		Float,   // 4 bytes
+		Double,  // 8 bytes
+		String,  // string
+		// string, types without a packed encoding are formatted up front with the spec of their field, the decoder
+		// writes the text as it is. Added in version 2.
+		Formatted
+	};
+
+	struct FormattedValue {
+		std::string text;
+	};
+	using Value = std::variant<int64_t, uint64_t, bool, char, float, double, std::string, FormattedValue>;
+
+	inline void WriteVarint(std::string& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+	inline bool ReadVarint(std::string_view& in, uint64_t& out) {
+		out = 0;
+		for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+			const auto byte = static_cast<uint8_t>(in.front());
+			in.remove_prefix(1);
+			out |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+	constexpr uint64_t ZigZag(const int64_t value) {
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+	constexpr int64_t UnZigZag(const uint64_t value) {
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+	inline void WriteString(std::string& out, const std::string_view str) {
+		WriteVarint(out, str.size());
+		out.append(str);
+	}
+	inline bool ReadString(std::string_view& in, std::string_view& out) {
+		uint64_t size;
+		if (!ReadVarint(in, size) || size > in.size()) {
+			return false;
+		}
+		out = in.substr(0, size);
+		in.remove_prefix(size);
+		return true;
+	}
+
+	// Spec of the first replacement field of format that refers to the argument, without the colon
+	inline std::string_view FieldSpec(const std::string_view format, const size_t arg_index) {
+		size_t next_arg = 0;
+		for (size_t i = 0; i < format.size(); i++) {
+			const char c = format[i];
+			if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+				i++;
+				continue;
+			}
+			if (c != '{') {
+				continue;
+			}
+
+			const size_t end = format.find('}', i);
+			if (end == std::string_view::npos) {
+				break;
+			}
+			const std::string_view field = format.substr(i + 1, end - i - 1);
+			const size_t colon = field.find(':');
+			const std::string_view index = field.substr(0, colon);
+			size_t arg = next_arg++;
+			if (!index.empty()) {
+				arg = 0;
+				for (const char digit : index) {
+					arg = arg * 10 + static_cast<size_t>(digit - '0');
+				}
+			}
+			if (arg == arg_index) {
+				return colon == std::string_view::npos ? std::string_view() : field.substr(colon + 1);
+			}
+			i = end;
+		}
+		return { };
+	}
+
+	template<typename T>
+	void PackArg(std::string& out, const std::string_view format, const size_t arg_index, const T& arg) {
+		using Type = std::remove_cvref_t<T>;
+		if constexpr (std::same_as<Type, bool>) {
+			out.push_back(static_cast<char>(ArgType::Bool));
+			out.push_back(static_cast<char>(arg ? 1 : 0));
+		} else if constexpr (std::same_as<Type, char>) {
+			out.push_back(static_cast<char>(ArgType::Char));
+			out.push_back(arg);
+		} else if constexpr (std::signed_integral<Type>) {
+			out.push_back(static_cast<char>(ArgType::Int));
+			WriteVarint(out, ZigZag(arg));
+		} else if constexpr (std::unsigned_integral<Type>) {
+			out.push_back(static_cast<char>(ArgType::UInt));
+			WriteVarint(out, arg);
+		} else if constexpr (std::same_as<Type, float> || std::same_as<Type, double>) {
+			out.push_back(static_cast<char>(std::same_as<Type, float> ? ArgType::Float : ArgType::Double));
+			char bytes[sizeof(Type)];
+			std::memcpy(bytes, &arg, sizeof(Type));
+			out.append(bytes, sizeof(Type));
+		} else if constexpr (std::convertible_to<const T&, std::string_view>) {
+			out.push_back(static_cast<char>(ArgType::String));
+			WriteString(out, std::string_view(arg));
+		} else {
+			out.push_back(static_cast<char>(ArgType::Formatted));
+			const std::string_view spec = FieldSpec(format, arg_index);
+			if (spec.empty()) {
+				WriteString(out, std::format("{}", arg));
+			} else {
+				WriteString(out, std::vformat(std::format("{{:{}}}", spec), std::make_format_args(arg)));
+			}
+		}
+	}
+	// format is only read for the specs of arguments that are formatted up front
+	template<typename... Args>
+	void PackArgs(std::string& out, const std::string_view format, const Args&... args) {
+		static_assert(sizeof...(Args) < 256, "Too many log arguments");
+		out.push_back(static_cast<char>(sizeof...(Args)));
+		size_t arg_index = 0;
+		(PackArg(out, format, arg_index++, args), ...);
+	}
+
+	inline bool UnpackArgs(std::string_view& in, std::vector<Value>& out) {
+		if (in.empty()) {
+			return false;
+		}
+		const auto count = static_cast<uint8_t>(in.front());
+		in.remove_prefix(1);
+		for (uint8_t i = 0; i < count; i++) {
+			if (in.empty()) {
+				return false;
+			}
+			const auto type = static_cast<ArgType>(in.front());
+			in.remove_prefix(1);
+
+			uint64_t integer;
+			std::string_view str;
+			switch (type) {
+				case ArgType::Int:
+					if (!ReadVarint(in, integer)) return false;
+					out.emplace_back(UnZigZag(integer));
+					break;
+				case ArgType::UInt:
+					if (!ReadVarint(in, integer)) return false;
+					out.emplace_back(integer);
+					break;
+				case ArgType::Bool:
+				case ArgType::Char:
+					if (in.empty()) return false;
+					if (type == ArgType::Bool) {
+						out.emplace_back(in.front() != 0);
+					} else {
+						out.emplace_back(in.front());
+					}
+					in.remove_prefix(1);
+					break;
+				case ArgType::Float: {
+					float value;
+					if (in.size() < sizeof(value)) return false;
+					std::memcpy(&value, in.data(), sizeof(value));
+					in.remove_prefix(sizeof(value));
+					out.emplace_back(value);
+					break;
+				}
+				case ArgType::Double: {
+					double value;
+					if (in.size() < sizeof(value)) return false;
+					std::memcpy(&value, in.data(), sizeof(value));
+					in.remove_prefix(sizeof(value));
+					out.emplace_back(value);
+					break;
+				}
+				case ArgType::String:
+					if (!ReadString(in, str)) return false;
+					out.emplace_back(std::string(str));
+					break;
+				case ArgType::Formatted:
+					if (!ReadString(in, str)) return false;
+					out.emplace_back(FormattedValue { std::string(str) });
+					break;
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Applies a std::format string to unpacked arguments. Fields without a matching argument, or with a spec the
+	// argument type does not accept, are copied as they are.
+	inline std::string FormatArgs(const std::string_view format, const std::vector<Value>& args) {
+		std::string out;
+		size_t next_arg = 0;
+		for (size_t i = 0; i < format.size(); i++) {
+			const char c = format[i];
+			if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+				out.push_back(c);
+				i++;
+				continue;
+			}
+			if (c != '{') {
+				out.push_back(c);
+				continue;
+			}
+
+			const size_t end = format.find('}', i);
+			if (end == std::string_view::npos) {
+				out.append(format.substr(i));
+				break;
+			}
+			const std::string_view field = format.substr(i + 1, end - i - 1);
+			const size_t colon = field.find(':');
+			const std::string_view index = field.substr(0, colon);
+			size_t arg = next_arg++;
+			if (!index.empty()) {
+				arg = 0;
+				for (const char digit : index) {
+					arg = arg * 10 + static_cast<size_t>(digit - '0');
+				}
+			}
+
+			const std::string spec = colon == std::string_view::npos ? "{}" : std::format("{{{}}}", field.substr(colon));
+			try {
+				if (arg >= args.size()) {
+					throw std::format_error("missing argument");
+				}
+				out += std::visit([&]<typename T>(const T& value) {
+					if constexpr (std::same_as<T, FormattedValue>) {
+						return value.text;
+					} else {
+						return std::vformat(spec, std::make_format_args(value));
+					}
+				}, args[arg]);
+			} catch (const std::format_error&) {
+				out.append(format.substr(i, end - i + 1));
+			}
+			i = end;
+		}
+		return out;
+	}
+	inline std::string FormatPacked(const std::string_view format, std::string_view packed) {
+		std::vector<Value> args;
+		UnpackArgs(packed, args);
+		return FormatArgs(format, args);
+	}
+}
\ No newline at end of file
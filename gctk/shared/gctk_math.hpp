@@ -3,9 +3,12 @@
 #include <chrono>
 #include <format>
 #include <cmath>
-#include <random>
+#include <span>
 #include <tuple>
 
+#include "gctk_simd.hpp"
+#include "gctk_random.hpp"
+
 namespace gctk {
 	template<typename T>
 	concept FloatType = std::is_floating_point_v<T>;
@@ -608,9 +611,9 @@ namespace gctk {
 		[[nodiscard]] constexpr std::tuple<float, float, float> items() const { return std::make_tuple(x, y, z); }
 		[[nodiscard]] constexpr Vector3 cross(const Vector3& other) const {
 			return Vector3 {
-				x * other.y - y * other.x,
 				y * other.z - z * other.y,
-				z * other.x - x * other.z
+				z * other.x - x * other.z,
+				x * other.y - y * other.x
 			};
 		}
 
@@ -945,6 +948,76 @@ namespace gctk {
 			return Quaternion { axis.x * sa, axis.y * sa, axis.z * sa, ca };
 		}
 
+		[[nodiscard]] constexpr float dot(const Quaternion& other) const { return x * other.x + y * other.y + z * other.z + w * other.w; }
+		[[nodiscard]] constexpr float length() const { return std::sqrt(dot(*this)); }
+		[[nodiscard]] constexpr Quaternion conjugate() const { return Quaternion { -x, -y, -z, w }; }
+		[[nodiscard]] constexpr Quaternion normalized() const {
+#ifdef GCTK_SIMD
+			if !consteval {
+				const Simd::Float4 q = Simd::Load(&x);
+				Quaternion result;
+				Simd::Store(&result.x, q / Simd::Sqrt(Simd::Splat(Simd::HorizontalSum(q * q))));
+				return result;
+			}
+#endif
+			const float len = length();
+			return Quaternion { x / len, y / len, z / len, w / len };
+		}
+
+		// Hamilton product, the result applies rhs first and then this rotation. operator* stays component-wise.
+		[[nodiscard]] constexpr Quaternion multiply(const Quaternion& rhs) const {
+#ifdef GCTK_SIMD
+			if !consteval {
+				const Simd::Float4 q = Simd::Load(&rhs.x);
+				Simd::Float4 r = Simd::Splat(w) * q;
+				r = Simd::MulAdd(Simd::Splat(x), Simd::Permute<3, 2, 1, 0>(q) * Simd::Set(1.0f, -1.0f, 1.0f, -1.0f), r);
+				r = Simd::MulAdd(Simd::Splat(y), Simd::Permute<2, 3, 0, 1>(q) * Simd::Set(1.0f, 1.0f, -1.0f, -1.0f), r);
+				r = Simd::MulAdd(Simd::Splat(z), Simd::Permute<1, 0, 3, 2>(q) * Simd::Set(-1.0f, 1.0f, 1.0f, -1.0f), r);
+
+				Quaternion result;
+				Simd::Store(&result.x, r);
+				return result;
+			}
+#endif
+			return Quaternion {
+				w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+				w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+				w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+				w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z
+			};
+		}
+		// Rotates v by this unit quaternion
+		[[nodiscard]] constexpr Vector3 rotate(const Vector3& v) const {
+			const Vector3 axis { x, y, z };
+			const Vector3 t = axis.cross(v) * 2.0f;
+			return v + t * w + axis.cross(t);
+		}
+
+		// Normalized linear interpolation along the shorter arc, close to Slerp for small angles and much cheaper
+		[[nodiscard]] static constexpr Quaternion Nlerp(const Quaternion& a, const Quaternion& b, const float t) {
+			const float bias = a.dot(b) < 0.0f ? -t : t;
+			return Quaternion {
+				a.x + (b.x * bias - a.x * t),
+				a.y + (b.y * bias - a.y * t),
+				a.z + (b.z * bias - a.z * t),
+				a.w + (b.w * bias - a.w * t)
+			}.normalized();
+		}
+		[[nodiscard]] static constexpr Quaternion Slerp(const Quaternion& a, const Quaternion& b, const float t) {
+			float cos_theta = a.dot(b);
+			const float sign = cos_theta < 0.0f ? -1.0f : 1.0f;
+			cos_theta *= sign;
+			if (cos_theta > 0.9995f) {
+				return Nlerp(a, b, t);
+			}
+
+			const float theta = std::acos(cos_theta);
+			const float inv_sin = 1.0f / std::sin(theta);
+			const float wa = std::sin((1.0f - t) * theta) * inv_sin;
+			const float wb = std::sin(t * theta) * inv_sin * sign;
+			return Quaternion { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+		}
+
 		static const Quaternion IDENTITY;
 
 		[[nodiscard]] constexpr Quaternion operator+ (const Quaternion& rhs) const {
@@ -1052,7 +1125,29 @@ namespace gctk {
 				column0.w, column1.w, column2.w, column3.w
 			};
 		}
+		// Row major A * B, each result row is the rows of other weighted by the lanes of the matching row
 		[[nodiscard]] constexpr Matrix4 multiply(const Matrix4& other) const {
+#ifdef GCTK_SIMD
+			if !consteval {
+				const Simd::Float4 b0 = Simd::Load(&other.column0.x);
+				const Simd::Float4 b1 = Simd::Load(&other.column1.x);
+				const Simd::Float4 b2 = Simd::Load(&other.column2.x);
+				const Simd::Float4 b3 = Simd::Load(&other.column3.x);
+				const auto row = [&](const Vector4& a, Vector4& out) {
+					const Simd::Float4 r = Simd::Load(&a.x);
+					const Simd::Float4 low = Simd::MulAdd(Simd::Permute<1, 1, 1, 1>(r), b1, Simd::Permute<0, 0, 0, 0>(r) * b0);
+					const Simd::Float4 high = Simd::MulAdd(Simd::Permute<3, 3, 3, 3>(r), b3, Simd::Permute<2, 2, 2, 2>(r) * b2);
+					Simd::Store(&out.x, low + high);
+				};
+
+				Matrix4 result { Vector4 { }, Vector4 { }, Vector4 { }, Vector4 { } };
+				row(column0, result.column0);
+				row(column1, result.column1);
+				row(column2, result.column2);
+				row(column3, result.column3);
+				return result;
+			}
+#endif
 			return Matrix4 {
 				column0.dot(other.row(0)),
 				column0.dot(other.row(1)),
@@ -1076,37 +1171,132 @@ namespace gctk {
 			};
 		}
 
-		inline float& item(const size_t idx) {
-			return column(idx / 4)[static_cast<int>(idx % 4u)];
+		// Used in inner loops, so indices are not checked, anything past the last column or component selects it
+		constexpr float& item(const size_t idx) {
+			Vector4& c = column(idx / 4);
+			switch (idx % 4) {
+				case 0: return c.x;
+				case 1: return c.y;
+				case 2: return c.z;
+				default: return c.w;
+			}
 		}
 		[[nodiscard]] constexpr float item(const size_t idx) const {
-			return column(idx / 4)[static_cast<int>(idx % 4u)];
+			const Vector4& c = column(idx / 4);
+			switch (idx % 4) {
+				case 0: return c.x;
+				case 1: return c.y;
+				case 2: return c.z;
+				default: return c.w;
+			}
 		}
 
-		inline Vector4& column(const size_t idx) {
-			if (idx == 0) return column0;
-			if (idx == 1) return column1;
-			if (idx == 2) return column2;
-			if (idx == 3) return column3;
-			throw std::out_of_range("Index out of range");
+		constexpr Vector4& column(const size_t idx) {
+			switch (idx) {
+				case 0: return column0;
+				case 1: return column1;
+				case 2: return column2;
+				default: return column3;
+			}
 		}
-		[[nodiscard]] inline Vector4 column(const size_t idx) const {
-			if (idx == 0) return column0;
-			if (idx == 1) return column1;
-			if (idx == 2) return column2;
-			if (idx == 3) return column3;
-			throw std::out_of_range("Index out of range");
+		[[nodiscard]] constexpr const Vector4& column(const size_t idx) const {
+			switch (idx) {
+				case 0: return column0;
+				case 1: return column1;
+				case 2: return column2;
+				default: return column3;
+			}
+		}
+
+		[[nodiscard]] constexpr Vector4 transform(const Vector4& v) const {
+#ifdef GCTK_SIMD
+			if !consteval {
+				const Simd::Float4 x = Simd::Load(&v.x);
+				Simd::Float4 r0 = Simd::Load(&column0.x) * x;
+				Simd::Float4 r1 = Simd::Load(&column1.x) * x;
+				Simd::Float4 r2 = Simd::Load(&column2.x) * x;
+				Simd::Float4 r3 = Simd::Load(&column3.x) * x;
+				Simd::Transpose(r0, r1, r2, r3);
+
+				Vector4 result;
+				Simd::Store(&result.x, (r0 + r1) + (r2 + r3));
+				return result;
+			}
+#endif
+			return Vector4 { column0.dot(v), column1.dot(v), column2.dot(v), column3.dot(v) };
+		}
+		[[nodiscard]] constexpr Vector3 transform_point(const Vector3& point) const {
+			const Vector4 result = transform(Vector4 { point.x, point.y, point.z, 1.0f });
+			return Vector3 { result.x, result.y, result.z };
+		}
+		[[nodiscard]] constexpr Vector3 transform_direction(const Vector3& direction) const {
+			const Vector4 result = transform(Vector4 { direction.x, direction.y, direction.z, 0.0f });
+			return Vector3 { result.x, result.y, result.z };
+		}
+
+		[[nodiscard]] constexpr float determinant() const {
+			const float s0 = column0.x * column1.y - column1.x * column0.y;
+			const float s1 = column0.x * column1.z - column1.x * column0.z;
+			const float s2 = column0.x * column1.w - column1.x * column0.w;
+			const float s3 = column0.y * column1.z - column1.y * column0.z;
+			const float s4 = column0.y * column1.w - column1.y * column0.w;
+			const float s5 = column0.z * column1.w - column1.z * column0.w;
+
+			const float t0 = column2.x * column3.y - column3.x * column2.y;
+			const float t1 = column2.x * column3.z - column3.x * column2.z;
+			const float t2 = column2.x * column3.w - column3.x * column2.w;
+			const float t3 = column2.y * column3.z - column3.y * column2.z;
+			const float t4 = column2.y * column3.w - column3.y * column2.w;
+			const float t5 = column2.z * column3.w - column3.z * column2.w;
+
+			return s0 * t5 - s1 * t4 + s2 * t3 + s3 * t2 - s4 * t1 + s5 * t0;
+		}
+		// Inverse from the 2x2 minors of the top and bottom row pairs, singular matrices give non-finite values
+		[[nodiscard]] inline Matrix4 inverse() const {
+			// After the transpose lane k of xk holds { b, a, d, c }[k] for the rows a, b, c, d
+			Simd::Float4 x0 = Simd::Load(&column1.x);
+			Simd::Float4 x1 = Simd::Load(&column0.x);
+			Simd::Float4 x2 = Simd::Load(&column3.x);
+			Simd::Float4 x3 = Simd::Load(&column2.x);
+			Simd::Transpose(x0, x1, x2, x3);
+
+			// Minor of columns i and j as { t, t, s, s }, where s comes from the rows a, b and t from c, d
+			const auto minor = [](const Simd::Float4 i, const Simd::Float4 j) {
+				const Simd::Float4 products = i * Simd::Permute<1, 0, 3, 2>(j);
+				return Simd::Permute<3, 3, 1, 1>(products - Simd::Permute<1, 0, 3, 2>(products));
+			};
+			const Simd::Float4 m01 = minor(x0, x1), m02 = minor(x0, x2), m03 = minor(x0, x3);
+			const Simd::Float4 m12 = minor(x1, x2), m13 = minor(x1, x3), m23 = minor(x2, x3);
+
+			const Simd::Float4 sign = Simd::Set(1.0f, -1.0f, 1.0f, -1.0f);
+			const Simd::Float4 r0 = (x1 * m23 - x2 * m13 + x3 * m12) * sign;
+			const Simd::Float4 r1 = (x2 * m03 - x0 * m23 - x3 * m02) * sign;
+			const Simd::Float4 r2 = (x0 * m13 - x1 * m03 + x3 * m01) * sign;
+			const Simd::Float4 r3 = (x1 * m02 - x0 * m12 - x2 * m01) * sign;
+
+			const float det = Simd::HorizontalSum(r0 * Simd::Permute<1, 0, 3, 2>(x0));
+			const Simd::Float4 inv_det = Simd::Splat(1.0f / det);
+
+			Matrix4 result { Vector4 { }, Vector4 { }, Vector4 { }, Vector4 { } };
+			Simd::Store(&result.column0.x, r0 * inv_det);
+			Simd::Store(&result.column1.x, r1 * inv_det);
+			Simd::Store(&result.column2.x, r2 * inv_det);
+			Simd::Store(&result.column3.x, r3 * inv_det);
+			return result;
 		}
 
 		constexpr Matrix4 operator* (const Matrix4& rhs) const {
 			return multiply(rhs);
 		}
+		constexpr Vector4 operator* (const Vector4& rhs) const {
+			return transform(rhs);
+		}
 
 		constexpr static Matrix4 CreateTranslation(const Vector3& position) {
 			return Matrix4 {
-				0.0f, 0.0f, 0.0f, position.x,
-				0.0f, 0.0f, 0.0f, position.y,
-				0.0f, 0.0f, 0.0f, position.z,
+				1.0f, 0.0f, 0.0f, position.x,
+				0.0f, 1.0f, 0.0f, position.y,
+				0.0f, 0.0f, 1.0f, position.z,
 				0.0f, 0.0f, 0.0f, 1.0f
 			};
 		}
@@ -1114,7 +1304,7 @@ namespace gctk {
 			return Matrix4 {
 				position.x, 0.0f, 0.0f, 0.0f,
 				0.0f, position.y, 0.0f, 0.0f,
-				0.0f, 0.0f, 0.0f, position.z,
+				0.0f, 0.0f, position.z, 0.0f,
 				0.0f, 0.0f, 0.0f, 1.0f
 			};
 		}
@@ -1170,7 +1360,7 @@ namespace gctk {
 			result.column1.z = s2 * (yz - xw);
 
 			result.column2.x = s2 * (xz - yw);
-			result.column2.y = s2 * (yz + yw);
+			result.column2.y = s2 * (yz + xw);
 			result.column2.z = 1.0f - s2 * (xx + yy);
 
 			return result;
@@ -1352,20 +1542,30 @@ namespace gctk {
 	};
 
 	class Random {
-		std::mt19937 m_engine;
+		Xoshiro256 m_engine;
+
+		explicit Random(const Xoshiro256& engine) : m_engine(engine) { }
 	public:
 		explicit Random(const size_t seed) : m_engine(seed) { }
 		Random() : Random(std::chrono::high_resolution_clock::now().time_since_epoch().count()) { }
 
+		[[nodiscard]] inline uint64_t next_bits() { return m_engine.next(); }
 		template<IntegerType T>
 		[[nodiscard]] inline T next_int(const T min, const T max) {
-			std::uniform_int_distribution<T> dist(min, max);
-			return dist(m_engine);
+			using U = std::make_unsigned_t<T>;
+			const auto range = static_cast<uint64_t>(static_cast<U>(static_cast<U>(max) - static_cast<U>(min)));
+			if (range == std::numeric_limits<uint64_t>::max()) {
+				return static_cast<T>(m_engine.next());
+			}
+			return static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(RandomBits::Bounded(m_engine, range + 1))));
 		}
 		template<FloatType T>
 		[[nodiscard]] inline T next_float(const T min, const T max) {
-			std::uniform_real_distribution<T> dist(min, max);
-			return dist(m_engine);
+			if constexpr (sizeof(T) <= sizeof(float)) {
+				return min + (max - min) * static_cast<T>(RandomBits::ToFloat(m_engine.next()));
+			} else {
+				return min + (max - min) * static_cast<T>(RandomBits::ToDouble(m_engine.next()));
+			}
 		}
 		[[nodiscard]] inline Vector2 next_vector2(const Vector2& min, const Vector2& max) {
 			return Vector2 {
@@ -1403,8 +1603,21 @@ namespace gctk {
 				r * Math::Cos(a)
 			};
 		}
+
+		// Bulk generation, floats are produced four at a time from a SIMD generator seeded by this one
+		void fill_floats(std::span<float> out, float min = 0.0f, float max = 1.0f);
+		void fill_ints(std::span<int32_t> out, int32_t min, int32_t max);
+		void fill_in_circle(std::span<Vector2> out, float r_min, float r_max);
+		void fill_in_sphere(std::span<Vector3> out, float r_min, float r_max);
+
 		inline void seed() { seed(std::chrono::high_resolution_clock::now().time_since_epoch().count()); }
 		inline void seed(const size_t seed) { m_engine.seed(seed); }
+
+		// Use split() to hand each thread its own generator, the sequences are 2^128 values apart
+		inline void jump() { m_engine.jump(); }
+		[[nodiscard]] inline Random split() { return Random(m_engine.split()); }
+		// For use with the standard distributions
+		[[nodiscard]] inline Xoshiro256& engine() { return m_engine; }
 	};
 }
 
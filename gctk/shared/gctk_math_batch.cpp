@@ -0,0 +1,301 @@
+#include "gctk_math_batch.hpp"
+
+#include <algorithm>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_jobs.hpp"
+#include "gctk_simd.hpp"
+#include "gctk_str.hpp"
+
+namespace gctk {
+	static bool ValidatePositiveOrZero(const CVar*, const std::string& value) {
+		int32_t number;
+		return StringUtil::ParseInt(value, number) && number >= 0;
+	}
+
+	CVar math_parallel_batch("math_parallel_batch", "65536", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+
+	// Streams shorter than this never read the CVar or touch the job system
+	static constexpr size_t MinParallelCount = 8192;
+
+	static size_t Stride(const size_t size) {
+		return (size + 3) & ~static_cast<size_t>(3);
+	}
+
+	void Vector3Array::resize(const size_t size) {
+		const size_t stride = Stride(size);
+		std::vector<float> data(stride * 3, 0.0f);
+		for (size_t c = 0; c < 3; c++) {
+			std::copy_n(m_data.begin() + c * m_uStride, std::min(m_uSize, size), data.begin() + c * stride);
+		}
+		m_data = std::move(data);
+		m_uSize = size;
+		m_uStride = stride;
+	}
+	Vector3Stream Vector3Array::stream() {
+		return Vector3Stream { { m_data.data(), m_uSize }, { m_data.data() + m_uStride, m_uSize }, { m_data.data() + m_uStride * 2, m_uSize } };
+	}
+	ConstVector3Stream Vector3Array::stream() const {
+		return ConstVector3Stream { { m_data.data(), m_uSize }, { m_data.data() + m_uStride, m_uSize }, { m_data.data() + m_uStride * 2, m_uSize } };
+	}
+
+	void QuaternionArray::resize(const size_t size) {
+		const size_t stride = Stride(size);
+		std::vector<float> data(stride * 4, 0.0f);
+		for (size_t c = 0; c < 4; c++) {
+			std::copy_n(m_data.begin() + c * m_uStride, std::min(m_uSize, size), data.begin() + c * stride);
+		}
+		// New elements start as the identity rotation
+		std::fill(data.begin() + stride * 3 + std::min(m_uSize, size), data.end(), 1.0f);
+		m_data = std::move(data);
+		m_uSize = size;
+		m_uStride = stride;
+	}
+	QuaternionStream QuaternionArray::stream() {
+		return QuaternionStream {
+			{ m_data.data(), m_uSize }, { m_data.data() + m_uStride, m_uSize },
+			{ m_data.data() + m_uStride * 2, m_uSize }, { m_data.data() + m_uStride * 3, m_uSize }
+		};
+	}
+	ConstQuaternionStream QuaternionArray::stream() const {
+		return ConstQuaternionStream {
+			{ m_data.data(), m_uSize }, { m_data.data() + m_uStride, m_uSize },
+			{ m_data.data() + m_uStride * 2, m_uSize }, { m_data.data() + m_uStride * 3, m_uSize }
+		};
+	}
+
+	// Runs fn(begin, end) over the whole range, split into jobs when the stream is long enough
+	template<typename Fn>
+	static void ParallelFor(const size_t count, Fn&& fn) {
+		if (count < MinParallelCount) {
+			fn(0, count);
+			return;
+		}
+		Jobs::ParallelFor(count, std::max<size_t>(math_parallel_batch.get_integer(), MinParallelCount), fn);
+	}
+
+	static void TransformStream(const Matrix4& matrix, const ConstVector3Stream in, const Vector3Stream out, const float w) {
+		Assert(in.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(in.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 m00 = Simd::Splat(matrix.column0.x), m01 = Simd::Splat(matrix.column0.y);
+			const Simd::Float4 m02 = Simd::Splat(matrix.column0.z), m03 = Simd::Splat(matrix.column0.w * w);
+			const Simd::Float4 m10 = Simd::Splat(matrix.column1.x), m11 = Simd::Splat(matrix.column1.y);
+			const Simd::Float4 m12 = Simd::Splat(matrix.column1.z), m13 = Simd::Splat(matrix.column1.w * w);
+			const Simd::Float4 m20 = Simd::Splat(matrix.column2.x), m21 = Simd::Splat(matrix.column2.y);
+			const Simd::Float4 m22 = Simd::Splat(matrix.column2.z), m23 = Simd::Splat(matrix.column2.w * w);
+
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 x = Simd::Load(&in.x[i]);
+				const Simd::Float4 y = Simd::Load(&in.y[i]);
+				const Simd::Float4 z = Simd::Load(&in.z[i]);
+				Simd::Store(&out.x[i], Simd::MulAdd(m00, x, Simd::MulAdd(m01, y, Simd::MulAdd(m02, z, m03))));
+				Simd::Store(&out.y[i], Simd::MulAdd(m10, x, Simd::MulAdd(m11, y, Simd::MulAdd(m12, z, m13))));
+				Simd::Store(&out.z[i], Simd::MulAdd(m20, x, Simd::MulAdd(m21, y, Simd::MulAdd(m22, z, m23))));
+			}
+			for (; i < end; i++) {
+				const Vector4 result = matrix.transform(Vector4 { in.x[i], in.y[i], in.z[i], w });
+				out.x[i] = result.x;
+				out.y[i] = result.y;
+				out.z[i] = result.z;
+			}
+		});
+	}
+
+	void MathBatch::TransformPoints(const Matrix4& matrix, const ConstVector3Stream points, const Vector3Stream out) {
+		TransformStream(matrix, points, out, 1.0f);
+	}
+	void MathBatch::TransformDirections(const Matrix4& matrix, const ConstVector3Stream directions, const Vector3Stream out) {
+		TransformStream(matrix, directions, out, 0.0f);
+	}
+
+	void MathBatch::Normalize(const ConstVector3Stream vectors, const Vector3Stream out) {
+		Assert(vectors.size() == out.size(), "Input and output streams must have the same length");
+
+		// Zero length vectors stay zero instead of turning into NaN
+		static constexpr float MinLength = 1e-30f;
+		ParallelFor(vectors.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 one = Simd::Splat(1.0f), min_length = Simd::Splat(MinLength);
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 x = Simd::Load(&vectors.x[i]);
+				const Simd::Float4 y = Simd::Load(&vectors.y[i]);
+				const Simd::Float4 z = Simd::Load(&vectors.z[i]);
+				const Simd::Float4 inv_length = one / Simd::Max(Simd::Sqrt(x * x + y * y + z * z), min_length);
+				Simd::Store(&out.x[i], x * inv_length);
+				Simd::Store(&out.y[i], y * inv_length);
+				Simd::Store(&out.z[i], z * inv_length);
+			}
+			for (; i < end; i++) {
+				const float x = vectors.x[i], y = vectors.y[i], z = vectors.z[i];
+				const float inv_length = 1.0f / std::max(std::sqrt(x * x + y * y + z * z), MinLength);
+				out.x[i] = x * inv_length;
+				out.y[i] = y * inv_length;
+				out.z[i] = z * inv_length;
+			}
+		});
+	}
+
+	void MathBatch::MultiplyAdd(const ConstVector3Stream a, const ConstVector3Stream b, const float scale, const Vector3Stream out) {
+		Assert(a.size() == b.size() && a.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(a.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 s = Simd::Splat(scale);
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				Simd::Store(&out.x[i], Simd::MulAdd(Simd::Load(&b.x[i]), s, Simd::Load(&a.x[i])));
+				Simd::Store(&out.y[i], Simd::MulAdd(Simd::Load(&b.y[i]), s, Simd::Load(&a.y[i])));
+				Simd::Store(&out.z[i], Simd::MulAdd(Simd::Load(&b.z[i]), s, Simd::Load(&a.z[i])));
+			}
+			for (; i < end; i++) {
+				out.x[i] = a.x[i] + b.x[i] * scale;
+				out.y[i] = a.y[i] + b.y[i] * scale;
+				out.z[i] = a.z[i] + b.z[i] * scale;
+			}
+		});
+	}
+
+	void MathBatch::Lerp(const ConstVector3Stream a, const ConstVector3Stream b, const float t, const Vector3Stream out) {
+		Assert(a.size() == b.size() && a.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(a.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 weight = Simd::Splat(t);
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 ax = Simd::Load(&a.x[i]), ay = Simd::Load(&a.y[i]), az = Simd::Load(&a.z[i]);
+				Simd::Store(&out.x[i], Simd::MulAdd(Simd::Load(&b.x[i]) - ax, weight, ax));
+				Simd::Store(&out.y[i], Simd::MulAdd(Simd::Load(&b.y[i]) - ay, weight, ay));
+				Simd::Store(&out.z[i], Simd::MulAdd(Simd::Load(&b.z[i]) - az, weight, az));
+			}
+			for (; i < end; i++) {
+				out.x[i] = a.x[i] + (b.x[i] - a.x[i]) * t;
+				out.y[i] = a.y[i] + (b.y[i] - a.y[i]) * t;
+				out.z[i] = a.z[i] + (b.z[i] - a.z[i]) * t;
+			}
+		});
+	}
+
+	void MathBatch::Distances(const ConstVector3Stream a, const ConstVector3Stream b, const std::span<float> out) {
+		Assert(a.size() == b.size() && a.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(a.size(), [&](const size_t begin, const size_t end) {
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 dx = Simd::Load(&b.x[i]) - Simd::Load(&a.x[i]);
+				const Simd::Float4 dy = Simd::Load(&b.y[i]) - Simd::Load(&a.y[i]);
+				const Simd::Float4 dz = Simd::Load(&b.z[i]) - Simd::Load(&a.z[i]);
+				Simd::Store(&out[i], Simd::Sqrt(dx * dx + dy * dy + dz * dz));
+			}
+			for (; i < end; i++) {
+				const float dx = b.x[i] - a.x[i], dy = b.y[i] - a.y[i], dz = b.z[i] - a.z[i];
+				out[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+		});
+	}
+	void MathBatch::Distances(const ConstVector3Stream points, const Vector3& point, const std::span<float> out) {
+		Assert(points.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(points.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 px = Simd::Splat(point.x), py = Simd::Splat(point.y), pz = Simd::Splat(point.z);
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 dx = Simd::Load(&points.x[i]) - px;
+				const Simd::Float4 dy = Simd::Load(&points.y[i]) - py;
+				const Simd::Float4 dz = Simd::Load(&points.z[i]) - pz;
+				Simd::Store(&out[i], Simd::Sqrt(dx * dx + dy * dy + dz * dz));
+			}
+			for (; i < end; i++) {
+				const float dx = points.x[i] - point.x, dy = points.y[i] - point.y, dz = points.z[i] - point.z;
+				out[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+		});
+	}
+
+	void MathBatch::Nlerp(const ConstQuaternionStream a, const ConstQuaternionStream b, const float t, const QuaternionStream out) {
+		Assert(a.size() == b.size() && a.size() == out.size(), "Input and output streams must have the same length");
+
+		ParallelFor(a.size(), [&](const size_t begin, const size_t end) {
+			const Simd::Float4 weight = Simd::Splat(t);
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 ax = Simd::Load(&a.x[i]), bx = Simd::Load(&b.x[i]);
+				const Simd::Float4 ay = Simd::Load(&a.y[i]), by = Simd::Load(&b.y[i]);
+				const Simd::Float4 az = Simd::Load(&a.z[i]), bz = Simd::Load(&b.z[i]);
+				const Simd::Float4 aw = Simd::Load(&a.w[i]), bw = Simd::Load(&b.w[i]);
+
+				// Take the shortest arc by flipping b into the same hemisphere as a
+				const Simd::Float4 dot = ax * bx + ay * by + az * bz + aw * bw;
+				const Simd::Float4 rx = Simd::MulAdd(Simd::FlipSign(bx, dot) - ax, weight, ax);
+				const Simd::Float4 ry = Simd::MulAdd(Simd::FlipSign(by, dot) - ay, weight, ay);
+				const Simd::Float4 rz = Simd::MulAdd(Simd::FlipSign(bz, dot) - az, weight, az);
+				const Simd::Float4 rw = Simd::MulAdd(Simd::FlipSign(bw, dot) - aw, weight, aw);
+				const Simd::Float4 length = Simd::Sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+				Simd::Store(&out.x[i], rx / length);
+				Simd::Store(&out.y[i], ry / length);
+				Simd::Store(&out.z[i], rz / length);
+				Simd::Store(&out.w[i], rw / length);
+			}
+			for (; i < end; i++) {
+				const Quaternion q = Quaternion::Nlerp({ a.x[i], a.y[i], a.z[i], a.w[i] }, { b.x[i], b.y[i], b.z[i], b.w[i] }, t);
+				out.x[i] = q.x;
+				out.y[i] = q.y;
+				out.z[i] = q.z;
+				out.w[i] = q.w;
+			}
+		});
+	}
+
+	void MathBatch::Slerp(const ConstQuaternionStream a, const ConstQuaternionStream b, const float t, const QuaternionStream out) {
+		Assert(a.size() == b.size() && a.size() == out.size(), "Input and output streams must have the same length");
+
+		// Past this cosine the angle is too small for sin(theta) to be divided by, the lanes fall back to Nlerp
+		static constexpr float LinearThreshold = 0.9995f;
+		ParallelFor(a.size(), [&](const size_t begin, const size_t end) {
+			alignas(16) float dots[4], weight_a[4], weight_b[4];
+			size_t i = begin;
+			for (; i + 4 <= end; i += 4) {
+				const Simd::Float4 ax = Simd::Load(&a.x[i]), bx = Simd::Load(&b.x[i]);
+				const Simd::Float4 ay = Simd::Load(&a.y[i]), by = Simd::Load(&b.y[i]);
+				const Simd::Float4 az = Simd::Load(&a.z[i]), bz = Simd::Load(&b.z[i]);
+				const Simd::Float4 aw = Simd::Load(&a.w[i]), bw = Simd::Load(&b.w[i]);
+				Simd::Store(dots, ax * bx + ay * by + az * bz + aw * bw);
+
+				// There is no vector sin/acos, so only the per lane weights are scalar
+				for (int lane = 0; lane < 4; lane++) {
+					const float sign = dots[lane] < 0.0f ? -1.0f : 1.0f;
+					const float cos_theta = dots[lane] * sign;
+					if (cos_theta > LinearThreshold) {
+						weight_a[lane] = 1.0f - t;
+						weight_b[lane] = t * sign;
+						continue;
+					}
+					const float theta = std::acos(cos_theta);
+					const float inv_sin = 1.0f / std::sin(theta);
+					weight_a[lane] = std::sin((1.0f - t) * theta) * inv_sin;
+					weight_b[lane] = std::sin(t * theta) * inv_sin * sign;
+				}
+
+				const Simd::Float4 wa = Simd::Load(weight_a), wb = Simd::Load(weight_b);
+				const Simd::Float4 rx = Simd::MulAdd(ax, wa, bx * wb);
+				const Simd::Float4 ry = Simd::MulAdd(ay, wa, by * wb);
+				const Simd::Float4 rz = Simd::MulAdd(az, wa, bz * wb);
+				const Simd::Float4 rw = Simd::MulAdd(aw, wa, bw * wb);
+				// Only changes the Nlerp lanes, slerped lanes already have unit length
+				const Simd::Float4 length = Simd::Sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+				Simd::Store(&out.x[i], rx / length);
+				Simd::Store(&out.y[i], ry / length);
+				Simd::Store(&out.z[i], rz / length);
+				Simd::Store(&out.w[i], rw / length);
+			}
+			for (; i < end; i++) {
+				const Quaternion q = Quaternion::Slerp({ a.x[i], a.y[i], a.z[i], a.w[i] }, { b.x[i], b.y[i], b.z[i], b.w[i] }, t);
+				out.x[i] = q.x;
+				out.y[i] = q.y;
+				out.z[i] = q.z;
+				out.w[i] = q.w;
+			}
+		});
+	}
+}
\ No newline at end of file
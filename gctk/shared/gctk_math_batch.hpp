@@ -0,0 +1,107 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "gctk_math.hpp"
+
+namespace gctk {
+	// Structure of arrays views, every component span has the same length
+	struct Vector3Stream {
+		std::span<float> x, y, z;
+
+		[[nodiscard]] constexpr size_t size() const { return x.size(); }
+	};
+	struct ConstVector3Stream {
+		std::span<const float> x, y, z;
+
+		constexpr ConstVector3Stream(const std::span<const float> x, const std::span<const float> y, const std::span<const float> z) :
+			x(x), y(y), z(z) { }
+		constexpr ConstVector3Stream(const Vector3Stream& stream) : x(stream.x), y(stream.y), z(stream.z) { } // NOLINT: Implicit conversion intended
+
+		[[nodiscard]] constexpr size_t size() const { return x.size(); }
+	};
+
+	struct QuaternionStream {
+		std::span<float> x, y, z, w;
+
+		[[nodiscard]] constexpr size_t size() const { return x.size(); }
+	};
+	struct ConstQuaternionStream {
+		std::span<const float> x, y, z, w;
+
+		constexpr ConstQuaternionStream(
+			const std::span<const float> x, const std::span<const float> y, const std::span<const float> z, const std::span<const float> w
+		) : x(x), y(y), z(z), w(w) { }
+		constexpr ConstQuaternionStream(const QuaternionStream& stream) : x(stream.x), y(stream.y), z(stream.z), w(stream.w) { } // NOLINT: Implicit conversion intended
+
+		[[nodiscard]] constexpr size_t size() const { return x.size(); }
+	};
+
+	// Owns the components of N vectors in one allocation, each component starts at a multiple of 4 floats
+	class Vector3Array {
+		std::vector<float> m_data;
+		size_t m_uSize;
+		size_t m_uStride;
+	public:
+		Vector3Array() : m_uSize(0), m_uStride(0) { }
+		explicit Vector3Array(const size_t size) : Vector3Array() { resize(size); }
+
+		void resize(size_t size);
+
+		[[nodiscard]] constexpr size_t size() const { return m_uSize; }
+		[[nodiscard]] inline Vector3 get(const size_t i) const {
+			return Vector3 { m_data[i], m_data[m_uStride + i], m_data[m_uStride * 2 + i] };
+		}
+		inline void set(const size_t i, const Vector3& value) {
+			m_data[i] = value.x;
+			m_data[m_uStride + i] = value.y;
+			m_data[m_uStride * 2 + i] = value.z;
+		}
+
+		[[nodiscard]] Vector3Stream stream();
+		[[nodiscard]] ConstVector3Stream stream() const;
+	};
+
+	class QuaternionArray {
+		std::vector<float> m_data;
+		size_t m_uSize;
+		size_t m_uStride;
+	public:
+		QuaternionArray() : m_uSize(0), m_uStride(0) { }
+		explicit QuaternionArray(const size_t size) : QuaternionArray() { resize(size); }
+
+		void resize(size_t size);
+
+		[[nodiscard]] constexpr size_t size() const { return m_uSize; }
+		[[nodiscard]] inline Quaternion get(const size_t i) const {
+			return Quaternion { m_data[i], m_data[m_uStride + i], m_data[m_uStride * 2 + i], m_data[m_uStride * 3 + i] };
+		}
+		inline void set(const size_t i, const Quaternion& value) {
+			m_data[i] = value.x;
+			m_data[m_uStride + i] = value.y;
+			m_data[m_uStride * 2 + i] = value.z;
+			m_data[m_uStride * 3 + i] = value.w;
+		}
+
+		[[nodiscard]] QuaternionStream stream();
+		[[nodiscard]] ConstQuaternionStream stream() const;
+	};
+
+	// Kernels over whole streams, 4 elements per SIMD step. Inputs and outputs may be the same stream.
+	// Long streams are split into jobs, each taking at least math_parallel_batch elements.
+	namespace MathBatch {
+		void TransformPoints(const Matrix4& matrix, ConstVector3Stream points, Vector3Stream out);
+		void TransformDirections(const Matrix4& matrix, ConstVector3Stream directions, Vector3Stream out);
+		void Normalize(ConstVector3Stream vectors, Vector3Stream out);
+		// out = a + b * scale, e.g. integrating positions from velocities
+		void MultiplyAdd(ConstVector3Stream a, ConstVector3Stream b, float scale, Vector3Stream out);
+		void Lerp(ConstVector3Stream a, ConstVector3Stream b, float t, Vector3Stream out);
+		void Distances(ConstVector3Stream a, ConstVector3Stream b, std::span<float> out);
+		void Distances(ConstVector3Stream points, const Vector3& point, std::span<float> out);
+
+		// Both interpolate along the shortest arc, Nlerp is much cheaper and close to Slerp for small angles
+		void Nlerp(ConstQuaternionStream a, ConstQuaternionStream b, float t, QuaternionStream out);
+		void Slerp(ConstQuaternionStream a, ConstQuaternionStream b, float t, QuaternionStream out);
+	}
+}
\ No newline at end of file
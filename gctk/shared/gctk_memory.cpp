@@ -0,0 +1,215 @@
+#include "gctk_memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_time.hpp"
+
+#ifdef GCTK_COUNT_ALLOCATIONS
+// Constant initialized, operator new can run before any dynamic initializer
+static std::atomic<uint64_t> s_heap_allocations = 0;
+static std::atomic<uint64_t> s_heap_bytes = 0;
+
+static void* CountedAlloc(const std::size_t size) {
+	s_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+static void* CountedAlignedAlloc(const std::size_t size, const std::align_val_t alignment) {
+	s_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef _WIN32
+	return _aligned_malloc(size == 0 ? 1 : size, static_cast<std::size_t>(alignment));
+#else
+	const auto align = static_cast<std::size_t>(alignment);
+	return std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) & ~(align - 1));
+#endif
+}
+static void AlignedFree(void* p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void* operator new(const std::size_t size) {
+	if (void* p = CountedAlloc(size); p != nullptr) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+void* operator new[](const std::size_t size) {
+	return operator new(size);
+}
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+	return CountedAlloc(size);
+}
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+	return CountedAlloc(size);
+}
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+	if (void* p = CountedAlignedAlloc(size, alignment); p != nullptr) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+#endif
+
+namespace gctk {
+	CVar mem_stats("mem_stats", "false", CVAR_DEFAULT_FLAGS);
+
+	struct ThreadScratch {
+		LinearArena arena;
+		uint64_t frame = 0;
+		uint32_t scopes = 0;
+	};
+
+	static std::atomic<uint64_t> s_arena_blocks = 0;
+	static std::atomic<uint64_t> s_frame_index = 0;
+	static std::array<LinearArena, 2> s_frame_arenas;
+
+	// A plain pointer stays usable after the thread's destructors ran, e.g. when a static destructor logs at exit.
+	// The scratch arena created then is never freed.
+	static thread_local ThreadScratch* s_scratch = nullptr;
+	static thread_local struct ScratchOwner {
+		~ScratchOwner() {
+			delete s_scratch;
+			s_scratch = nullptr;
+		}
+	} s_scratch_owner;
+
+	static ThreadScratch& GetThreadScratch() {
+		if (s_scratch == nullptr) {
+			static_cast<void>(&s_scratch_owner);
+			s_scratch = new ThreadScratch();
+		}
+		return *s_scratch;
+	}
+	static MemoryStats s_frame_start = { };
+	static MemoryStats s_last_stats = { };
+
+	LinearArena::LinearArena(const size_t block_size) : m_uBlock(0), m_uOffset(0), m_uBlockSize(block_size), m_uUsed(0), m_uPeak(0) { }
+	LinearArena::~LinearArena() {
+		for (const auto& block : m_blocks) {
+			::operator delete(block.data);
+		}
+	}
+
+	void LinearArena::rewind(const Marker& marker) {
+		// A marker from before a reset would point past the current position
+		if (marker.block < m_uBlock || (marker.block == m_uBlock && marker.offset <= m_uOffset)) {
+			m_uBlock = marker.block;
+			m_uOffset = marker.offset;
+			m_uUsed = marker.used;
+		}
+	}
+	void LinearArena::reset() {
+		m_uBlock = 0;
+		m_uOffset = 0;
+		m_uUsed = 0;
+	}
+
+	size_t LinearArena::capacity() const {
+		size_t size = 0;
+		for (const auto& block : m_blocks) {
+			size += block.size;
+		}
+		return size;
+	}
+
+	void* LinearArena::do_allocate(const size_t bytes, const size_t alignment) {
+		while (m_uBlock < m_blocks.size()) {
+			const Block& block = m_blocks[m_uBlock];
+			const auto base = reinterpret_cast<uintptr_t>(block.data);
+			const size_t offset = ((base + m_uOffset + alignment - 1) & ~(alignment - 1)) - base;
+			if (offset + bytes <= block.size) {
+				m_uUsed += offset + bytes - m_uOffset;
+				m_uPeak = std::max(m_uPeak, m_uUsed);
+				m_uOffset = offset + bytes;
+				return block.data + offset;
+			}
+			// The rest of the block stays unused until the next reset
+			m_uBlock++;
+			m_uOffset = 0;
+		}
+
+		const size_t size = std::max(m_uBlockSize, bytes + alignment);
+		m_blocks.push_back(Block { static_cast<std::byte*>(::operator new(size)), size });
+		s_arena_blocks.fetch_add(1, std::memory_order_relaxed);
+		m_uBlock = m_blocks.size() - 1;
+		m_uOffset = 0;
+		return do_allocate(bytes, alignment);
+	}
+
+	ScratchScope::ScratchScope() : m_arena(Memory::ScratchArena()), m_marker(m_arena.marker()) {
+		GetThreadScratch().scopes++;
+	}
+	ScratchScope::~ScratchScope() {
+		m_arena.rewind(m_marker);
+		GetThreadScratch().scopes--;
+	}
+
+	LinearArena& Memory::FrameArena() {
+		return s_frame_arenas[s_frame_index.load(std::memory_order_relaxed) & 1];
+	}
+	LinearArena& Memory::ScratchArena() {
+		ThreadScratch& scratch = GetThreadScratch();
+		if (const uint64_t frame = s_frame_index.load(std::memory_order_relaxed); scratch.frame != frame && scratch.scopes == 0) {
+			scratch.arena.reset();
+			scratch.frame = frame;
+		}
+		return scratch.arena;
+	}
+
+	void Memory::BeginFrame() {
+		MemoryStats now = { };
+#ifdef GCTK_COUNT_ALLOCATIONS
+		now.heap_allocations = s_heap_allocations.load(std::memory_order_relaxed);
+		now.heap_bytes = s_heap_bytes.load(std::memory_order_relaxed);
+#endif
+		now.arena_blocks = s_arena_blocks.load(std::memory_order_relaxed);
+		s_last_stats = MemoryStats {
+			now.heap_allocations - s_frame_start.heap_allocations,
+			now.heap_bytes - s_frame_start.heap_bytes,
+			now.arena_blocks - s_frame_start.arena_blocks,
+			FrameArena().used()
+		};
+		s_frame_start = now;
+
+		const uint64_t frame = s_frame_index.fetch_add(1, std::memory_order_relaxed) + 1;
+		s_frame_arenas[frame & 1].reset();
+
+		if (mem_stats.get_boolean()) {
+			static double last_report = 0.0;
+			if (const auto time = Time::CurrentTime(); time - last_report >= 1.0) {
+				LogInfo("Frame memory: {} heap allocations ({} bytes), {} new arena blocks, {} frame arena bytes",
+					s_last_stats.heap_allocations, s_last_stats.heap_bytes, s_last_stats.arena_blocks, s_last_stats.frame_bytes);
+				last_report = time;
+			}
+		}
+	}
+	uint64_t Memory::FrameIndex() {
+		return s_frame_index.load(std::memory_order_relaxed);
+	}
+	MemoryStats Memory::LastFrameStats() {
+		return s_last_stats;
+	}
+}
\ No newline at end of file
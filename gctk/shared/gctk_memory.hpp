@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace gctk {
+	struct MemoryStats {
+		// Only counted when built with GCTK_COUNT_ALLOCATIONS
+		uint64_t heap_allocations;
+		uint64_t heap_bytes;
+		// Blocks the arenas had to allocate, zero once they reached their steady-state size
+		uint64_t arena_blocks;
+		size_t frame_bytes;
+	};
+
+	// Bump allocator over a list of blocks. Deallocation does nothing, memory comes back with rewind() or reset().
+	// The blocks are kept on reset, so an arena that reached its peak size stops touching the heap.
+	class LinearArena final : public std::pmr::memory_resource {
+		struct Block {
+			std::byte* data;
+			size_t size;
+		};
+
+		std::vector<Block> m_blocks;
+		size_t m_uBlock;
+		size_t m_uOffset;
+		size_t m_uBlockSize;
+		size_t m_uUsed;
+		size_t m_uPeak;
+	public:
+		struct Marker {
+			size_t block;
+			size_t offset;
+			size_t used;
+		};
+
+		explicit LinearArena(size_t block_size = 64 * 1024);
+		~LinearArena() override;
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		[[nodiscard]] inline Marker marker() const { return Marker { m_uBlock, m_uOffset, m_uUsed }; }
+		// Releases everything allocated after the marker was taken
+		void rewind(const Marker& marker);
+		void reset();
+
+		[[nodiscard]] inline size_t used() const { return m_uUsed; }
+		[[nodiscard]] inline size_t peak() const { return m_uPeak; }
+		[[nodiscard]] size_t capacity() const;
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override { }
+		[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	// Scratch allocations of the calling thread made inside the scope are released when it ends
+	class ScratchScope {
+		LinearArena& m_arena;
+		LinearArena::Marker m_marker;
+	public:
+		ScratchScope();
+		~ScratchScope();
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+		[[nodiscard]] inline LinearArena* resource() const { return &m_arena; }
+	};
+
+	namespace Memory {
+		// Released two BeginFrame calls later, so the render thread can still read a frame while the next one is recorded.
+		// Only for the thread calling BeginFrame.
+		LinearArena& FrameArena();
+		// Per-thread arena, reset on its first use in a new frame unless a ScratchScope is open on the thread.
+		// Nothing allocated from it may be kept past the end of the frame.
+		LinearArena& ScratchArena();
+
+		// Called by the client once per rendered frame and by the server once per tick, see Server::BeginTick
+		void BeginFrame();
+		[[nodiscard]] uint64_t FrameIndex();
+		// Counters of the frame closed by the last BeginFrame call
+		[[nodiscard]] MemoryStats LastFrameStats();
+	}
+}
\ No newline at end of file
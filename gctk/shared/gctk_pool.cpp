@@ -0,0 +1,54 @@
+#include "gctk_pool.hpp"
+
+#include <algorithm>
+
+namespace gctk {
+	FixedBlockPool::FixedBlockPool(const size_t block_size, const size_t alignment, const size_t blocks_per_page) :
+		m_uBlockSize(0), m_uAlignment(std::max(alignment, alignof(void*))), m_uBlocksPerPage(std::max<size_t>(blocks_per_page, 1)),
+		m_pFreeList(nullptr), m_uUsed(0) {
+		// Free blocks store the next free block in their first bytes
+		const size_t size = std::max(block_size, sizeof(void*));
+		m_uBlockSize = (size + m_uAlignment - 1) & ~(m_uAlignment - 1);
+	}
+	FixedBlockPool::~FixedBlockPool() {
+		for (void* page : m_pages) {
+			::operator delete(page, std::align_val_t(m_uAlignment));
+		}
+	}
+
+	void* FixedBlockPool::allocate() {
+		std::lock_guard lock(m_mutex);
+		if (m_pFreeList == nullptr) {
+			auto* page = static_cast<std::byte*>(::operator new(m_uBlockSize * m_uBlocksPerPage, std::align_val_t(m_uAlignment)));
+			m_pages.push_back(page);
+			for (size_t i = m_uBlocksPerPage; i > 0; i--) {
+				void* block = page + (i - 1) * m_uBlockSize;
+				*static_cast<void**>(block) = m_pFreeList;
+				m_pFreeList = block;
+			}
+		}
+
+		void* block = m_pFreeList;
+		m_pFreeList = *static_cast<void**>(block);
+		m_uUsed++;
+		return block;
+	}
+	void FixedBlockPool::deallocate(void* p) {
+		if (p == nullptr) {
+			return;
+		}
+		std::lock_guard lock(m_mutex);
+		*static_cast<void**>(p) = m_pFreeList;
+		m_pFreeList = p;
+		m_uUsed--;
+	}
+
+	size_t FixedBlockPool::used() {
+		std::lock_guard lock(m_mutex);
+		return m_uUsed;
+	}
+	size_t FixedBlockPool::capacity() {
+		std::lock_guard lock(m_mutex);
+		return m_pages.size() * m_uBlocksPerPage;
+	}
+}
\ No newline at end of file
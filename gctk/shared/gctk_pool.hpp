@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace gctk {
+	// Slab of equally sized blocks with a free list. Pages are never released, so blocks keep their address. Thread safe.
+	class FixedBlockPool {
+		size_t m_uBlockSize;
+		size_t m_uAlignment;
+		size_t m_uBlocksPerPage;
+		std::vector<void*> m_pages;
+		void* m_pFreeList;
+		size_t m_uUsed;
+		std::mutex m_mutex;
+	public:
+		FixedBlockPool(size_t block_size, size_t alignment, size_t blocks_per_page = 64);
+		~FixedBlockPool();
+		FixedBlockPool(const FixedBlockPool&) = delete;
+		FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+		[[nodiscard]] void* allocate();
+		void deallocate(void* p);
+
+		[[nodiscard]] size_t used();
+		[[nodiscard]] size_t capacity();
+	};
+
+	// Allocator for std::allocate_shared, every type it is rebound to (like the shared_ptr control block) gets its own pool
+	template<typename T>
+	class PoolAllocator {
+	public:
+		using value_type = T;
+
+		PoolAllocator() = default;
+		template<typename U>
+		PoolAllocator(const PoolAllocator<U>&) noexcept { }
+
+		[[nodiscard]] T* allocate(const size_t n) {
+			if (n != 1) {
+				return std::allocator<T>().allocate(n);
+			}
+			return static_cast<T*>(Pool().allocate());
+		}
+		void deallocate(T* p, const size_t n) {
+			if (n != 1) {
+				std::allocator<T>().deallocate(p, n);
+				return;
+			}
+			Pool().deallocate(p);
+		}
+
+		// Never destroyed, statics holding pooled objects may release them after static destruction began
+		static FixedBlockPool& Pool() {
+			static FixedBlockPool& pool = *new FixedBlockPool(sizeof(T), alignof(T));
+			return pool;
+		}
+
+		template<typename U>
+		constexpr bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+	};
+
+	template<typename T, typename... Args>
+	std::shared_ptr<T> MakePooled(Args&&... args) {
+		return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+	}
+
+	// Generation 0 is never handed out, so a default constructed handle never resolves
+	template<typename T>
+	struct Handle {
+		uint32_t index = 0;
+		uint32_t generation = 0;
+
+		[[nodiscard]] constexpr bool is_valid() const { return generation != 0; }
+		constexpr bool operator==(const Handle& other) const = default;
+	};
+
+	// Paged object storage addressed by handles. Objects keep their address until destroyed, handles to destroyed
+	// objects stop resolving instead of reaching the slot's next occupant. Not thread safe.
+	template<typename T, size_t PageSize = 64>
+	class ObjectPool {
+		static constexpr uint32_t NoSlot = UINT32_MAX;
+
+		struct Slot {
+			alignas(T) std::byte storage[sizeof(T)];
+			uint32_t generation = 1;
+			uint32_t next_free = NoSlot;
+			bool alive = false;
+
+			[[nodiscard]] T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+		};
+
+		std::vector<std::unique_ptr<Slot[]>> m_pages;
+		uint32_t m_uFreeList = NoSlot;
+		uint32_t m_uSlotCount = 0;
+		size_t m_uSize = 0;
+
+		[[nodiscard]] Slot& slot(const uint32_t index) const { return m_pages[index / PageSize][index % PageSize]; }
+		[[nodiscard]] Slot* resolve(const Handle<T> handle) const {
+			if (handle.index >= m_uSlotCount) {
+				return nullptr;
+			}
+			Slot& s = slot(handle.index);
+			return s.alive && s.generation == handle.generation ? &s : nullptr;
+		}
+		void release(const uint32_t index) {
+			Slot& s = slot(index);
+			s.alive = false;
+			s.generation = s.generation + 1 == 0 ? 1 : s.generation + 1;
+			s.next_free = m_uFreeList;
+			m_uFreeList = index;
+		}
+	public:
+		ObjectPool() = default;
+		~ObjectPool() { clear(); }
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		template<typename... Args>
+		Handle<T> create(Args&&... args) {
+			if (m_uFreeList == NoSlot) {
+				m_pages.emplace_back(std::make_unique<Slot[]>(PageSize));
+				// Pushed in reverse, so slots are handed out in address order
+				for (size_t i = PageSize; i > 0; i--) {
+					Slot& s = m_pages.back()[i - 1];
+					s.next_free = m_uFreeList;
+					m_uFreeList = static_cast<uint32_t>(m_uSlotCount + i - 1);
+				}
+				m_uSlotCount += static_cast<uint32_t>(PageSize);
+			}
+
+			const uint32_t index = m_uFreeList;
+			Slot& s = slot(index);
+			m_uFreeList = s.next_free;
+			try {
+				new (s.storage) T(std::forward<Args>(args)...);
+			} catch (...) {
+				s.next_free = m_uFreeList;
+				m_uFreeList = index;
+				throw;
+			}
+			s.alive = true;
+			m_uSize++;
+			return Handle<T> { index, s.generation };
+		}
+		bool destroy(const Handle<T> handle) {
+			Slot* s = resolve(handle);
+			if (s == nullptr) {
+				return false;
+			}
+			s->object()->~T();
+			release(handle.index);
+			m_uSize--;
+			return true;
+		}
+		void clear() {
+			for (uint32_t i = 0; i < m_uSlotCount; i++) {
+				if (Slot& s = slot(i); s.alive) {
+					s.object()->~T();
+					release(i);
+				}
+			}
+			m_uSize = 0;
+		}
+
+		[[nodiscard]] T* get(const Handle<T> handle) {
+			Slot* s = resolve(handle);
+			return s != nullptr ? s->object() : nullptr;
+		}
+		[[nodiscard]] const T* get(const Handle<T> handle) const {
+			Slot* s = resolve(handle);
+			return s != nullptr ? s->object() : nullptr;
+		}
+		[[nodiscard]] bool contains(const Handle<T> handle) const { return resolve(handle) != nullptr; }
+
+		// Calls fn(handle, object) for every live object in slot order
+		template<typename Fn>
+		void for_each(Fn&& fn) {
+			for (uint32_t i = 0; i < m_uSlotCount; i++) {
+				if (Slot& s = slot(i); s.alive) {
+					fn(Handle<T> { i, s.generation }, *s.object());
+				}
+			}
+		}
+
+		[[nodiscard]] inline size_t size() const { return m_uSize; }
+		[[nodiscard]] inline size_t capacity() const { return m_uSlotCount; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "gctk_profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gctk_cvar.hpp"
+#include "gctk_debug.hpp"
+#include "gctk_ring_buffer.hpp"
+
+namespace gctk {
+	struct ProfileEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// Only the owning thread pushes, Collect drains while holding the state mutex
+	struct ProfileThread {
+		static constexpr size_t Capacity = 4096;
+
+		RingBuffer<ProfileEvent, Capacity> buffer;
+		std::vector<ProfileEvent> captured;
+		std::atomic<uint64_t> dropped = 0;
+		uint32_t id = 0;
+		std::string name;
+	};
+
+	struct ProfilerState {
+		std::atomic<bool> capturing = false;
+		uint64_t capture_start = 0;
+		std::mutex mutex;
+		// Threads keep their buffer after they exit, their zones may still be part of the capture
+		std::vector<std::unique_ptr<ProfileThread>> threads;
+	};
+
+	CONCOMMAND(prof_start, CVAR_DEFAULT_FLAGS) {
+		(void)args;
+		Profiler::BeginCapture();
+	}
+	// Writes to logs/profile_<date>_<time>.json unless a path relative to the game directory is given
+	CONCOMMAND(prof_stop, CVAR_DEFAULT_FLAGS) {
+		Path path = Paths::GameBasePath() / "logs";
+		if (args.empty()) {
+			if (!Paths::exists(path)) {
+				Paths::create_directories(path);
+			}
+			path /= std::format("profile_{:%Y_%m_%d_%H%M%S}.json", std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
+		} else {
+			path = Paths::GameBasePath() / args.front();
+		}
+		Profiler::EndCapture(path);
+	}
+
+	static ProfilerState s_own_state;
+	static std::atomic<ProfilerState*> s_state = &s_own_state;
+
+	// A thread gets a new buffer when it records into another state, e.g. after Attach
+	static thread_local ProfileThread* s_thread = nullptr;
+	static thread_local ProfilerState* s_thread_state = nullptr;
+	static thread_local std::string s_thread_name;
+
+	static ProfileThread& GetProfileThread(ProfilerState& state) {
+		if (s_thread_state != &state) {
+			auto thread = std::make_unique<ProfileThread>();
+			// Every module has its own thread_local buffer, the hash keeps them on the same row of the trace
+			thread->id = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+			thread->name = s_thread_name;
+
+			std::lock_guard lock(state.mutex);
+			s_thread = state.threads.emplace_back(std::move(thread)).get();
+			s_thread_state = &state;
+		}
+		return *s_thread;
+	}
+
+	static void DrainThreads(ProfilerState& state, const bool keep) {
+		ProfileEvent event;
+		for (const auto& thread : state.threads) {
+			while (thread->buffer.try_pop(event)) {
+				if (keep) {
+					thread->captured.push_back(event);
+				}
+			}
+		}
+	}
+
+	static void AppendEscaped(std::string& out, const std::string_view str) {
+		for (const char c : str) {
+			if (c == '"' || c == '\\') {
+				out.push_back('\\');
+			}
+			out.push_back(c);
+		}
+	}
+
+	void Profiler::BeginCapture() {
+#ifndef GCTK_PROFILE
+		LogWarn("The engine was built without GCTK_PROFILE, the capture only contains zones of code built with it");
+#endif
+		ProfilerState& state = *s_state.load(std::memory_order_acquire);
+		std::lock_guard lock(state.mutex);
+		DrainThreads(state, false);
+		for (const auto& thread : state.threads) {
+			thread->captured.clear();
+			thread->dropped = 0;
+		}
+		state.capture_start = Now();
+		state.capturing.store(true, std::memory_order_release);
+	}
+	bool Profiler::EndCapture(const Path& path) {
+		ProfilerState& state = *s_state.load(std::memory_order_acquire);
+		if (!state.capturing.exchange(false)) {
+			LogWarn("No profiler capture is running");
+			return false;
+		}
+
+		std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		size_t event_count = 0;
+		uint64_t dropped = 0;
+		{
+			std::lock_guard lock(state.mutex);
+			DrainThreads(state, true);
+			for (const auto& thread : state.threads) {
+				if (!thread->name.empty()) {
+					json += std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"", thread->id);
+					AppendEscaped(json, thread->name);
+					json += "\"}},\n";
+				}
+				for (const auto& event : thread->captured) {
+					// Zones that started before a previous capture ended
+					if (event.start < state.capture_start) {
+						continue;
+					}
+					json += "{\"name\":\"";
+					AppendEscaped(json, event.name);
+					std::format_to(std::back_inserter(json), "\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}},\n",
+						static_cast<double>(event.start - state.capture_start) / 1000.0,
+						static_cast<double>(event.end - event.start) / 1000.0,
+						thread->id
+					);
+					event_count++;
+				}
+				dropped += thread->dropped.exchange(0);
+				thread->captured.clear();
+				thread->captured.shrink_to_fit();
+			}
+		}
+		if (json.ends_with(",\n")) {
+			json.resize(json.size() - 2);
+		}
+		json += "\n]}\n";
+
+		if (dropped > 0) {
+			LogWarn("{} profiler zones were dropped, the per-thread buffers were full", dropped);
+		}
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		if (!file.is_open()) {
+			LogErr("Failed to open profiler capture file \"{}\"", path);
+			return false;
+		}
+		file.write(json.data(), static_cast<std::streamsize>(json.size()));
+		LogInfo("Wrote {} profiler zones to \"{}\"", event_count, path);
+		return true;
+	}
+	bool Profiler::IsCapturing() {
+		return s_state.load(std::memory_order_relaxed)->capturing.load(std::memory_order_relaxed);
+	}
+	void Profiler::Collect() {
+		ProfilerState& state = *s_state.load(std::memory_order_acquire);
+		if (!state.capturing.load(std::memory_order_relaxed)) {
+			return;
+		}
+		std::lock_guard lock(state.mutex);
+		DrainThreads(state, true);
+	}
+	void Profiler::SetThreadName(const std::string& name) {
+		s_thread_name = name;
+		if (ProfilerState* state = s_thread_state; state != nullptr) {
+			std::lock_guard lock(state->mutex);
+			s_thread->name = name;
+		}
+	}
+
+	ProfilerState* Profiler::State() {
+		return s_state.load(std::memory_order_acquire);
+	}
+	void Profiler::Attach(ProfilerState* state) {
+		s_state.store(state != nullptr ? state : &s_own_state, std::memory_order_release);
+	}
+
+	uint64_t Profiler::Now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count());
+	}
+	void Profiler::Record(const char* name, const uint64_t start, const uint64_t end) {
+		ProfilerState& state = *s_state.load(std::memory_order_acquire);
+		if (!state.capturing.load(std::memory_order_relaxed)) {
+			return;
+		}
+		if (!GetProfileThread(state).buffer.try_push(ProfileEvent { name, start, end })) {
+			s_thread->dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "gctk_filesys.hpp"
+
+namespace gctk {
+	// Captured zones and the per-thread buffers they are recorded into
+	struct ProfilerState;
+
+	namespace Profiler {
+		// Zones are only recorded between BeginCapture and EndCapture
+		void BeginCapture();
+		// Writes the capture as Chrome trace JSON, open it in chrome://tracing or Perfetto
+		bool EndCapture(const Path& path);
+		bool IsCapturing();
+		// Moves recorded zones out of the per-thread ring buffers, called every frame so long captures fit into them
+		void Collect();
+		// Shown as the name of the calling thread in captures
+		void SetThreadName(const std::string& name);
+
+		// Every module links its own copy of the engine, the singleplayer launcher attaches its state to the client
+		// and server modules so one capture covers all of them
+		ProfilerState* State();
+		void Attach(ProfilerState* state);
+
+		// Nanoseconds on the steady clock
+		uint64_t Now();
+		void Record(const char* name, uint64_t start, uint64_t end);
+	}
+
+	class ProfileScope {
+		const char* m_pName;
+		uint64_t m_uStart;
+	public:
+		explicit ProfileScope(const char* name) : m_pName(name), m_uStart(Profiler::IsCapturing() ? Profiler::Now() : 0) { }
+		~ProfileScope() {
+			if (m_uStart != 0) {
+				Profiler::Record(m_pName, m_uStart, Profiler::Now());
+			}
+		}
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
+
+// Records the rest of the enclosing scope as a zone, name has to be a string literal.
+// Compiles to nothing unless built with GCTK_PROFILE.
+#ifdef GCTK_PROFILE
+	#define GCTK_PROFILE_CONCAT_INNER(__a, __b) __a##__b
+	#define GCTK_PROFILE_CONCAT(__a, __b) GCTK_PROFILE_CONCAT_INNER(__a, __b)
+	#define GCTK_PROFILE_SCOPE(__name) const gctk::ProfileScope GCTK_PROFILE_CONCAT(__gctk_profile_scope_, __LINE__)(__name)
+#else
+	#define GCTK_PROFILE_SCOPE(__name) static_cast<void>(0)
+#endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "gctk_math.hpp"
+
+#include <algorithm>
+
+namespace gctk {
+	// Scratch size for the shape fills, in elements
+	static constexpr size_t FillBatch = 64;
+
+	static void FillUniform(Xoshiro128x4& lanes, const std::span<float> out, const float min, const float max) {
+		const Simd::Float4 scale = Simd::Splat(max - min);
+		const Simd::Float4 offset = Simd::Splat(min);
+
+		size_t i = 0;
+		for (; i + 4 <= out.size(); i += 4) {
+			Simd::Store(out.data() + i, Simd::MulAdd(lanes.next_float(), scale, offset));
+		}
+		if (i < out.size()) {
+			float tail[4];
+			Simd::Store(tail, Simd::MulAdd(lanes.next_float(), scale, offset));
+			std::copy_n(tail, out.size() - i, out.data() + i);
+		}
+	}
+
+	void Random::fill_floats(const std::span<float> out, const float min, const float max) {
+		Xoshiro128x4 lanes(m_engine.next());
+		FillUniform(lanes, out, min, max);
+	}
+	void Random::fill_ints(const std::span<int32_t> out, const int32_t min, const int32_t max) {
+		for (auto& value : out) {
+			value = next_int<int32_t>(min, max);
+		}
+	}
+	void Random::fill_in_circle(const std::span<Vector2> out, const float r_min, const float r_max) {
+		Xoshiro128x4 lanes(m_engine.next());
+		float r[FillBatch], angle[FillBatch];
+		for (size_t begin = 0; begin < out.size(); begin += FillBatch) {
+			const size_t count = std::min(FillBatch, out.size() - begin);
+			FillUniform(lanes, { r, count }, r_min, r_max);
+			FillUniform(lanes, { angle, count }, 0.0f, Math::TwoPi<float>);
+			for (size_t i = 0; i < count; i++) {
+				out[begin + i] = Vector2 { r[i] * Math::Cos(angle[i]), r[i] * Math::Sin(angle[i]) };
+			}
+		}
+	}
+	void Random::fill_in_sphere(const std::span<Vector3> out, const float r_min, const float r_max) {
+		Xoshiro128x4 lanes(m_engine.next());
+		float r[FillBatch], a[FillBatch], b[FillBatch];
+		for (size_t begin = 0; begin < out.size(); begin += FillBatch) {
+			const size_t count = std::min(FillBatch, out.size() - begin);
+			FillUniform(lanes, { r, count }, r_min, r_max);
+			FillUniform(lanes, { a, count }, 0.0f, Math::TwoPi<float>);
+			FillUniform(lanes, { b, count }, 0.0f, Math::TwoPi<float>);
+			for (size_t i = 0; i < count; i++) {
+				const float sin_a = Math::Sin(a[i]);
+				out[begin + i] = Vector3 {
+					r[i] * sin_a * Math::Cos(b[i]),
+					r[i] * sin_a * Math::Sin(b[i]),
+					r[i] * Math::Cos(a[i])
+				};
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#include "gctk_simd.hpp"
+
+namespace gctk {
+	// Used to expand a single seed into the state of the larger generators
+	class SplitMix64 {
+		uint64_t m_uState;
+	public:
+		using result_type = uint64_t;
+
+		explicit constexpr SplitMix64(const uint64_t seed) : m_uState(seed) { }
+
+		constexpr uint64_t next() {
+			uint64_t z = (m_uState += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+		constexpr uint64_t operator()() { return next(); }
+
+		static constexpr uint64_t min() { return 0; }
+		static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+	};
+
+	// xoshiro256++, 32 bytes of state with a period of 2^256 - 1
+	class Xoshiro256 {
+		uint64_t m_state[4];
+
+		constexpr void apply_jump(const uint64_t (&table)[4]) {
+			uint64_t s[4] = { 0, 0, 0, 0 };
+			for (const uint64_t word : table) {
+				for (int b = 0; b < 64; b++) {
+					if (word & (1ULL << b)) {
+						for (int i = 0; i < 4; i++) {
+							s[i] ^= m_state[i];
+						}
+					}
+					next();
+				}
+			}
+			for (int i = 0; i < 4; i++) {
+				m_state[i] = s[i];
+			}
+		}
+	public:
+		using result_type = uint64_t;
+
+		explicit constexpr Xoshiro256(const uint64_t seed) : m_state() { this->seed(seed); }
+
+		constexpr void seed(const uint64_t seed) {
+			SplitMix64 sm(seed);
+			for (auto& s : m_state) {
+				s = sm.next();
+			}
+		}
+
+		constexpr uint64_t next() {
+			const uint64_t result = std::rotl(m_state[0] + m_state[3], 23) + m_state[0];
+			const uint64_t t = m_state[1] << 17;
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+			m_state[2] ^= t;
+			m_state[3] = std::rotl(m_state[3], 45);
+			return result;
+		}
+		constexpr uint64_t operator()() { return next(); }
+
+		// Advances the state by 2^128 calls, gives 2^128 non-overlapping sequences
+		constexpr void jump() {
+			constexpr uint64_t JUMP[4] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+			apply_jump(JUMP);
+		}
+		// Advances the state by 2^192 calls, gives 2^64 starting points each able to jump() 2^64 times
+		constexpr void long_jump() {
+			constexpr uint64_t LONG_JUMP[4] = { 0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL };
+			apply_jump(LONG_JUMP);
+		}
+		// Returns a generator continuing this sequence and moves this one 2^128 calls ahead
+		constexpr Xoshiro256 split() {
+			const Xoshiro256 child = *this;
+			jump();
+			return child;
+		}
+
+		static constexpr uint64_t min() { return 0; }
+		static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+	};
+
+	// PCG-XSH-RR, 32 bit output with 2^63 selectable streams
+	class Pcg32 {
+		static constexpr uint64_t Multiplier = 6364136223846793005ULL;
+
+		uint64_t m_uState;
+		uint64_t m_uIncrement;
+	public:
+		using result_type = uint32_t;
+
+		explicit constexpr Pcg32(const uint64_t seed, const uint64_t stream = 0) : m_uState(0), m_uIncrement(0) { this->seed(seed, stream); }
+
+		constexpr void seed(const uint64_t seed, const uint64_t stream = 0) {
+			m_uState = 0;
+			m_uIncrement = (stream << 1) | 1;
+			next();
+			m_uState += seed;
+			next();
+		}
+
+		constexpr uint32_t next() {
+			const uint64_t old = m_uState;
+			m_uState = old * Multiplier + m_uIncrement;
+			const auto shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+			return std::rotr(shifted, static_cast<int>(old >> 59));
+		}
+		constexpr uint32_t operator()() { return next(); }
+
+		// Skips delta calls in O(log delta)
+		constexpr void advance(uint64_t delta) {
+			uint64_t mul = Multiplier, add = m_uIncrement;
+			uint64_t acc_mul = 1, acc_add = 0;
+			while (delta > 0) {
+				if (delta & 1) {
+					acc_mul *= mul;
+					acc_add = acc_add * mul + add;
+				}
+				add = (mul + 1) * add;
+				mul *= mul;
+				delta >>= 1;
+			}
+			m_uState = acc_mul * m_uState + acc_add;
+		}
+		// Returns a generator on a different stream, seeded from this one
+		constexpr Pcg32 split(const uint64_t stream) {
+			// Separate statements, the evaluation order of the operands of | is unspecified
+			const uint64_t hi = next();
+			const uint64_t lo = next();
+			return Pcg32(hi << 32 | lo, stream);
+		}
+
+		static constexpr uint32_t min() { return 0; }
+		static constexpr uint32_t max() { return std::numeric_limits<uint32_t>::max(); }
+	};
+
+	// Four independent xoshiro128+ sequences, one per SIMD lane
+	class Xoshiro128x4 {
+		Simd::UInt4 m_s0, m_s1, m_s2, m_s3;
+	public:
+		explicit Xoshiro128x4(const uint64_t seed) : m_s0(), m_s1(), m_s2(), m_s3() {
+			SplitMix64 sm(seed);
+			uint32_t state[4][4];
+			for (int lane = 0; lane < 4; lane++) {
+				const uint64_t a = sm.next(), b = sm.next();
+				state[0][lane] = static_cast<uint32_t>(a);
+				state[1][lane] = static_cast<uint32_t>(a >> 32);
+				state[2][lane] = static_cast<uint32_t>(b);
+				state[3][lane] = static_cast<uint32_t>(b >> 32);
+			}
+			m_s0 = Simd::Load(state[0]);
+			m_s1 = Simd::Load(state[1]);
+			m_s2 = Simd::Load(state[2]);
+			m_s3 = Simd::Load(state[3]);
+		}
+
+		inline Simd::UInt4 next() {
+			const Simd::UInt4 result = m_s0 + m_s3;
+			const Simd::UInt4 t = Simd::ShiftLeft<9>(m_s1);
+			m_s2 = m_s2 ^ m_s0;
+			m_s3 = m_s3 ^ m_s1;
+			m_s1 = m_s1 ^ m_s2;
+			m_s0 = m_s0 ^ m_s3;
+			m_s2 = m_s2 ^ t;
+			m_s3 = Simd::RotateLeft<11>(m_s3);
+			return result;
+		}
+		// Four floats in [0, 1), only the high bits are used since the low bits of xoshiro128+ are weak
+		inline Simd::Float4 next_float() { return Simd::ToUnitFloat(next()); }
+	};
+
+	namespace RandomBits {
+		template<typename Engine>
+		constexpr uint32_t Next32(Engine& engine) {
+			if constexpr (Engine::max() > std::numeric_limits<uint32_t>::max()) {
+				return static_cast<uint32_t>(static_cast<uint64_t>(engine()) >> 32);
+			} else {
+				return static_cast<uint32_t>(engine());
+			}
+		}
+		template<typename Engine>
+		constexpr uint64_t Next64(Engine& engine) {
+			if constexpr (Engine::max() > std::numeric_limits<uint32_t>::max()) {
+				return static_cast<uint64_t>(engine());
+			} else {
+				const uint64_t high = engine();
+				return high << 32 | static_cast<uint64_t>(engine());
+			}
+		}
+
+		// Maps the top bits of x to [0, 1)
+		constexpr float ToFloat(const uint64_t x) { return static_cast<float>(x >> 40) * 0x1.0p-24f; }
+		constexpr double ToDouble(const uint64_t x) { return static_cast<double>(x >> 11) * 0x1.0p-53; }
+		constexpr float ToFloat(const uint32_t x) { return static_cast<float>(x >> 8) * 0x1.0p-24f; }
+
+		// Unbiased integer in [0, bound), bound must be non-zero
+		template<typename Engine>
+		constexpr uint64_t Bounded(Engine& engine, const uint64_t bound) {
+			if (bound <= std::numeric_limits<uint32_t>::max()) {
+				// Lemire's multiply-shift with rejection of the biased low range
+				auto m = static_cast<uint64_t>(Next32(engine)) * bound;
+				if (static_cast<uint32_t>(m) < bound) {
+					const auto threshold = static_cast<uint32_t>(-static_cast<uint32_t>(bound)) % static_cast<uint32_t>(bound);
+					while (static_cast<uint32_t>(m) < threshold) {
+						m = static_cast<uint64_t>(Next32(engine)) * bound;
+					}
+				}
+				return m >> 32;
+			}
+			const uint64_t mask = std::numeric_limits<uint64_t>::max() >> std::countl_zero(bound - 1);
+			uint64_t x;
+			do {
+				x = Next64(engine) & mask;
+			} while (x >= bound);
+			return x;
+		}
+	}
+}
\ No newline at end of file
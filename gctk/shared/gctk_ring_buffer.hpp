@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace gctk {
+	inline constexpr size_t CacheLineSize = 64;
+
+	// Lock-free queue for exactly one producer thread and one consumer thread
+	template<typename T, size_t Capacity>
+	class RingBuffer {
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+		alignas(CacheLineSize) std::atomic<size_t> m_uHead;
+		alignas(CacheLineSize) std::atomic<size_t> m_uTail;
+		alignas(CacheLineSize) std::array<T, Capacity> m_items;
+	public:
+		RingBuffer() : m_uHead(0), m_uTail(0) { }
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		[[nodiscard]] bool try_push(const T& item) {
+			const auto tail = m_uTail.load(std::memory_order_relaxed);
+			if (tail - m_uHead.load(std::memory_order_acquire) == Capacity) {
+				return false;
+			}
+			m_items[tail & (Capacity - 1)] = item;
+			m_uTail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		[[nodiscard]] bool try_push(T&& item) {
+			const auto tail = m_uTail.load(std::memory_order_relaxed);
+			if (tail - m_uHead.load(std::memory_order_acquire) == Capacity) {
+				return false;
+			}
+			m_items[tail & (Capacity - 1)] = std::move(item);
+			m_uTail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		[[nodiscard]] bool try_pop(T& out) {
+			const auto head = m_uHead.load(std::memory_order_relaxed);
+			if (head == m_uTail.load(std::memory_order_acquire)) {
+				return false;
+			}
+			out = std::move(m_items[head & (Capacity - 1)]);
+			m_uHead.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		[[nodiscard]] size_t size() const {
+			return m_uTail.load(std::memory_order_acquire) - m_uHead.load(std::memory_order_acquire);
+		}
+		[[nodiscard]] bool empty() const { return size() == 0; }
+		[[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GCTK_SIMD_SSE
+	#if defined(__FMA__) || defined(__AVX2__)
+		#include <immintrin.h>
+		#define GCTK_SIMD_FMA
+	#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define GCTK_SIMD_NEON
+#endif
+
+#if defined(GCTK_SIMD_SSE) || defined(GCTK_SIMD_NEON)
+	#define GCTK_SIMD
+#endif
+
+// 4 float lanes with SSE2, NEON and scalar implementations, so kernels are written once
+namespace gctk::Simd {
+#if defined(GCTK_SIMD_SSE)
+	struct Float4 {
+		__m128 v;
+	};
+	inline Float4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+	inline void Store(float* p, const Float4 a) { _mm_storeu_ps(p, a.v); }
+	inline Float4 Splat(const float x) { return { _mm_set1_ps(x) }; }
+	inline Float4 Set(const float x, const float y, const float z, const float w) { return { _mm_setr_ps(x, y, z, w) }; }
+	inline Float4 operator+ (const Float4 a, const Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Float4 operator- (const Float4 a, const Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline Float4 operator* (const Float4 a, const Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline Float4 operator/ (const Float4 a, const Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline Float4 Sqrt(const Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+	inline Float4 Min(const Float4 a, const Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline Float4 Max(const Float4 a, const Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+	// a * b + c, fused when the target has FMA
+	inline Float4 MulAdd(const Float4 a, const Float4 b, const Float4 c) {
+	#if defined(GCTK_SIMD_FMA)
+		return { _mm_fmadd_ps(a.v, b.v, c.v) };
+	#else
+		return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) };
+	#endif
+	}
+	// Lanes of a reordered as { a[I0], a[I1], a[I2], a[I3] }
+	template<int I0, int I1, int I2, int I3>
+	inline Float4 Permute(const Float4 a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(I3, I2, I1, I0)) }; }
+	inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) { _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+	inline float HorizontalSum(const Float4 a) {
+		const __m128 pairs = _mm_add_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+	}
+	// a with its sign flipped wherever sign is negative
+	inline Float4 FlipSign(const Float4 a, const Float4 sign) {
+		return { _mm_xor_ps(a.v, _mm_and_ps(sign.v, _mm_set1_ps(-0.0f))) };
+	}
+	// Converts 4 signed 16 bit integers
+	inline Float4 LoadInt16(const int16_t* p) {
+		const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		return { _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16)) };
+	}
+
+	struct UInt4 {
+		__m128i v;
+	};
+	inline UInt4 Load(const uint32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+	inline void Store(uint32_t* p, const UInt4 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+	inline UInt4 operator+ (const UInt4 a, const UInt4 b) { return { _mm_add_epi32(a.v, b.v) }; }
+	inline UInt4 operator^ (const UInt4 a, const UInt4 b) { return { _mm_xor_si128(a.v, b.v) }; }
+	template<int N>
+	inline UInt4 ShiftLeft(const UInt4 a) { return { _mm_slli_epi32(a.v, N) }; }
+	template<int N>
+	inline UInt4 RotateLeft(const UInt4 a) { return { _mm_or_si128(_mm_slli_epi32(a.v, N), _mm_srli_epi32(a.v, 32 - N)) }; }
+	// Maps the top 24 bits of each lane to [0, 1)
+	inline Float4 ToUnitFloat(const UInt4 a) { return { _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a.v, 8)), _mm_set1_ps(0x1.0p-24f)) }; }
+#elif defined(GCTK_SIMD_NEON)
+	struct Float4 {
+		float32x4_t v;
+	};
+	inline Float4 Load(const float* p) { return { vld1q_f32(p) }; }
+	inline void Store(float* p, const Float4 a) { vst1q_f32(p, a.v); }
+	inline Float4 Splat(const float x) { return { vdupq_n_f32(x) }; }
+	inline Float4 Set(const float x, const float y, const float z, const float w) {
+		const float values[4] = { x, y, z, w };
+		return { vld1q_f32(values) };
+	}
+	inline Float4 operator+ (const Float4 a, const Float4 b) { return { vaddq_f32(a.v, b.v) }; }
+	inline Float4 operator- (const Float4 a, const Float4 b) { return { vsubq_f32(a.v, b.v) }; }
+	inline Float4 operator* (const Float4 a, const Float4 b) { return { vmulq_f32(a.v, b.v) }; }
+	inline Float4 operator/ (const Float4 a, const Float4 b) { return { vdivq_f32(a.v, b.v) }; }
+	inline Float4 Sqrt(const Float4 a) { return { vsqrtq_f32(a.v) }; }
+	inline Float4 Min(const Float4 a, const Float4 b) { return { vminq_f32(a.v, b.v) }; }
+	inline Float4 Max(const Float4 a, const Float4 b) { return { vmaxq_f32(a.v, b.v) }; }
+	inline Float4 MulAdd(const Float4 a, const Float4 b, const Float4 c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+	template<int I0, int I1, int I2, int I3>
+	inline Float4 Permute(const Float4 a) {
+	#if defined(__GNUC__) || defined(__clang__)
+		return { __builtin_shufflevector(a.v, a.v, I0, I1, I2, I3) };
+	#else
+		float values[4];
+		vst1q_f32(values, a.v);
+		return Set(values[I0], values[I1], values[I2], values[I3]);
+	#endif
+	}
+	inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+		const float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+		const float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+		a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+		b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+		c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+		d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+	}
+	inline float HorizontalSum(const Float4 a) { return vaddvq_f32(a.v); }
+	inline Float4 FlipSign(const Float4 a, const Float4 sign) {
+		const uint32x4_t mask = vandq_u32(vreinterpretq_u32_f32(sign.v), vdupq_n_u32(0x80000000u));
+		return { vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), mask)) };
+	}
+	inline Float4 LoadInt16(const int16_t* p) {
+		return { vcvtq_f32_s32(vmovl_s16(vld1_s16(p))) };
+	}
+
+	struct UInt4 {
+		uint32x4_t v;
+	};
+	inline UInt4 Load(const uint32_t* p) { return { vld1q_u32(p) }; }
+	inline void Store(uint32_t* p, const UInt4 a) { vst1q_u32(p, a.v); }
+	inline UInt4 operator+ (const UInt4 a, const UInt4 b) { return { vaddq_u32(a.v, b.v) }; }
+	inline UInt4 operator^ (const UInt4 a, const UInt4 b) { return { veorq_u32(a.v, b.v) }; }
+	template<int N>
+	inline UInt4 ShiftLeft(const UInt4 a) { return { vshlq_n_u32(a.v, N) }; }
+	template<int N>
+	inline UInt4 RotateLeft(const UInt4 a) { return { vsriq_n_u32(vshlq_n_u32(a.v, N), a.v, 32 - N) }; }
+	inline Float4 ToUnitFloat(const UInt4 a) { return { vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(a.v, 8)), 0x1.0p-24f) }; }
+#else
+	struct Float4 {
+		float v[4];
+	};
+	inline Float4 Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void Store(float* p, const Float4 a) { memcpy(p, a.v, sizeof(a.v)); }
+	inline Float4 Splat(const float x) { return { { x, x, x, x } }; }
+	inline Float4 Set(const float x, const float y, const float z, const float w) { return { { x, y, z, w } }; }
+	inline Float4 operator+ (const Float4 a, const Float4 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	inline Float4 operator- (const Float4 a, const Float4 b) { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+	inline Float4 operator* (const Float4 a, const Float4 b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+	inline Float4 operator/ (const Float4 a, const Float4 b) { return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+	inline Float4 Sqrt(const Float4 a) { return { { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+	inline Float4 Min(const Float4 a, const Float4 b) {
+		return { { std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]), std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3]) } };
+	}
+	inline Float4 Max(const Float4 a, const Float4 b) {
+		return { { std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]), std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3]) } };
+	}
+	inline Float4 MulAdd(const Float4 a, const Float4 b, const Float4 c) { return a * b + c; }
+	template<int I0, int I1, int I2, int I3>
+	inline Float4 Permute(const Float4 a) { return { { a.v[I0], a.v[I1], a.v[I2], a.v[I3] } }; }
+	inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+		const Float4 r0 = a, r1 = b, r2 = c, r3 = d;
+		a = { { r0.v[0], r1.v[0], r2.v[0], r3.v[0] } };
+		b = { { r0.v[1], r1.v[1], r2.v[1], r3.v[1] } };
+		c = { { r0.v[2], r1.v[2], r2.v[2], r3.v[2] } };
+		d = { { r0.v[3], r1.v[3], r2.v[3], r3.v[3] } };
+	}
+	inline float HorizontalSum(const Float4 a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+	inline Float4 FlipSign(const Float4 a, const Float4 sign) {
+		return { {
+			std::signbit(sign.v[0]) ? -a.v[0] : a.v[0], std::signbit(sign.v[1]) ? -a.v[1] : a.v[1],
+			std::signbit(sign.v[2]) ? -a.v[2] : a.v[2], std::signbit(sign.v[3]) ? -a.v[3] : a.v[3]
+		} };
+	}
+	inline Float4 LoadInt16(const int16_t* p) {
+		return { { static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]), static_cast<float>(p[3]) } };
+	}
+
+	struct UInt4 {
+		uint32_t v[4];
+	};
+	inline UInt4 Load(const uint32_t* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void Store(uint32_t* p, const UInt4 a) { memcpy(p, a.v, sizeof(a.v)); }
+	inline UInt4 operator+ (const UInt4 a, const UInt4 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	inline UInt4 operator^ (const UInt4 a, const UInt4 b) { return { { a.v[0] ^ b.v[0], a.v[1] ^ b.v[1], a.v[2] ^ b.v[2], a.v[3] ^ b.v[3] } }; }
+	template<int N>
+	inline UInt4 ShiftLeft(const UInt4 a) { return { { a.v[0] << N, a.v[1] << N, a.v[2] << N, a.v[3] << N } }; }
+	template<int N>
+	inline UInt4 RotateLeft(const UInt4 a) {
+		return { {
+			(a.v[0] << N) | (a.v[0] >> (32 - N)), (a.v[1] << N) | (a.v[1] >> (32 - N)),
+			(a.v[2] << N) | (a.v[2] >> (32 - N)), (a.v[3] << N) | (a.v[3] >> (32 - N))
+		} };
+	}
+	inline Float4 ToUnitFloat(const UInt4 a) {
+		return { {
+			static_cast<float>(a.v[0] >> 8) * 0x1.0p-24f, static_cast<float>(a.v[1] >> 8) * 0x1.0p-24f,
+			static_cast<float>(a.v[2] >> 8) * 0x1.0p-24f, static_cast<float>(a.v[3] >> 8) * 0x1.0p-24f
+		} };
+	}
+#endif
+}
\ No newline at end of file
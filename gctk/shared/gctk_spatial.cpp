@@ -0,0 +1,454 @@
+#include "gctk_spatial.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "gctk_jobs.hpp"
+
+namespace gctk {
+	// Subtrees with fewer leaves than this are always built within the same job
+	static constexpr size_t MinParallelBuild = 4096;
+
+	// Twice the center of the bounds along one axis, enough for ordering
+	static float CenterAxis(const AABB& bounds, const int axis) {
+		switch (axis) {
+			case 0:  return bounds.min.x + bounds.max.x;
+			case 1:  return bounds.min.y + bounds.max.y;
+			default: return bounds.min.z + bounds.max.z;
+		}
+	}
+
+	AABBTree::AABBTree(const float margin) : m_iRoot(Spatial::Null), m_iFreeList(Spatial::Null), m_uLeafCount(0), m_fMargin(margin) { }
+
+	int32_t AABBTree::allocate_node() {
+		if (m_iFreeList == Spatial::Null) {
+			m_nodes.emplace_back();
+			m_iFreeList = static_cast<int32_t>(m_nodes.size() - 1);
+			m_nodes.back().parent = Spatial::Null;
+		}
+		const int32_t node = m_iFreeList;
+		m_iFreeList = m_nodes[node].parent;
+		m_nodes[node] = Node { AABB { }, 0, Spatial::Null, Spatial::Null, Spatial::Null, 0 };
+		return node;
+	}
+	void AABBTree::free_node(const int32_t node) {
+		m_nodes[node].parent = m_iFreeList;
+		m_nodes[node].left = m_nodes[node].right = Spatial::Null;
+		m_nodes[node].height = -1;
+		m_iFreeList = node;
+	}
+
+	void AABBTree::refit(const int32_t node) {
+		Node& n = m_nodes[node];
+		n.bounds = AABB::Merge(m_nodes[n.left].bounds, m_nodes[n.right].bounds);
+		n.height = 1 + std::max(m_nodes[n.left].height, m_nodes[n.right].height);
+	}
+
+	void AABBTree::insert_leaf(const int32_t leaf) {
+		if (m_iRoot == Spatial::Null) {
+			m_iRoot = leaf;
+			m_nodes[leaf].parent = Spatial::Null;
+			return;
+		}
+
+		// Walk down picking the child whose bounds grow the least, stop where pairing with the node is cheaper
+		const AABB bounds = m_nodes[leaf].bounds;
+		int32_t index = m_iRoot;
+		while (!m_nodes[index].is_leaf()) {
+			const Node& node = m_nodes[index];
+			const float area = node.bounds.surface_area();
+			const float combined_area = AABB::Merge(node.bounds, bounds).surface_area();
+			const float cost = 2.0f * combined_area;
+			const float inheritance = 2.0f * (combined_area - area);
+
+			const auto descend_cost = [&](const int32_t child) {
+				const Node& c = m_nodes[child];
+				const float merged = AABB::Merge(c.bounds, bounds).surface_area();
+				return (c.is_leaf() ? merged : merged - c.bounds.surface_area()) + inheritance;
+			};
+			const float cost_left = descend_cost(node.left);
+			const float cost_right = descend_cost(node.right);
+			if (cost < cost_left && cost < cost_right) {
+				break;
+			}
+			index = cost_left < cost_right ? node.left : node.right;
+		}
+
+		const int32_t sibling = index;
+		const int32_t old_parent = m_nodes[sibling].parent;
+		const int32_t new_parent = allocate_node();
+		m_nodes[new_parent].parent = old_parent;
+		m_nodes[new_parent].bounds = AABB::Merge(bounds, m_nodes[sibling].bounds);
+		m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+		m_nodes[new_parent].left = sibling;
+		m_nodes[new_parent].right = leaf;
+		m_nodes[sibling].parent = new_parent;
+		m_nodes[leaf].parent = new_parent;
+
+		if (old_parent == Spatial::Null) {
+			m_iRoot = new_parent;
+		} else if (m_nodes[old_parent].left == sibling) {
+			m_nodes[old_parent].left = new_parent;
+		} else {
+			m_nodes[old_parent].right = new_parent;
+		}
+
+		for (index = m_nodes[leaf].parent; index != Spatial::Null; index = m_nodes[index].parent) {
+			index = balance(index);
+			refit(index);
+		}
+	}
+
+	void AABBTree::remove_leaf(const int32_t leaf) {
+		if (leaf == m_iRoot) {
+			m_iRoot = Spatial::Null;
+			return;
+		}
+
+		const int32_t parent = m_nodes[leaf].parent;
+		const int32_t grand_parent = m_nodes[parent].parent;
+		const int32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+		free_node(parent);
+
+		if (grand_parent == Spatial::Null) {
+			m_iRoot = sibling;
+			m_nodes[sibling].parent = Spatial::Null;
+			return;
+		}
+
+		if (m_nodes[grand_parent].left == parent) {
+			m_nodes[grand_parent].left = sibling;
+		} else {
+			m_nodes[grand_parent].right = sibling;
+		}
+		m_nodes[sibling].parent = grand_parent;
+
+		for (int32_t index = grand_parent; index != Spatial::Null; index = m_nodes[index].parent) {
+			index = balance(index);
+			refit(index);
+		}
+	}
+
+	// Rotates the taller child up when the subtrees of a differ in height by more than one, returns the new subtree root
+	int32_t AABBTree::balance(const int32_t a) {
+		if (m_nodes[a].is_leaf() || m_nodes[a].height < 2) {
+			return a;
+		}
+
+		const int32_t b = m_nodes[a].left;
+		const int32_t c = m_nodes[a].right;
+		const int32_t difference = m_nodes[c].height - m_nodes[b].height;
+		if (difference >= -1 && difference <= 1) {
+			return a;
+		}
+
+		// up is the child that moves up, keep stays under a
+		const int32_t up = difference > 1 ? c : b;
+		const int32_t keep = difference > 1 ? b : c;
+		const int32_t f = m_nodes[up].left;
+		const int32_t g = m_nodes[up].right;
+
+		m_nodes[up].left = a;
+		m_nodes[up].parent = m_nodes[a].parent;
+		m_nodes[a].parent = up;
+		if (const int32_t parent = m_nodes[up].parent; parent == Spatial::Null) {
+			m_iRoot = up;
+		} else if (m_nodes[parent].left == a) {
+			m_nodes[parent].left = up;
+		} else {
+			m_nodes[parent].right = up;
+		}
+
+		// The taller grandchild stays with up, the shorter one replaces up under a
+		const int32_t stay = m_nodes[f].height > m_nodes[g].height ? f : g;
+		const int32_t move = stay == f ? g : f;
+		m_nodes[up].right = stay;
+		if (difference > 1) {
+			m_nodes[a].right = move;
+		} else {
+			m_nodes[a].left = move;
+		}
+		m_nodes[move].parent = a;
+
+		m_nodes[a].bounds = AABB::Merge(m_nodes[keep].bounds, m_nodes[move].bounds);
+		m_nodes[a].height = 1 + std::max(m_nodes[keep].height, m_nodes[move].height);
+		m_nodes[up].bounds = AABB::Merge(m_nodes[a].bounds, m_nodes[stay].bounds);
+		m_nodes[up].height = 1 + std::max(m_nodes[a].height, m_nodes[stay].height);
+		return up;
+	}
+
+	int32_t AABBTree::insert(const AABB& bounds, const uint64_t user_data) {
+		const int32_t leaf = allocate_node();
+		m_nodes[leaf].bounds = bounds.expanded(m_fMargin);
+		m_nodes[leaf].user_data = user_data;
+		insert_leaf(leaf);
+		m_uLeafCount++;
+		return leaf;
+	}
+
+	void AABBTree::remove(const int32_t proxy) {
+		Assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()) && m_nodes[proxy].height == 0, "Invalid AABBTree proxy {}", proxy);
+		remove_leaf(proxy);
+		free_node(proxy);
+		m_uLeafCount--;
+	}
+
+	bool AABBTree::move(const int32_t proxy, const AABB& bounds, const Vector3& displacement) {
+		Assert(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()) && m_nodes[proxy].height == 0, "Invalid AABBTree proxy {}", proxy);
+		if (m_nodes[proxy].bounds.contains(bounds)) {
+			return false;
+		}
+
+		AABB fat = bounds.expanded(m_fMargin);
+		const Vector3 d = displacement * 2.0f;
+		(d.x < 0.0f ? fat.min.x : fat.max.x) += d.x;
+		(d.y < 0.0f ? fat.min.y : fat.max.y) += d.y;
+		(d.z < 0.0f ? fat.min.z : fat.max.z) += d.z;
+
+		remove_leaf(proxy);
+		m_nodes[proxy].bounds = fat;
+		insert_leaf(proxy);
+		return true;
+	}
+
+	void AABBTree::clear() {
+		m_nodes.clear();
+		m_iRoot = Spatial::Null;
+		m_iFreeList = Spatial::Null;
+		m_uLeafCount = 0;
+	}
+
+	int32_t AABBTree::build_range(const std::span<int32_t> leaves, const std::span<const int32_t> slots, const int32_t parent) {
+		if (leaves.size() == 1) {
+			m_nodes[leaves[0]].parent = parent;
+			return leaves[0];
+		}
+
+		// Median split along the axis where the leaf centers spread the most
+		AABB centers = AABB::Empty();
+		for (const int32_t leaf : leaves) {
+			const Vector3 c = m_nodes[leaf].bounds.center();
+			centers = AABB::Merge(centers, AABB { c, c });
+		}
+		const Vector3 spread = centers.max - centers.min;
+		const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : spread.y >= spread.z ? 1 : 2;
+		const size_t mid = leaves.size() / 2;
+		std::nth_element(leaves.begin(), leaves.begin() + static_cast<ptrdiff_t>(mid), leaves.end(), [&](const int32_t a, const int32_t b) {
+			return CenterAxis(m_nodes[a].bounds, axis) < CenterAxis(m_nodes[b].bounds, axis);
+		});
+
+		// A subtree with n leaves owns n - 1 internal slots: its root first, then the left and right subtrees
+		const auto left_leaves = leaves.first(mid);
+		const auto right_leaves = leaves.subspan(mid);
+		const auto left_slots = slots.subspan(1, mid - 1);
+		const auto right_slots = slots.subspan(mid, right_leaves.size() - 1);
+		const int32_t node = slots[0];
+
+		int32_t left, right;
+		if (leaves.size() >= MinParallelBuild && Jobs::WorkerCount() > 0) {
+			JobCounter counter;
+			Jobs::Run([&] { left = build_range(left_leaves, left_slots, node); }, &counter);
+			right = build_range(right_leaves, right_slots, node);
+			Jobs::Wait(counter);
+		} else {
+			left = build_range(left_leaves, left_slots, node);
+			right = build_range(right_leaves, right_slots, node);
+		}
+
+		Node& n = m_nodes[node];
+		n.user_data = 0;
+		n.parent = parent;
+		n.left = left;
+		n.right = right;
+		refit(node);
+		return node;
+	}
+
+	void AABBTree::build(const std::span<int32_t> leaves) {
+		m_iRoot = Spatial::Null;
+		m_iFreeList = Spatial::Null;
+		if (leaves.empty()) {
+			m_nodes.clear();
+			return;
+		}
+
+		// Every node that is not a leaf becomes an internal node or goes back on the free list
+		std::vector<bool> is_leaf(m_nodes.size(), false);
+		for (const int32_t leaf : leaves) {
+			is_leaf[leaf] = true;
+		}
+		std::vector<int32_t> slots;
+		slots.reserve(std::max(m_nodes.size() - leaves.size(), leaves.size() - 1));
+		for (size_t i = 0; i < m_nodes.size(); i++) {
+			if (!is_leaf[i]) {
+				slots.push_back(static_cast<int32_t>(i));
+			}
+		}
+		while (slots.size() < leaves.size() - 1) {
+			slots.push_back(static_cast<int32_t>(m_nodes.size()));
+			m_nodes.emplace_back();
+		}
+
+		const std::span<const int32_t> internal_slots = std::span(slots).first(leaves.size() - 1);
+		m_iRoot = build_range(leaves, internal_slots, Spatial::Null);
+
+		for (size_t i = slots.size(); i > leaves.size() - 1; i--) {
+			free_node(slots[i - 1]);
+		}
+	}
+
+	std::vector<int32_t> AABBTree::rebuild(const std::span<const SpatialItem> items) {
+		clear();
+		m_nodes.reserve(items.size() * 2);
+		for (const auto& item : items) {
+			m_nodes.push_back(Node { item.bounds.expanded(m_fMargin), item.user_data, Spatial::Null, Spatial::Null, Spatial::Null, 0 });
+		}
+		m_uLeafCount = items.size();
+
+		std::vector<int32_t> proxies(items.size());
+		std::iota(proxies.begin(), proxies.end(), 0);
+		std::vector<int32_t> leaves = proxies;
+		build(leaves);
+		return proxies;
+	}
+
+	void AABBTree::rebuild() {
+		std::vector<int32_t> leaves;
+		leaves.reserve(m_uLeafCount);
+		for (size_t i = 0; i < m_nodes.size(); i++) {
+			if (m_nodes[i].height == 0) {
+				leaves.push_back(static_cast<int32_t>(i));
+			}
+		}
+		build(leaves);
+	}
+
+	LooseGrid::LooseGrid(const AABB& bounds, const float cell_size) :
+		m_iFreeList(Spatial::Null), m_uCount(0), m_origin(bounds.min), m_fCellSize(cell_size), m_fInvCellSize(1.0f / cell_size), m_fMaxExtent(0.0f) {
+		m_iWidth = std::max(1, static_cast<int32_t>(std::ceil((bounds.max.x - bounds.min.x) * m_fInvCellSize)));
+		m_iDepth = std::max(1, static_cast<int32_t>(std::ceil((bounds.max.z - bounds.min.z) * m_fInvCellSize)));
+		m_cells.resize(static_cast<size_t>(m_iWidth) * m_iDepth, Cell { AABB::Empty(), { } });
+	}
+
+	int32_t LooseGrid::cell_x(const float x) const {
+		return static_cast<int32_t>(Math::Clamp(std::floor((x - m_origin.x) * m_fInvCellSize), 0.0f, static_cast<float>(m_iWidth - 1)));
+	}
+	int32_t LooseGrid::cell_z(const float z) const {
+		return static_cast<int32_t>(Math::Clamp(std::floor((z - m_origin.z) * m_fInvCellSize), 0.0f, static_cast<float>(m_iDepth - 1)));
+	}
+
+	void LooseGrid::place(const int32_t proxy, const AABB& bounds) {
+		const int32_t index = cell_of(bounds);
+		Cell& cell = m_cells[index];
+		cell.entries.push_back(Entry { bounds, proxy });
+		cell.bounds = AABB::Merge(cell.bounds, bounds);
+		m_handles[proxy].cell = index;
+		m_handles[proxy].slot = static_cast<int32_t>(cell.entries.size() - 1);
+
+		const Vector3 extents = bounds.extents();
+		m_fMaxExtent = std::max({ m_fMaxExtent, extents.x, extents.z });
+	}
+	void LooseGrid::unplace(const int32_t proxy) {
+		const Handle& handle = m_handles[proxy];
+		Cell& cell = m_cells[handle.cell];
+		const Entry& last = cell.entries.back();
+		m_handles[last.proxy].slot = handle.slot;
+		cell.entries[handle.slot] = last;
+		cell.entries.pop_back();
+		if (cell.entries.empty()) {
+			cell.bounds = AABB::Empty();
+		}
+	}
+
+	int32_t LooseGrid::insert(const AABB& bounds, const uint64_t user_data) {
+		int32_t proxy;
+		if (m_iFreeList != Spatial::Null) {
+			proxy = m_iFreeList;
+			m_iFreeList = m_handles[proxy].slot;
+		} else {
+			proxy = static_cast<int32_t>(m_handles.size());
+			m_handles.emplace_back();
+		}
+		m_handles[proxy].user_data = user_data;
+		place(proxy, bounds);
+		m_uCount++;
+		return proxy;
+	}
+
+	void LooseGrid::remove(const int32_t proxy) {
+		Assert(proxy >= 0 && proxy < static_cast<int32_t>(m_handles.size()) && m_handles[proxy].cell != Spatial::Null, "Invalid LooseGrid proxy {}", proxy);
+		unplace(proxy);
+		m_handles[proxy].cell = Spatial::Null;
+		m_handles[proxy].slot = m_iFreeList;
+		m_iFreeList = proxy;
+		m_uCount--;
+	}
+
+	void LooseGrid::move(const int32_t proxy, const AABB& bounds) {
+		Assert(proxy >= 0 && proxy < static_cast<int32_t>(m_handles.size()) && m_handles[proxy].cell != Spatial::Null, "Invalid LooseGrid proxy {}", proxy);
+		const Handle& handle = m_handles[proxy];
+		if (cell_of(bounds) != handle.cell) {
+			unplace(proxy);
+			place(proxy, bounds);
+			return;
+		}
+
+		Cell& cell = m_cells[handle.cell];
+		cell.entries[handle.slot].bounds = bounds;
+		cell.bounds = AABB::Merge(cell.bounds, bounds);
+		const Vector3 extents = bounds.extents();
+		m_fMaxExtent = std::max({ m_fMaxExtent, extents.x, extents.z });
+	}
+
+	void LooseGrid::clear() {
+		for (auto& cell : m_cells) {
+			cell.entries.clear();
+			cell.bounds = AABB::Empty();
+		}
+		m_handles.clear();
+		m_iFreeList = Spatial::Null;
+		m_uCount = 0;
+		m_fMaxExtent = 0.0f;
+	}
+
+	std::vector<int32_t> LooseGrid::rebuild(const std::span<const SpatialItem> items) {
+		clear();
+
+		// Size every cell up front, so the fill below never reallocates
+		std::vector<uint32_t> counts(m_cells.size(), 0);
+		for (const auto& item : items) {
+			counts[cell_of(item.bounds)]++;
+		}
+		for (size_t i = 0; i < m_cells.size(); i++) {
+			m_cells[i].entries.reserve(counts[i]);
+		}
+
+		m_handles.resize(items.size());
+		std::vector<int32_t> proxies(items.size());
+		for (size_t i = 0; i < items.size(); i++) {
+			const auto proxy = static_cast<int32_t>(i);
+			m_handles[i].user_data = items[i].user_data;
+			place(proxy, items[i].bounds);
+			proxies[i] = proxy;
+		}
+		m_uCount = items.size();
+		return proxies;
+	}
+
+	void LooseGrid::rebuild() {
+		m_fMaxExtent = 0.0f;
+		for (auto& cell : m_cells) {
+			cell.bounds = AABB::Empty();
+			for (const auto& entry : cell.entries) {
+				cell.bounds = AABB::Merge(cell.bounds, entry.bounds);
+				const Vector3 extents = entry.bounds.extents();
+				m_fMaxExtent = std::max({ m_fMaxExtent, extents.x, extents.z });
+			}
+		}
+	}
+
+	const AABB& LooseGrid::bounds(const int32_t proxy) const {
+		const Handle& handle = m_handles[proxy];
+		return m_cells[handle.cell].entries[handle.slot].bounds;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "gctk_math.hpp"
+#include "gctk_debug.hpp"
+
+namespace gctk {
+	struct Ray {
+		Vector3 origin;
+		Vector3 direction;
+	};
+
+	struct AABB {
+		Vector3 min, max;
+
+		constexpr AABB() : min(), max() { }
+		constexpr AABB(const Vector3& min, const Vector3& max) : min(min), max(max) { }
+
+		[[nodiscard]] constexpr Vector3 center() const { return (min + max) * 0.5f; }
+		[[nodiscard]] constexpr Vector3 extents() const { return (max - min) * 0.5f; }
+		[[nodiscard]] constexpr bool is_empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+		[[nodiscard]] constexpr float surface_area() const {
+			const Vector3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		[[nodiscard]] constexpr bool contains(const Vector3& point) const {
+			return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+		}
+		[[nodiscard]] constexpr bool contains(const AABB& other) const {
+			return other.min.x >= min.x && other.max.x <= max.x &&
+				other.min.y >= min.y && other.max.y <= max.y &&
+				other.min.z >= min.z && other.max.z <= max.z;
+		}
+		[[nodiscard]] constexpr bool overlaps(const AABB& other) const {
+			return other.min.x <= max.x && other.max.x >= min.x &&
+				other.min.y <= max.y && other.max.y >= min.y &&
+				other.min.z <= max.z && other.max.z >= min.z;
+		}
+		[[nodiscard]] constexpr bool overlaps(const Vector3& center, const float radius) const {
+			return (Vector3::Clamp(center, min, max) - center).length_square() <= radius * radius;
+		}
+		// Slab test against a ray given by its origin and per-axis reciprocal direction, t is the entry distance
+		[[nodiscard]] constexpr bool intersect(const Vector3& origin, const Vector3& inv_direction, const float max_t, float& t) const {
+			const Vector3 t0 = (min - origin) * inv_direction;
+			const Vector3 t1 = (max - origin) * inv_direction;
+			const Vector3 near = Vector3::Min(t0, t1);
+			const Vector3 far = Vector3::Max(t0, t1);
+			const float enter = Math::Max(Math::Max(near.x, near.y), Math::Max(near.z, 0.0f));
+			const float exit = Math::Min(Math::Min(far.x, far.y), Math::Min(far.z, max_t));
+			t = enter;
+			return enter <= exit;
+		}
+
+		[[nodiscard]] constexpr AABB expanded(const float margin) const {
+			return AABB { min - Vector3 { margin, margin, margin }, max + Vector3 { margin, margin, margin } };
+		}
+		[[nodiscard]] constexpr FRect to_rect() const { return FRect { min.x, min.y, max.x - min.x, max.y - min.y }; }
+
+		[[nodiscard]] static constexpr AABB Merge(const AABB& a, const AABB& b) {
+			return AABB { Vector3::Min(a.min, b.min), Vector3::Max(a.max, b.max) };
+		}
+		[[nodiscard]] static constexpr AABB FromCenter(const Vector3& center, const Vector3& half_extents) {
+			return AABB { center - half_extents, center + half_extents };
+		}
+		// Bounds of a 2D rectangle on the XY plane, with the given depth range
+		[[nodiscard]] static constexpr AABB FromRect(const FRect& rect, const float min_z = 0.0f, const float max_z = 0.0f) {
+			return AABB { { rect.origin.x, rect.origin.y, min_z }, { rect.origin.x + rect.size.width, rect.origin.y + rect.size.height, max_z } };
+		}
+		// Merging anything into the empty box yields that thing
+		[[nodiscard]] static constexpr AABB Empty() {
+			constexpr float inf = std::numeric_limits<float>::infinity();
+			return AABB { { inf, inf, inf }, { -inf, -inf, -inf } };
+		}
+	};
+
+	struct SpatialItem {
+		AABB bounds;
+		uint64_t user_data;
+	};
+
+	namespace Spatial {
+		enum class Containment {
+			Outside,
+			Intersecting,
+			Inside
+		};
+
+		static constexpr int32_t Null = -1;
+		// Deepest traversal the queries support, far beyond the height of a balanced tree
+		static constexpr size_t MaxStackDepth = 128;
+
+		// Zero components map to the largest float instead of infinity, so the slab test never computes 0 * inf
+		[[nodiscard]] constexpr Vector3 InverseDirection(const Vector3& direction) {
+			constexpr float huge = std::numeric_limits<float>::max();
+			return Vector3 {
+				direction.x != 0.0f ? 1.0f / direction.x : huge,
+				direction.y != 0.0f ? 1.0f / direction.y : huge,
+				direction.z != 0.0f ? 1.0f / direction.z : huge
+			};
+		}
+	}
+
+	// Dynamic bounding volume tree. Leaves store bounds fattened by a margin, so objects that move a little
+	// do not touch the tree, queries therefore report candidates whose fattened bounds pass the test.
+	// Proxy ids are node indices and stay valid until the proxy is removed, including across rebuild().
+	class AABBTree {
+		struct Node {
+			AABB bounds;
+			uint64_t user_data;
+			int32_t parent; // Next free node while on the free list
+			int32_t left;
+			int32_t right;
+			int32_t height; // 0 for leaves, -1 for free nodes
+
+			[[nodiscard]] constexpr bool is_leaf() const { return left == Spatial::Null; }
+		};
+
+		std::vector<Node> m_nodes;
+		int32_t m_iRoot;
+		int32_t m_iFreeList;
+		size_t m_uLeafCount;
+		float m_fMargin;
+
+		int32_t allocate_node();
+		void free_node(int32_t node);
+		void insert_leaf(int32_t leaf);
+		void remove_leaf(int32_t leaf);
+		void refit(int32_t node);
+		int32_t balance(int32_t node);
+		void build(std::span<int32_t> leaves);
+		int32_t build_range(std::span<int32_t> leaves, std::span<const int32_t> slots, int32_t parent);
+	public:
+		explicit AABBTree(float margin = 0.1f);
+
+		int32_t insert(const AABB& bounds, uint64_t user_data);
+		void remove(int32_t proxy);
+		// Returns true if the proxy had to be reinserted, displacement extends the fattened bounds in the direction of travel
+		bool move(int32_t proxy, const AABB& bounds, const Vector3& displacement = Vector3 { });
+		void clear();
+
+		// Replaces the contents, the returned proxies are in the order of items
+		std::vector<int32_t> rebuild(std::span<const SpatialItem> items);
+		// Rebuilds the hierarchy of the current leaves top-down, proxy ids are kept
+		void rebuild();
+
+		// fn(proxy) returns false to stop the query
+		template<typename Fn>
+		void query(const AABB& bounds, Fn&& fn) const {
+			traverse([&](const Node& node) { return node.bounds.overlaps(bounds); }, fn);
+		}
+		template<typename Fn>
+		void query(const Vector3& center, const float radius, Fn&& fn) const {
+			traverse([&](const Node& node) { return node.bounds.overlaps(center, radius); }, fn);
+		}
+		// classify(bounds) returns a Spatial::Containment, every leaf below an Inside node is reported without further tests.
+		// fn(proxy) returns false to stop the query.
+		template<typename Classify, typename Fn>
+		void query_hierarchical(Classify&& classify, Fn&& fn) const {
+			if (m_iRoot == Spatial::Null) {
+				return;
+			}
+			// Nodes of accepted subtrees are pushed bitwise negated
+			std::array<int32_t, Spatial::MaxStackDepth> stack;
+			size_t top = 0;
+			stack[top++] = m_iRoot;
+			while (top > 0) {
+				const int32_t entry = stack[--top];
+				bool inside = entry < 0;
+				const int32_t index = inside ? ~entry : entry;
+				const Node& node = m_nodes[index];
+				if (!inside) {
+					const Spatial::Containment containment = classify(node.bounds);
+					if (containment == Spatial::Containment::Outside) {
+						continue;
+					}
+					inside = containment == Spatial::Containment::Inside;
+				}
+				if (node.is_leaf()) {
+					if (!fn(index)) {
+						return;
+					}
+				} else {
+					Assert(top + 2 <= stack.size(), "AABBTree is too deep to traverse");
+					stack[top++] = inside ? ~node.left : node.left;
+					stack[top++] = inside ? ~node.right : node.right;
+				}
+			}
+		}
+		// fn(proxy, t) returns the new maximum distance, 0 stops the cast and max_t leaves it unchanged
+		template<typename Fn>
+		void raycast(const Ray& ray, float max_t, Fn&& fn) const {
+			if (m_iRoot == Spatial::Null) {
+				return;
+			}
+			const Vector3 inv_direction = Spatial::InverseDirection(ray.direction);
+			std::array<int32_t, Spatial::MaxStackDepth> stack;
+			size_t top = 0;
+			stack[top++] = m_iRoot;
+			while (top > 0) {
+				const Node& node = m_nodes[stack[--top]];
+				float t;
+				if (!node.bounds.intersect(ray.origin, inv_direction, max_t, t)) {
+					continue;
+				}
+				if (node.is_leaf()) {
+					max_t = fn(static_cast<int32_t>(&node - m_nodes.data()), t);
+					if (max_t <= 0.0f) {
+						return;
+					}
+				} else {
+					Assert(top + 2 <= stack.size(), "AABBTree is too deep to traverse");
+					stack[top++] = node.left;
+					stack[top++] = node.right;
+				}
+			}
+		}
+
+		[[nodiscard]] inline const AABB& fat_bounds(const int32_t proxy) const { return m_nodes[proxy].bounds; }
+		[[nodiscard]] inline uint64_t user_data(const int32_t proxy) const { return m_nodes[proxy].user_data; }
+		[[nodiscard]] inline int32_t height() const { return m_iRoot != Spatial::Null ? m_nodes[m_iRoot].height : 0; }
+		[[nodiscard]] constexpr size_t size() const { return m_uLeafCount; }
+		[[nodiscard]] constexpr float margin() const { return m_fMargin; }
+	private:
+		template<typename Test, typename Fn>
+		void traverse(Test&& test, Fn&& fn) const {
+			if (m_iRoot == Spatial::Null) {
+				return;
+			}
+			std::array<int32_t, Spatial::MaxStackDepth> stack;
+			size_t top = 0;
+			stack[top++] = m_iRoot;
+			while (top > 0) {
+				const int32_t index = stack[--top];
+				const Node& node = m_nodes[index];
+				if (!test(node)) {
+					continue;
+				}
+				if (node.is_leaf()) {
+					if (!fn(index)) {
+						return;
+					}
+				} else {
+					Assert(top + 2 <= stack.size(), "AABBTree is too deep to traverse");
+					stack[top++] = node.left;
+					stack[top++] = node.right;
+				}
+			}
+		}
+	};
+
+	// Uniform grid over the XZ plane. Items live in the cell holding their center and each cell keeps the union
+	// of its items' bounds, so queries only widen their cell range by the largest half extent inserted.
+	// Items outside the grid bounds are kept in the nearest edge cell. Queries test the exact bounds.
+	class LooseGrid {
+		struct Entry {
+			AABB bounds;
+			int32_t proxy;
+		};
+		struct Cell {
+			AABB bounds;
+			std::vector<Entry> entries;
+		};
+		struct Handle {
+			uint64_t user_data;
+			int32_t cell; // Null while on the free list
+			int32_t slot; // Next free handle while on the free list
+		};
+
+		std::vector<Cell> m_cells;
+		std::vector<Handle> m_handles;
+		int32_t m_iFreeList;
+		size_t m_uCount;
+		Vector3 m_origin;
+		float m_fCellSize;
+		float m_fInvCellSize;
+		int32_t m_iWidth;
+		int32_t m_iDepth;
+		float m_fMaxExtent;
+
+		[[nodiscard]] int32_t cell_x(float x) const;
+		[[nodiscard]] int32_t cell_z(float z) const;
+		[[nodiscard]] inline int32_t cell_of(const AABB& bounds) const {
+			const Vector3 c = bounds.center();
+			return cell_z(c.z) * m_iWidth + cell_x(c.x);
+		}
+		void place(int32_t proxy, const AABB& bounds);
+		void unplace(int32_t proxy);
+	public:
+		LooseGrid(const AABB& bounds, float cell_size);
+
+		int32_t insert(const AABB& bounds, uint64_t user_data);
+		void remove(int32_t proxy);
+		void move(int32_t proxy, const AABB& bounds);
+		void clear();
+
+		// Replaces the contents, the returned proxies are in the order of items
+		std::vector<int32_t> rebuild(std::span<const SpatialItem> items);
+		// Tightens the cell bounds and the query margin after many moves and removals
+		void rebuild();
+
+		// fn(proxy) returns false to stop the query
+		template<typename Fn>
+		void query(const AABB& bounds, Fn&& fn) const {
+			visit(bounds, [&](const AABB& cell_bounds) { return cell_bounds.overlaps(bounds); },
+				[&](const Entry& entry) { return !entry.bounds.overlaps(bounds) || fn(entry.proxy); });
+		}
+		template<typename Fn>
+		void query(const Vector3& center, const float radius, Fn&& fn) const {
+			const AABB bounds = AABB { center, center }.expanded(radius);
+			visit(bounds, [&](const AABB& cell_bounds) { return cell_bounds.overlaps(center, radius); },
+				[&](const Entry& entry) { return !entry.bounds.overlaps(center, radius) || fn(entry.proxy); });
+		}
+		// fn(proxy, t) returns the new maximum distance, 0 stops the cast and max_t leaves it unchanged.
+		// The visited cells are those under the bounds of the whole segment, prefer AABBTree for long rays.
+		template<typename Fn>
+		void raycast(const Ray& ray, float max_t, Fn&& fn) const {
+			const Vector3 inv_direction = Spatial::InverseDirection(ray.direction);
+			const Vector3 end = ray.origin + ray.direction * max_t;
+			const AABB segment = { Vector3::Min(ray.origin, end), Vector3::Max(ray.origin, end) };
+			visit(segment, [&](const AABB& cell_bounds) {
+				float t;
+				return max_t > 0.0f && cell_bounds.intersect(ray.origin, inv_direction, max_t, t);
+			}, [&](const Entry& entry) {
+				float t;
+				if (max_t > 0.0f && entry.bounds.intersect(ray.origin, inv_direction, max_t, t)) {
+					max_t = fn(entry.proxy, t);
+				}
+				return max_t > 0.0f;
+			});
+		}
+
+		[[nodiscard]] const AABB& bounds(int32_t proxy) const;
+		[[nodiscard]] inline uint64_t user_data(const int32_t proxy) const { return m_handles[proxy].user_data; }
+		[[nodiscard]] constexpr size_t size() const { return m_uCount; }
+		[[nodiscard]] constexpr float cell_size() const { return m_fCellSize; }
+	private:
+		template<typename CellTest, typename EntryFn>
+		void visit(const AABB& bounds, CellTest&& cell_test, EntryFn&& entry_fn) const {
+			if (m_uCount == 0) {
+				return;
+			}
+			const int32_t x0 = cell_x(bounds.min.x - m_fMaxExtent), x1 = cell_x(bounds.max.x + m_fMaxExtent);
+			const int32_t z0 = cell_z(bounds.min.z - m_fMaxExtent), z1 = cell_z(bounds.max.z + m_fMaxExtent);
+			for (int32_t z = z0; z <= z1; z++) {
+				for (int32_t x = x0; x <= x1; x++) {
+					const Cell& cell = m_cells[z * m_iWidth + x];
+					if (cell.entries.empty() || !cell_test(cell.bounds)) {
+						continue;
+					}
+					for (const Entry& entry : cell.entries) {
+						if (!entry_fn(entry)) {
+							return;
+						}
+					}
+				}
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -48,6 +48,17 @@ namespace gctk::StringUtil {
 		}
 		return result;
 	}
+	std::pmr::vector<std::string_view> Split(const std::string_view str, const char delimiter, std::pmr::memory_resource* resource) {
+		// Same tokens as the std::getline based overload: empty ones between delimiters, none after a trailing one
+		std::pmr::vector<std::string_view> result(resource);
+		size_t begin = 0;
+		while (begin < str.size()) {
+			const size_t end = std::min(str.find(delimiter, begin), str.size());
+			result.push_back(str.substr(begin, end - begin));
+			begin = end + 1;
+		}
+		return result;
+	}
 	std::vector<std::string> SplitLines(const std::string& str) {
 		std::vector<std::string> result;
 		std::istringstream iss(str);
@@ -87,6 +98,15 @@ namespace gctk::StringUtil {
 		return strcmp(lhs.c_str(), rhs.c_str()) == 0;
 	}
 
+	uint64_t Hash(const std::string_view str, const uint64_t seed) {
+		uint64_t hash = seed;
+		for (const auto c : str) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
 	bool ParseBool(const std::string& str, bool& out) {
 		const auto str_lc = ToLower(str);
 		if (str_lc == "true" || str_lc == "on" || str_lc == "yes") {
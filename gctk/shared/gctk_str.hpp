@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "gctk_math.hpp"
@@ -13,6 +15,8 @@ namespace gctk::StringUtil {
 	std::string TrimEnd(const std::string& str, const std::string& chars = " \t\n\r");
 	std::string Trim(const std::string& str, const std::string& chars = " \t\n\r");
 	std::vector<std::string> Split(const std::string& str, char delimiter);
+	// Views into str, the list itself is allocated from resource, e.g. a ScratchScope
+	std::pmr::vector<std::string_view> Split(std::string_view str, char delimiter, std::pmr::memory_resource* resource);
 	std::vector<std::string> SplitLines(const std::string& str);
 	std::string Join(const std::vector<std::string>& strings, char delimiter);
 	std::string Join(const std::vector<std::string>& strings, const std::string& delimiter);
@@ -20,6 +24,9 @@ namespace gctk::StringUtil {
 	bool EqualsNoCase(const std::string& lhs, const std::string& rhs);
 	bool Equals(const std::string& lhs, const std::string& rhs);
 
+	// FNV-1a, pass the previous result as seed to hash several strings together
+	uint64_t Hash(std::string_view str, uint64_t seed = 14695981039346656037ull);
+
 	bool ParseBool(const std::string& str, bool& out);
 	template<IntegerType T>
 	bool ParseInt(const std::string& str, T& out, uint8_t base = 10) {
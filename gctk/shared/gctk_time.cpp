@@ -1,18 +1,102 @@
 #include "gctk_time.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "gctk_cvar.hpp"
+#include "gctk_str.hpp"
+
 namespace gctk {
+	static bool ValidatePositiveOrZero(const CVar* self, const std::string& value);
+
+	CVar sys_tickrate("sys_tickrate", "60", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+	CVar sys_maxfps("sys_maxfps", "0", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+	CVar sys_maxticks("sys_maxticks", "5", CVAR_FLAG_USER_DATA, &ValidatePositiveOrZero);
+
+	static const auto s_time_origin = std::chrono::steady_clock::now();
+
 	double Time::m_dTimePrevious = 0.0;
 	double Time::m_dDeltaTime = 0.0;
+	double Time::m_dInterpolationAlpha = 0.0;
+	double Time::m_dTickDeltaTime = 0.0;
 
 	double Time::CurrentTime() {
-		return glfwGetTime();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - s_time_origin).count();
 	}
 
 	void Time::Initialize() {
 		m_dTimePrevious = CurrentTime();
 	}
 	void Time::UpdateDeltaTime() {
-		m_dDeltaTime = CurrentTime() - m_dTimePrevious;
+		const auto now = CurrentTime();
+		m_dDeltaTime = now - m_dTimePrevious;
+		m_dTimePrevious = now;
+	}
+
+	void Time::SetInterpolationAlpha(const double alpha) {
+		m_dInterpolationAlpha = alpha;
+	}
+	FrameTiming Time::GetFrameTiming() {
+		const FrameTiming timing {
+			sys_tickrate.get_float(),
+			sys_maxfps.get_float(),
+			static_cast<uint32_t>(std::max(sys_maxticks.get_integer(), 1))
+		};
+		// Latched so the tick length never disagrees with the scheduler running the ticks
+		m_dTickDeltaTime = timing.tick_rate > 0.0 ? 1.0 / timing.tick_rate : 0.0;
+		return timing;
+	}
+
+	FrameScheduler::FrameScheduler(const FrameTiming& timing) :
+		m_dTickInterval(timing.tick_rate > 0.0 ? 1.0 / timing.tick_rate : 0.0),
+		m_dFrameInterval(timing.max_frame_rate > 0.0 ? 1.0 / timing.max_frame_rate : 0.0),
+		m_dAccumulator(0.0), m_dFrameStart(Time::CurrentTime()),
+		m_uMaxTicksPerFrame(std::max(timing.max_ticks_per_frame, 1u)), m_uDroppedTicks(0) {
 	}
 
+	uint32_t FrameScheduler::begin_frame() {
+		const auto now = Time::CurrentTime();
+		const auto elapsed = now - m_dFrameStart;
+		m_dFrameStart = now;
+
+		if (m_dTickInterval <= 0.0) {
+			return 1;
+		}
+
+		m_dAccumulator += elapsed;
+		auto ticks = static_cast<uint64_t>(m_dAccumulator / m_dTickInterval);
+		if (ticks > m_uMaxTicksPerFrame) {
+			// Simulation can't keep up, drop the backlog instead of falling further behind every frame
+			m_uDroppedTicks += ticks - m_uMaxTicksPerFrame;
+			ticks = m_uMaxTicksPerFrame;
+			m_dAccumulator = static_cast<double>(ticks) * m_dTickInterval;
+		}
+		m_dAccumulator -= static_cast<double>(ticks) * m_dTickInterval;
+		return static_cast<uint32_t>(ticks);
+	}
+	void FrameScheduler::end_frame() {
+		if (m_dFrameInterval <= 0.0) {
+			return;
+		}
+
+		// Sleep is only accurate to a few milliseconds, the rest is spent yielding
+		const auto target = m_dFrameStart + m_dFrameInterval;
+		if (const auto remaining = target - Time::CurrentTime(); remaining > 0.002) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.002));
+		}
+		while (Time::CurrentTime() < target) {
+			std::this_thread::yield();
+		}
+	}
+
+	double FrameScheduler::alpha() const {
+		return m_dTickInterval > 0.0 ? m_dAccumulator / m_dTickInterval : 0.0;
+	}
+
+	static bool ValidatePositiveOrZero(const CVar* self, const std::string& value) {
+		(void)self;
+		float number;
+		return StringUtil::ParseFloat(value, number) && number >= 0.0f;
+	}
 }
\ No newline at end of file
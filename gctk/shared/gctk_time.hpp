@@ -1,15 +1,52 @@
 #pragma once
-#include <GLFW/glfw3.h>
+
+#include <cstdint>
 
 namespace gctk {
+	struct FrameTiming {
+		double tick_rate;
+		double max_frame_rate;
+		uint32_t max_ticks_per_frame;
+	};
+
 	class Time {
 		static double m_dTimePrevious;
 		static double m_dDeltaTime;
+		static double m_dInterpolationAlpha;
+		static double m_dTickDeltaTime;
 	public:
 		static double CurrentTime();
 		constexpr static double DeltaTime() { return m_dDeltaTime; }
 
 		static void Initialize();
 		static void UpdateDeltaTime();
+
+		// Fixed simulation step of the timing last returned by GetFrameTiming, 0 when ticks run once per rendered frame
+		constexpr static double TickDeltaTime() { return m_dTickDeltaTime; }
+		// How far rendering is between the last two simulation ticks, in the [0, 1) range
+		constexpr static double InterpolationAlpha() { return m_dInterpolationAlpha; }
+		static void SetInterpolationAlpha(double alpha);
+		// The launcher reads this once when it sets up its scheduler, later sys_tickrate changes apply after a restart
+		static FrameTiming GetFrameTiming();
+	};
+
+	class FrameScheduler {
+		double m_dTickInterval;
+		double m_dFrameInterval;
+		double m_dAccumulator;
+		double m_dFrameStart;
+		uint32_t m_uMaxTicksPerFrame;
+		uint64_t m_uDroppedTicks;
+	public:
+		explicit FrameScheduler(const FrameTiming& timing);
+
+		// Returns the number of simulation ticks to run before rendering this frame
+		uint32_t begin_frame();
+		// Sleeps until the next frame is due when the frame rate is capped
+		void end_frame();
+
+		[[nodiscard]] double alpha() const;
+		[[nodiscard]] constexpr double tick_interval() const { return m_dTickInterval; }
+		[[nodiscard]] constexpr uint64_t dropped_ticks() const { return m_uDroppedTicks; }
 	};
 }
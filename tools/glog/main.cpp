@@ -0,0 +1,174 @@
+#include <print>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+#include <filesystem>
+
+#include "gctk_log_format.hpp"
+
+#ifdef _WIN32
+#define strcasecmp stricmp
+#endif
+
+#define GLOG_VERSION_MAJOR 0
+#define GLOG_VERSION_MINOR 1
+
+using namespace gctk;
+
+static constexpr std::string_view LevelNames[] = {
+	"INFO",
+	"WARN",
+	"ERROR"
+};
+
+struct Site {
+	uint8_t level;
+	uint64_t line;
+	std::string file;
+	std::string format;
+};
+
+// Writes the records in the same layout as the text log
+static bool DecodeLog(const std::filesystem::path& input_path, std::FILE* output) {
+	std::ifstream ifs(input_path, std::ios::binary);
+	if (!ifs.is_open()) {
+		std::println("Failed to open \"{}\"", input_path.string());
+		return false;
+	}
+	const std::string data { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+
+	BinaryLog::Header header { };
+	if (data.size() < sizeof(header)) {
+		std::println("\"{}\" is too small to be a binary log", input_path.string());
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.identifier, BinaryLog::Identifier, 4) != 0) {
+		std::println("\"{}\" is not a binary log", input_path.string());
+		return false;
+	}
+	// Every version only adds argument types, older logs decode the same way
+	if (header.version == 0 || header.version > BinaryLog::Version) {
+		std::println("Unsupported binary log version {}, expected {} or older", header.version, BinaryLog::Version);
+		return false;
+	}
+	const std::string_view side = (header.flags & BinaryLog::FlagServer) != 0 ? "SERVER" : "CLIENT";
+
+	std::vector<Site> sites;
+	std::vector<BinaryLog::Value> args;
+	int64_t time = header.start_time;
+	size_t message_count = 0;
+	std::string_view in = std::string_view(data).substr(sizeof(header));
+	while (!in.empty()) {
+		const auto type = static_cast<BinaryLog::RecordType>(in.front());
+		const std::string_view record_start = in;
+		in.remove_prefix(1);
+
+		uint64_t index, value;
+		if (type == BinaryLog::RecordType::Site) {
+			Site site;
+			std::string_view file, format;
+			if (!BinaryLog::ReadVarint(in, index) || in.empty()) {
+				in = record_start;
+				break;
+			}
+			site.level = static_cast<uint8_t>(in.front());
+			in.remove_prefix(1);
+			if (!BinaryLog::ReadVarint(in, site.line) || !BinaryLog::ReadString(in, file) || !BinaryLog::ReadString(in, format)) {
+				in = record_start;
+				break;
+			}
+			site.file = file;
+			site.format = format;
+			if (index >= sites.size()) {
+				sites.resize(index + 1);
+			}
+			sites[index] = std::move(site);
+		} else if (type == BinaryLog::RecordType::Message) {
+			args.clear();
+			if (!BinaryLog::ReadVarint(in, index) || !BinaryLog::ReadVarint(in, value) || !BinaryLog::UnpackArgs(in, args)) {
+				in = record_start;
+				break;
+			}
+			if (index >= sites.size()) {
+				std::println("Message refers to unknown site {}", index);
+				return false;
+			}
+			time += BinaryLog::UnZigZag(value);
+
+			const Site& site = sites[index];
+			const std::chrono::sys_time<std::chrono::microseconds> time_stamp { std::chrono::microseconds(time) };
+			std::println(output, "{} - {:%Y.%m.%d %H:%M:%S} [{}] \"{}\":{} {}",
+				side, time_stamp, site.level < std::size(LevelNames) ? LevelNames[site.level] : "?",
+				site.file, site.line, BinaryLog::FormatArgs(site.format, args)
+			);
+			message_count++;
+		} else {
+			std::println("Unknown record type {} after {} messages", static_cast<int>(type), message_count);
+			return false;
+		}
+	}
+	// The engine may have been killed in the middle of a write
+	if (!in.empty()) {
+		std::println("Log is truncated after {} messages", message_count);
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "--help") == 0 || strcasecmp(argv[1], "-h") == 0) {
+			std::println("GLog v{}.{}", GLOG_VERSION_MAJOR, GLOG_VERSION_MINOR);
+			std::println(
+				"Usage:\n"
+				"glog --help|-h    ==> Show help message\n"
+				"glog --version|-v ==> Show tool version\n"
+				"glog --input <path> [--output <path>] ==> Decode a .glog file written with log_binary, prints to stdout without --output"
+			);
+			return 0;
+		}
+		if (strcasecmp(argv[1], "--version") == 0 || strcasecmp(argv[1], "-v") == 0) {
+			std::println("GLog v{}.{}", GLOG_VERSION_MAJOR, GLOG_VERSION_MINOR);
+			return 0;
+		}
+	}
+	if (argc != 3 && argc != 5) {
+		std::println("Expected --input <path> [--output <path>], see --help");
+		return 1;
+	}
+
+	std::filesystem::path input_path;
+	std::filesystem::path output_path;
+	for (int i = 1; i < argc; i += 2) {
+		if (strcasecmp(argv[i], "--input") == 0 || strcasecmp(argv[i], "-i") == 0) {
+			input_path = argv[i + 1];
+		} else if (strcasecmp(argv[i], "--output") == 0 || strcasecmp(argv[i], "-o") == 0) {
+			output_path = argv[i + 1];
+		} else {
+			std::println("Invalid argument: {}", argv[i]);
+			return 1;
+		}
+	}
+	if (input_path.empty()) {
+		std::println("Input path is required");
+		return 1;
+	}
+
+	std::FILE* output = stdout;
+	if (!output_path.empty()) {
+		output = std::fopen(output_path.string().c_str(), "w");
+		if (output == nullptr) {
+			std::println("Failed to open \"{}\" for writing", output_path.string());
+			return 1;
+		}
+	}
+	const bool result = DecodeLog(input_path, output);
+	if (output != stdout) {
+		std::fclose(output);
+	}
+	return result ? 0 : 1;
+}
\ No newline at end of file
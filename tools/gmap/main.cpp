@@ -0,0 +1,162 @@
+#include <print>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include "gctk_map_format.hpp"
+
+#ifdef _WIN32
+#define strcasecmp stricmp
+#endif
+
+#define GMAP_VERSION_MAJOR 0
+#define GMAP_VERSION_MINOR 1
+
+using namespace gctk;
+
+struct SourceChunk {
+	int32_t x, z;
+	std::filesystem::path path;
+};
+
+static uint32_t Align16(const uint32_t value) {
+	return (value + 15) & ~15u;
+}
+
+// Chunk files are named "<x>_<z>.chunk", their contents are copied into the map as they are
+static bool ParseChunkName(const std::filesystem::path& path, int32_t& x, int32_t& z) {
+	if (path.extension() != ".chunk") {
+		return false;
+	}
+	const auto stem = path.stem().string();
+	const auto separator = stem.find('_', 1);
+	if (separator == std::string::npos) {
+		return false;
+	}
+	try {
+		size_t used_x, used_z;
+		x = std::stoi(stem.substr(0, separator), &used_x);
+		z = std::stoi(stem.substr(separator + 1), &used_z);
+		return used_x == separator && used_z == stem.size() - separator - 1;
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+static bool WriteMap(const std::filesystem::path& output_path, std::vector<SourceChunk>& chunks, const float chunk_size) {
+	std::ranges::sort(chunks, { }, [](const SourceChunk& chunk) { return MapFormat::ChunkKey(chunk.x, chunk.z); });
+
+	MapFormat::Header header { };
+	memcpy(header.identifier, MapFormat::Identifier, 4);
+	header.version = MapFormat::Version;
+	header.chunk_size = chunk_size;
+	header.chunk_count = static_cast<uint32_t>(chunks.size());
+	header.min_x = header.max_x = chunks.front().x;
+	header.min_z = header.max_z = chunks.front().z;
+	for (const auto& chunk : chunks) {
+		header.min_x = std::min(header.min_x, chunk.x);
+		header.min_z = std::min(header.min_z, chunk.z);
+		header.max_x = std::max(header.max_x, chunk.x);
+		header.max_z = std::max(header.max_z, chunk.z);
+	}
+	header.index_offset = Align16(sizeof(MapFormat::Header));
+	header.data_offset = Align16(header.index_offset + header.chunk_count * sizeof(MapFormat::ChunkRecord));
+
+	std::vector<MapFormat::ChunkRecord> index;
+	std::vector<uint8_t> data;
+	index.reserve(chunks.size());
+	for (const auto& chunk : chunks) {
+		std::ifstream ifs(chunk.path, std::ios::binary | std::ios::ate);
+		if (!ifs.is_open()) {
+			std::println("Failed to open chunk \"{}\"", chunk.path.string());
+			return false;
+		}
+		const auto size = static_cast<uint32_t>(ifs.tellg());
+		ifs.seekg(0, std::ios::beg);
+
+		const auto offset = Align16(static_cast<uint32_t>(data.size()));
+		data.resize(offset + size);
+		ifs.read(reinterpret_cast<char*>(data.data() + offset), size);
+		index.push_back({ chunk.x, chunk.z, header.data_offset + offset, size });
+	}
+
+	std::ofstream ofs(output_path, std::ios::binary);
+	if (!ofs.is_open()) {
+		std::println("Failed to open \"{}\" for writing", output_path.string());
+		return false;
+	}
+	std::vector<uint8_t> file(header.data_offset + data.size());
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + header.index_offset, index.data(), index.size() * sizeof(MapFormat::ChunkRecord));
+	memcpy(file.data() + header.data_offset, data.data(), data.size());
+	ofs.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+
+	std::println("Wrote {} chunks ({}, {} .. {}, {}), {} bytes", chunks.size(), header.min_x, header.min_z, header.max_x, header.max_z, file.size());
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "--help") == 0 || strcasecmp(argv[1], "-h") == 0) {
+			std::println("GMap v{}.{}", GMAP_VERSION_MAJOR, GMAP_VERSION_MINOR);
+			std::println(
+				"Usage:\n"
+				"gmap --help|-h    ==> Show help message\n"
+				"gmap --version|-v ==> Show tool version\n"
+				"gmap --input <path> --output <path> [--chunk-size <size>] ==> Build a .gmap from a directory of <x>_<z>.chunk files"
+			);
+			return 0;
+		}
+		if (strcasecmp(argv[1], "--version") == 0 || strcasecmp(argv[1], "-v") == 0) {
+			std::println("GMap v{}.{}", GMAP_VERSION_MAJOR, GMAP_VERSION_MINOR);
+			return 0;
+		}
+	}
+	if (argc != 5 && argc != 7) {
+		std::println("Expected --input <path> --output <path> [--chunk-size <size>], see --help");
+		return 1;
+	}
+
+	std::filesystem::path input_path;
+	std::filesystem::path output_path;
+	float chunk_size = 64.0f;
+	for (int i = 1; i < argc; i += 2) {
+		if (strcasecmp(argv[i], "--input") == 0 || strcasecmp(argv[i], "-i") == 0) {
+			input_path = argv[i + 1];
+		} else if (strcasecmp(argv[i], "--output") == 0 || strcasecmp(argv[i], "-o") == 0) {
+			output_path = argv[i + 1];
+		} else if (strcasecmp(argv[i], "--chunk-size") == 0 || strcasecmp(argv[i], "-c") == 0) {
+			chunk_size = std::strtof(argv[i + 1], nullptr);
+		} else {
+			std::println("Invalid argument: {}", argv[i]);
+			return 1;
+		}
+	}
+	if (input_path.empty() || output_path.empty()) {
+		std::println("Both input and output paths are required");
+		return 1;
+	}
+	if (chunk_size <= 0.0f) {
+		std::println("Chunk size must be greater than zero");
+		return 1;
+	}
+
+	std::vector<SourceChunk> chunks;
+	for (const auto& entry : std::filesystem::directory_iterator(input_path)) {
+		SourceChunk chunk;
+		if (!entry.is_regular_file() || !ParseChunkName(entry.path(), chunk.x, chunk.z)) {
+			continue;
+		}
+		chunk.path = entry.path();
+		chunks.emplace_back(std::move(chunk));
+	}
+	if (chunks.empty()) {
+		std::println("No chunk files found in \"{}\"", input_path.string());
+		return 1;
+	}
+
+	return WriteMap(output_path, chunks, chunk_size) ? 0 : 1;
+}
\ No newline at end of file
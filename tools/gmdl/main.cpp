@@ -0,0 +1,526 @@
+#include <cmath>
+#include <print>
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gctk_mesh_format.hpp"
+
+#ifdef _WIN32
+#define strcasecmp stricmp
+#endif
+
+#define GMDL_VERSION_MAJOR 0
+#define GMDL_VERSION_MINOR 1
+
+using namespace gctk;
+
+struct SourceVertex {
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+struct SourceMesh {
+	std::vector<SourceVertex> vertices;
+	std::vector<uint32_t> indices;
+};
+
+struct VertexKey {
+	int position, uv, normal;
+	bool operator==(const VertexKey& other) const = default;
+};
+struct VertexKeyHash {
+	size_t operator()(const VertexKey& key) const {
+		return std::hash<int64_t>()((static_cast<int64_t>(key.position) << 40) ^ (static_cast<int64_t>(key.uv) << 20) ^ key.normal);
+	}
+};
+
+static int ResolveObjIndex(const std::string& value, const size_t count) {
+	if (value.empty()) {
+		return -1;
+	}
+	const int index = std::stoi(value);
+	return index < 0 ? static_cast<int>(count) + index : index - 1;
+}
+
+static bool LoadObj(const std::filesystem::path& path, SourceMesh& mesh) {
+	std::ifstream ifs(path);
+	if (!ifs.is_open()) {
+		std::println("Failed to open input file \"{}\"", path.string());
+		return false;
+	}
+
+	std::vector<std::array<float, 3>> positions;
+	std::vector<std::array<float, 3>> normals;
+	std::vector<std::array<float, 2>> uvs;
+	std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertex_lookup;
+	std::vector<int> vertex_positions;
+
+	std::string line;
+	size_t line_number = 0;
+	while (std::getline(ifs, line)) {
+		++line_number;
+		std::istringstream ss(line);
+		std::string type;
+		ss >> type;
+		if (type == "v") {
+			auto& p = positions.emplace_back();
+			ss >> p[0] >> p[1] >> p[2];
+		} else if (type == "vn") {
+			auto& n = normals.emplace_back();
+			ss >> n[0] >> n[1] >> n[2];
+		} else if (type == "vt") {
+			auto& t = uvs.emplace_back();
+			ss >> t[0] >> t[1];
+		} else if (type == "f") {
+			std::vector<uint32_t> face;
+			std::string token;
+			while (ss >> token) {
+				VertexKey key { -1, -1, -1 };
+				const size_t first = token.find('/');
+				const size_t second = first == std::string::npos ? std::string::npos : token.find('/', first + 1);
+				try {
+					key.position = ResolveObjIndex(token.substr(0, first), positions.size());
+					if (first != std::string::npos) {
+						key.uv = ResolveObjIndex(token.substr(first + 1, second - first - 1), uvs.size());
+					}
+					if (second != std::string::npos) {
+						key.normal = ResolveObjIndex(token.substr(second + 1), normals.size());
+					}
+				} catch (const std::exception&) {
+					std::println("Invalid face index \"{}\" at line {}", token, line_number);
+					return false;
+				}
+				if (key.position < 0 || key.position >= static_cast<int>(positions.size()) ||
+					key.uv >= static_cast<int>(uvs.size()) || key.normal >= static_cast<int>(normals.size())) {
+					std::println("Face index out of range at line {}", line_number);
+					return false;
+				}
+
+				auto it = vertex_lookup.find(key);
+				if (it == vertex_lookup.end()) {
+					SourceVertex vertex { };
+					memcpy(vertex.position, positions[key.position].data(), sizeof(vertex.position));
+					if (key.normal >= 0) {
+						memcpy(vertex.normal, normals[key.normal].data(), sizeof(vertex.normal));
+					}
+					if (key.uv >= 0) {
+						memcpy(vertex.uv, uvs[key.uv].data(), sizeof(vertex.uv));
+					}
+					it = vertex_lookup.emplace(key, static_cast<uint32_t>(mesh.vertices.size())).first;
+					mesh.vertices.push_back(vertex);
+					vertex_positions.push_back(key.position);
+				}
+				face.push_back(it->second);
+			}
+			// Triangulate polygons as a fan
+			for (size_t i = 2; i < face.size(); ++i) {
+				mesh.indices.push_back(face[0]);
+				mesh.indices.push_back(face[i - 1]);
+				mesh.indices.push_back(face[i]);
+			}
+		}
+	}
+
+	if (mesh.indices.empty()) {
+		std::println("Input file \"{}\" contains no faces", path.string());
+		return false;
+	}
+
+	// Generate smooth normals, shared between vertices with the same position
+	if (normals.empty()) {
+		std::vector<std::array<float, 3>> accumulated(positions.size(), { 0.0f, 0.0f, 0.0f });
+		for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+			const float* a = mesh.vertices[mesh.indices[i]].position;
+			const float* b = mesh.vertices[mesh.indices[i + 1]].position;
+			const float* c = mesh.vertices[mesh.indices[i + 2]].position;
+			const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			for (size_t j = 0; j < 3; ++j) {
+				auto& target = accumulated[vertex_positions[mesh.indices[i + j]]];
+				target[0] += n[0]; target[1] += n[1]; target[2] += n[2];
+			}
+		}
+		for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+			const auto& n = accumulated[vertex_positions[i]];
+			const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			auto& normal = mesh.vertices[i].normal;
+			if (length > 0.0f) {
+				normal[0] = n[0] / length; normal[1] = n[1] / length; normal[2] = n[2] / length;
+			} else {
+				normal[0] = 0.0f; normal[1] = 1.0f; normal[2] = 0.0f;
+			}
+		}
+	}
+	return true;
+}
+
+// Tom Forsyth's linear-speed vertex cache optimisation
+namespace Forsyth {
+	static constexpr int CacheSize = 32;
+	static constexpr float CacheDecayPower = 1.5f;
+	static constexpr float LastTriScore = 0.75f;
+	static constexpr float ValenceBoostScale = 2.0f;
+	static constexpr float ValenceBoostPower = 0.5f;
+
+	static float VertexScore(const int cache_position, const uint32_t remaining_triangles) {
+		if (remaining_triangles == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cache_position >= 0) {
+			if (cache_position < 3) {
+				score = LastTriScore;
+			} else {
+				const float scaler = 1.0f / (CacheSize - 3);
+				score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scaler, CacheDecayPower);
+			}
+		}
+		return score + ValenceBoostScale * std::pow(static_cast<float>(remaining_triangles), -ValenceBoostPower);
+	}
+
+	static std::vector<uint32_t> Optimize(const std::vector<uint32_t>& indices, const size_t vertex_count) {
+		const size_t triangle_count = indices.size() / 3;
+
+		std::vector<uint32_t> remaining(vertex_count, 0);
+		for (const auto index : indices) {
+			++remaining[index];
+		}
+		std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+		for (size_t i = 0; i < vertex_count; ++i) {
+			adjacency_offsets[i + 1] = adjacency_offsets[i] + remaining[i];
+		}
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) {
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int> cache_positions(vertex_count, -1);
+		std::vector<float> vertex_scores(vertex_count);
+		for (size_t i = 0; i < vertex_count; ++i) {
+			vertex_scores[i] = VertexScore(-1, remaining[i]);
+		}
+		std::vector<float> triangle_scores(triangle_count);
+		std::vector<bool> emitted(triangle_count, false);
+		for (size_t t = 0; t < triangle_count; ++t) {
+			triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		std::vector<uint32_t> cache;
+		cache.reserve(CacheSize + 3);
+		size_t scan_position = 0;
+
+		int64_t best = -1;
+		float best_score = -1.0f;
+		for (size_t t = 0; t < triangle_count; ++t) {
+			if (triangle_scores[t] > best_score) {
+				best_score = triangle_scores[t];
+				best = static_cast<int64_t>(t);
+			}
+		}
+
+		while (best >= 0) {
+			emitted[best] = true;
+			std::vector<uint32_t> new_cache;
+			new_cache.reserve(CacheSize + 3);
+			for (size_t j = 0; j < 3; ++j) {
+				const uint32_t v = indices[best * 3 + j];
+				result.push_back(v);
+				new_cache.push_back(v);
+
+				// Remove the emitted triangle from the vertex's adjacency list
+				const uint32_t begin = adjacency_offsets[v];
+				const uint32_t end = begin + remaining[v];
+				for (uint32_t k = begin; k < end; ++k) {
+					if (adjacency[k] == static_cast<uint32_t>(best)) {
+						std::swap(adjacency[k], adjacency[end - 1]);
+						break;
+					}
+				}
+				--remaining[v];
+			}
+			for (const auto v : cache) {
+				if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end()) {
+					new_cache.push_back(v);
+				}
+			}
+
+			// Update the scores of everything that was touched, including vertices falling out of the cache
+			for (size_t i = 0; i < new_cache.size(); ++i) {
+				const uint32_t v = new_cache[i];
+				cache_positions[v] = i < CacheSize ? static_cast<int>(i) : -1;
+				vertex_scores[v] = VertexScore(cache_positions[v], remaining[v]);
+			}
+
+			// Evicted vertices lost their cache bonus, so their triangles are rescored as well
+			best = -1;
+			best_score = -1.0f;
+			for (const auto v : new_cache) {
+				for (uint32_t k = adjacency_offsets[v]; k < adjacency_offsets[v] + remaining[v]; ++k) {
+					const uint32_t t = adjacency[k];
+					triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+					if (triangle_scores[t] > best_score) {
+						best_score = triangle_scores[t];
+						best = t;
+					}
+				}
+			}
+			if (new_cache.size() > CacheSize) {
+				new_cache.resize(CacheSize);
+			}
+			cache = std::move(new_cache);
+
+			// Nothing adjacent to the cache, continue with the next unemitted triangle
+			if (best < 0) {
+				while (scan_position < triangle_count && emitted[scan_position]) {
+					++scan_position;
+				}
+				if (scan_position < triangle_count) {
+					best = static_cast<int64_t>(scan_position);
+				}
+			}
+		}
+		return result;
+	}
+}
+
+// Reorder the vertex buffer by first use so vertex fetches walk memory linearly
+static void ReorderVertices(SourceMesh& mesh) {
+	std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+	std::vector<SourceVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (auto& index : mesh.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+static uint16_t FloatToHalf(const float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return static_cast<uint16_t>(sign);
+		}
+		mantissa |= 0x800000;
+		const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		return static_cast<uint16_t>(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+	}
+	if (exponent >= 31) {
+		return static_cast<uint16_t>(sign | 0x7C00 | (((bits >> 23) & 0xFF) == 0xFF && mantissa != 0 ? 0x200 : 0));
+	}
+	// Round to nearest, an overflowing mantissa carries into the exponent
+	return static_cast<uint16_t>(sign | ((static_cast<uint32_t>(exponent) << 10) + ((mantissa + 0x1000) >> 13)));
+}
+
+static uint32_t PackSnorm10(const float value) {
+	const float clamped = std::clamp(value, -1.0f, 1.0f);
+	return static_cast<uint32_t>(static_cast<int32_t>(std::round(clamped * 511.0f))) & 0x3FF;
+}
+
+static void ComputeSphere(const SourceMesh& mesh, const uint32_t* indices, const size_t count, float* sphere) {
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (size_t i = 0; i < count; ++i) {
+		const float* p = mesh.vertices[indices[i]].position;
+		for (size_t j = 0; j < 3; ++j) {
+			min[j] = std::min(min[j], p[j]);
+			max[j] = std::max(max[j], p[j]);
+		}
+	}
+	float radius = 0.0f;
+	for (size_t j = 0; j < 3; ++j) {
+		sphere[j] = (min[j] + max[j]) * 0.5f;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		const float* p = mesh.vertices[indices[i]].position;
+		const float d[3] = { p[0] - sphere[0], p[1] - sphere[1], p[2] - sphere[2] };
+		radius = std::max(radius, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	}
+	sphere[3] = std::sqrt(radius);
+}
+
+static std::vector<MeshFormat::Meshlet> BuildMeshlets(const SourceMesh& mesh) {
+	std::vector<MeshFormat::Meshlet> meshlets;
+	std::unordered_set<uint32_t> unique;
+	MeshFormat::Meshlet current { };
+
+	const auto flush = [&] {
+		if (current.index_count > 0) {
+			current.vertex_count = static_cast<uint32_t>(unique.size());
+			ComputeSphere(mesh, mesh.indices.data() + current.index_offset, current.index_count, current.bounding_sphere);
+			meshlets.push_back(current);
+		}
+		current = { };
+		current.index_offset = meshlets.empty() ? 0 : meshlets.back().index_offset + meshlets.back().index_count;
+		unique.clear();
+	};
+
+	for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+		size_t new_vertices = 0;
+		for (size_t j = 0; j < 3; ++j) {
+			new_vertices += unique.contains(mesh.indices[i + j]) ? 0 : 1;
+		}
+		if (unique.size() + new_vertices > MeshFormat::MaxMeshletVertices ||
+			current.index_count / 3 + 1 > MeshFormat::MaxMeshletTriangles) {
+			flush();
+		}
+		for (size_t j = 0; j < 3; ++j) {
+			unique.insert(mesh.indices[i + j]);
+		}
+		current.index_count += 3;
+	}
+	flush();
+	return meshlets;
+}
+
+static uint32_t AlignOffset(const uint32_t offset) {
+	return (offset + 15) & ~15u;
+}
+
+static void WritePadding(std::ofstream& ofs, const uint32_t target) {
+	static constexpr char zeros[16] = { };
+	const auto position = static_cast<uint32_t>(ofs.tellp());
+	ofs.write(zeros, target - position);
+}
+
+static bool WriteMesh(const std::filesystem::path& path, const SourceMesh& mesh) {
+	MeshFormat::Header header { };
+	memcpy(header.identifier, MeshFormat::Identifier, sizeof(header.identifier));
+	header.version = MeshFormat::Version;
+	header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	header.index_count = static_cast<uint32_t>(mesh.indices.size());
+	header.vertex_stride = sizeof(MeshFormat::Vertex);
+	const bool wide_indices = mesh.vertices.size() > UINT16_MAX;
+	header.flags = wide_indices ? MeshFormat::FlagIndices32Bit : MeshFormat::FlagNone;
+
+	for (size_t j = 0; j < 3; ++j) {
+		header.bounds_min[j] = INFINITY;
+		header.bounds_max[j] = -INFINITY;
+	}
+	for (const auto& vertex : mesh.vertices) {
+		for (size_t j = 0; j < 3; ++j) {
+			header.bounds_min[j] = std::min(header.bounds_min[j], vertex.position[j]);
+			header.bounds_max[j] = std::max(header.bounds_max[j], vertex.position[j]);
+		}
+	}
+	for (size_t j = 0; j < 3; ++j) {
+		header.position_offset[j] = header.bounds_min[j];
+		header.position_scale[j] = header.bounds_max[j] - header.bounds_min[j];
+	}
+	ComputeSphere(mesh, mesh.indices.data(), mesh.indices.size(), header.bounding_sphere);
+
+	std::vector<MeshFormat::Vertex> vertices(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		const auto& source = mesh.vertices[i];
+		auto& vertex = vertices[i];
+		for (size_t j = 0; j < 3; ++j) {
+			const float normalized = header.position_scale[j] > 0.0f ?
+				(source.position[j] - header.position_offset[j]) / header.position_scale[j] : 0.0f;
+			vertex.position[j] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+		}
+		vertex.position[3] = 0;
+		vertex.normal = PackSnorm10(source.normal[0]) | (PackSnorm10(source.normal[1]) << 10) | (PackSnorm10(source.normal[2]) << 20);
+		vertex.uv[0] = FloatToHalf(source.uv[0]);
+		vertex.uv[1] = FloatToHalf(source.uv[1]);
+	}
+
+	const auto meshlets = BuildMeshlets(mesh);
+	header.meshlet_count = static_cast<uint32_t>(meshlets.size());
+
+	const size_t index_size = wide_indices ? 4 : 2;
+	header.vertex_data_offset = AlignOffset(sizeof(header));
+	header.index_data_offset = AlignOffset(header.vertex_data_offset + static_cast<uint32_t>(vertices.size() * sizeof(MeshFormat::Vertex)));
+	header.meshlet_data_offset = AlignOffset(header.index_data_offset + static_cast<uint32_t>(mesh.indices.size() * index_size));
+
+	std::ofstream ofs(path, std::ios::binary);
+	if (!ofs.is_open()) {
+		std::println("Failed to open output file \"{}\"", path.string());
+		return false;
+	}
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	WritePadding(ofs, header.vertex_data_offset);
+	ofs.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(MeshFormat::Vertex)));
+	WritePadding(ofs, header.index_data_offset);
+	if (wide_indices) {
+		ofs.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+	} else {
+		std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+		ofs.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint16_t)));
+	}
+	WritePadding(ofs, header.meshlet_data_offset);
+	ofs.write(reinterpret_cast<const char*>(meshlets.data()), static_cast<std::streamsize>(meshlets.size() * sizeof(MeshFormat::Meshlet)));
+
+	std::println("Written \"{}\": {} vertices, {} triangles, {} meshlets",
+		path.string(), header.vertex_count, header.index_count / 3, header.meshlet_count
+	);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "--help") == 0 || strcasecmp(argv[1], "-h") == 0) {
+			std::println("GMdl v{}.{}", GMDL_VERSION_MAJOR, GMDL_VERSION_MINOR);
+			std::println(
+				"Usage:\n"
+				"gmdl --help|-h    ==> Show help message\n"
+				"gmdl --version|-v ==> Show tool version\n"
+				"gmdl --input <path> --output <path> ==> Cook a Wavefront OBJ file into a .gmdl mesh"
+			);
+			return 0;
+		}
+		if (strcasecmp(argv[1], "--version") == 0 || strcasecmp(argv[1], "-v") == 0) {
+			std::println("GMdl v{}.{}", GMDL_VERSION_MAJOR, GMDL_VERSION_MINOR);
+			return 0;
+		}
+	}
+	if (argc != 5) {
+		std::println("Expected --input <path> --output <path>, see --help");
+		return 1;
+	}
+
+	std::filesystem::path input_path;
+	std::filesystem::path output_path;
+	for (int i = 1; i < argc; i += 2) {
+		if (strcasecmp(argv[i], "--input") == 0 || strcasecmp(argv[i], "-i") == 0) {
+			input_path = argv[i + 1];
+		} else if (strcasecmp(argv[i], "--output") == 0 || strcasecmp(argv[i], "-o") == 0) {
+			output_path = argv[i + 1];
+		} else {
+			std::println("Invalid argument: {}", argv[i]);
+			return 1;
+		}
+	}
+	if (input_path.empty() || output_path.empty()) {
+		std::println("Both input and output paths are required");
+		return 1;
+	}
+
+	SourceMesh mesh;
+	if (!LoadObj(input_path, mesh)) {
+		return 1;
+	}
+	mesh.indices = Forsyth::Optimize(mesh.indices, mesh.vertices.size());
+	ReorderVertices(mesh);
+	return WriteMesh(output_path, mesh) ? 0 : 1;
+}
\ No newline at end of file
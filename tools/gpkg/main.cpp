@@ -88,13 +88,13 @@ int main(int argc, char** argv) {
 
 	std::unordered_map<std::string, std::filesystem::path> entries;
 
-	uint32_t data_origin = 10;
+	uint32_t data_origin = 14;
 	for (const auto& entry : std::filesystem::recursive_directory_iterator(input_path)) {
 		auto entry_path = entry.path();
 		auto name = std::filesystem::relative(entry_path, input_path).string();
 		if (std::filesystem::is_regular_file(entry_path)) {
 			entries.emplace(name, entry_path);
-			data_origin += 9 + name.size();
+			data_origin += 10 + name.size();
 		}
 	}
 	const uint32_t entry_count = entries.size();
@@ -120,8 +120,8 @@ int main(int argc, char** argv) {
 		uint32_t size = ifs.tellg();
 		ifs.seekg(0, std::ios::beg);
 
-		data_result.resize(data_result.capacity() + size);
-		ifs.read(reinterpret_cast<char*>(data_result.data()), size);
+		data_result.resize(origin + size);
+		ifs.read(reinterpret_cast<char*>(data_result.data() + origin), size);
 
 		ifs.close();
 
@@ -0,0 +1,227 @@
+#include <print>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "gctk_math.hpp"
+
+#ifdef _WIN32
+#define strcasecmp stricmp
+#endif
+
+using namespace gctk;
+
+// Scalar versions of the math kernels, multiply is the implementation Matrix4 had before the SIMD backend
+namespace Reference {
+	static Matrix4 Multiply(const Matrix4& a, const Matrix4& b) {
+		return Matrix4 {
+			a.column0.dot(b.row(0)), a.column0.dot(b.row(1)), a.column0.dot(b.row(2)), a.column0.dot(b.row(3)),
+			a.column1.dot(b.row(0)), a.column1.dot(b.row(1)), a.column1.dot(b.row(2)), a.column1.dot(b.row(3)),
+			a.column2.dot(b.row(0)), a.column2.dot(b.row(1)), a.column2.dot(b.row(2)), a.column2.dot(b.row(3)),
+			a.column3.dot(b.row(0)), a.column3.dot(b.row(1)), a.column3.dot(b.row(2)), a.column3.dot(b.row(3))
+		};
+	}
+	static Vector4 Transform(const Matrix4& m, const Vector4& v) {
+		return Vector4 { m.column0.dot(v), m.column1.dot(v), m.column2.dot(v), m.column3.dot(v) };
+	}
+	// Gauss-Jordan elimination with partial pivoting
+	static Matrix4 Inverse(const Matrix4& m) {
+		float a[4][8];
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				a[i][j] = m.item(i * 4 + j);
+				a[i][j + 4] = i == j ? 1.0f : 0.0f;
+			}
+		}
+		for (int c = 0; c < 4; c++) {
+			int pivot = c;
+			for (int r = c + 1; r < 4; r++) {
+				if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) {
+					pivot = r;
+				}
+			}
+			for (int j = 0; j < 8; j++) {
+				std::swap(a[c][j], a[pivot][j]);
+			}
+			const float inv = 1.0f / a[c][c];
+			for (int j = 0; j < 8; j++) {
+				a[c][j] *= inv;
+			}
+			for (int r = 0; r < 4; r++) {
+				if (r == c) {
+					continue;
+				}
+				const float f = a[r][c];
+				for (int j = 0; j < 8; j++) {
+					a[r][j] -= f * a[c][j];
+				}
+			}
+		}
+		return Matrix4 {
+			a[0][4], a[0][5], a[0][6], a[0][7],
+			a[1][4], a[1][5], a[1][6], a[1][7],
+			a[2][4], a[2][5], a[2][6], a[2][7],
+			a[3][4], a[3][5], a[3][6], a[3][7]
+		};
+	}
+	static Quaternion Multiply(const Quaternion& a, const Quaternion& b) {
+		return Quaternion {
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		};
+	}
+}
+
+static float MaxError(const Matrix4& a, const Matrix4& b) {
+	float error = 0.0f;
+	for (size_t i = 0; i < 16; i++) {
+		error = std::max(error, std::fabs(a.item(i) - b.item(i)));
+	}
+	return error;
+}
+static float MaxError(const Vector4& a, const Vector4& b) {
+	return std::max({ std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z), std::fabs(a.w - b.w) });
+}
+static float MaxError(const Quaternion& a, const Quaternion& b) {
+	return MaxError(Vector4 { a.x, a.y, a.z, a.w }, Vector4 { b.x, b.y, b.z, b.w });
+}
+
+// Runs fn over every element count times and returns nanoseconds per call
+template<typename Fn>
+static double Measure(const size_t elements, const int iterations, Fn&& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		fn();
+	}
+	const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / (static_cast<double>(elements) * iterations);
+}
+
+static void Report(const char* name, const double reference, const double simd, const float error) {
+	std::println("{:<22} {:>9.2f} ns {:>9.2f} ns {:>7.2f}x   max error {:.2e}", name, reference, simd, reference / simd, error);
+}
+
+int main(int argc, char** argv) {
+	size_t count = 4096;
+	int iterations = 500;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcasecmp(argv[i], "--count") == 0 || strcasecmp(argv[i], "-c") == 0) {
+			count = std::strtoul(argv[i + 1], nullptr, 10);
+		} else if (strcasecmp(argv[i], "--iterations") == 0 || strcasecmp(argv[i], "-i") == 0) {
+			iterations = std::atoi(argv[i + 1]);
+		} else {
+			std::println("Invalid argument: {}", argv[i]);
+			return 1;
+		}
+	}
+
+#if defined(GCTK_SIMD_SSE) && defined(GCTK_SIMD_FMA)
+	std::println("Backend: SSE + FMA");
+#elif defined(GCTK_SIMD_SSE)
+	std::println("Backend: SSE");
+#elif defined(GCTK_SIMD_NEON)
+	std::println("Backend: NEON");
+#else
+	std::println("Backend: scalar");
+#endif
+	std::println("{} elements, {} iterations\n", count, iterations);
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	const auto random_matrix = [&] {
+		// Rotation, scale and translation, so every matrix is well conditioned and invertible
+		const Quaternion q = Quaternion { dist(rng), dist(rng), dist(rng), dist(rng) }.normalized();
+		Matrix4 m = Matrix4::CreateFromQuaternion(q);
+		const float scale = 1.5f + dist(rng);
+		m.column0 = m.column0 * scale;
+		m.column1 = m.column1 * scale;
+		m.column2 = m.column2 * scale;
+		m.column0.w = dist(rng) * 10.0f;
+		m.column1.w = dist(rng) * 10.0f;
+		m.column2.w = dist(rng) * 10.0f;
+		return m;
+	};
+
+	std::vector<Matrix4> a, b, out(count), reference_out(count);
+	std::vector<Vector4> vectors, vector_out(count), reference_vector_out(count);
+	std::vector<Quaternion> qa, qb, quat_out(count), reference_quat_out(count);
+	for (size_t i = 0; i < count; i++) {
+		a.push_back(random_matrix());
+		b.push_back(random_matrix());
+		vectors.emplace_back(dist(rng), dist(rng), dist(rng), 1.0f);
+		qa.push_back(Quaternion { dist(rng), dist(rng), dist(rng), dist(rng) }.normalized());
+		qb.push_back(Quaternion { dist(rng), dist(rng), dist(rng), dist(rng) }.normalized());
+	}
+
+	std::println("{:<22} {:>12} {:>12} {:>8}", "", "reference", "simd", "speedup");
+
+	double reference = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) reference_out[i] = Reference::Multiply(a[i], b[i]);
+	});
+	double simd = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) out[i] = a[i] * b[i];
+	});
+	float error = 0.0f;
+	for (size_t i = 0; i < count; i++) error = std::max(error, MaxError(out[i], reference_out[i]));
+	Report("Matrix4 multiply", reference, simd, error);
+
+	reference = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) reference_vector_out[i] = Reference::Transform(a[i], vectors[i]);
+	});
+	simd = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) vector_out[i] = a[i] * vectors[i];
+	});
+	error = 0.0f;
+	for (size_t i = 0; i < count; i++) error = std::max(error, MaxError(vector_out[i], reference_vector_out[i]));
+	Report("Matrix4 transform", reference, simd, error);
+
+	reference = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) reference_out[i] = Reference::Inverse(a[i]);
+	});
+	simd = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) out[i] = a[i].inverse();
+	});
+	// Both inverses carry float rounding, so the error is the distance of M * inverse(M) from identity
+	error = 0.0f;
+	for (size_t i = 0; i < count; i++) error = std::max(error, MaxError(a[i] * out[i], Matrix4::IDENTITY));
+	Report("Matrix4 inverse", reference, simd, error);
+
+	reference = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) reference_quat_out[i] = Reference::Multiply(qa[i], qb[i]);
+	});
+	simd = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) quat_out[i] = qa[i].multiply(qb[i]);
+	});
+	error = 0.0f;
+	for (size_t i = 0; i < count; i++) error = std::max(error, MaxError(quat_out[i], reference_quat_out[i]));
+	Report("Quaternion multiply", reference, simd, error);
+
+	// Random numbers against std::mt19937, the error is how far the mean of the last batch is from 0.5
+	std::vector<float> floats(count), reference_floats(count);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	Random random(1234);
+	const auto mean_error = [](const std::vector<float>& values) {
+		double sum = 0.0;
+		for (const float v : values) sum += v;
+		return static_cast<float>(std::abs(sum / static_cast<double>(values.size()) - 0.5));
+	};
+	reference = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) reference_floats[i] = unit(rng);
+	});
+	simd = Measure(count, iterations, [&] {
+		for (size_t i = 0; i < count; i++) floats[i] = random.next_float(0.0f, 1.0f);
+	});
+	Report("Random next_float", reference, simd, mean_error(floats));
+
+	simd = Measure(count, iterations, [&] {
+		random.fill_floats(floats);
+	});
+	Report("Random fill_floats", reference, simd, mean_error(floats));
+
+	return 0;
+}
\ No newline at end of file